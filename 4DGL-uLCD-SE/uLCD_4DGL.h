@@ -258,6 +258,7 @@ public :
     int  read_pixel(int, int);
     void pen_size(char);
     void BLIT(int x, int y, int w, int h, int *colors);
+    void BLIT565(int x, int y, int w, int h, const char *pixels);
 
 // Text Commands
     void set_font(char);
@@ -289,6 +290,9 @@ public :
     void display_video(int, int);
     void display_frame(int, int, int);
 
+// Serial traffic: bytes sent to the screen since it was created
+    unsigned int tx_bytes;
+
 // Screen Data
     int type;
     int revision;
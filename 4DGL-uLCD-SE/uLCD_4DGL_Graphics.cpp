@@ -259,6 +259,26 @@ void uLCD_4DGL :: BLIT(int x, int y, int w, int h, int *colors)     // draw a bl
     pc.printf("   Answer received : %d\n",resp);
 #endif
 
+}
+//******************************************************************************************************
+void uLCD_4DGL :: BLIT565(int x, int y, int w, int h, const char *pixels)     // draw a block of RGB565 pixels, high byte first
+{
+    writeBYTEfast('\x00');
+    writeBYTEfast(BLITCOM);
+    writeBYTEfast((x >> 8) & 0xFF);
+    writeBYTEfast(x & 0xFF);
+    writeBYTEfast((y >> 8) & 0xFF);
+    writeBYTEfast(y & 0xFF);
+    writeBYTEfast((w >> 8) & 0xFF);
+    writeBYTE(w & 0xFF);
+    writeBYTE((h >> 8) & 0xFF);
+    writeBYTE(h & 0xFF);
+    wait_ms(1);
+    for (int i=0; i<w*h*2; i++) {
+        writeBYTEfast(pixels[i]);                      // already in the screen's format
+    }
+    while (!_cmd.readable()) wait_ms(TEMPO);              // wait for screen answer
+    if (_cmd.readable()) _cmd.getc();                  // ACK or NAK
 }
 //******************************************************************************************************
 int uLCD_4DGL :: read_pixel(int x, int y)   // read screen info and populate data
@@ -19,6 +19,7 @@
 
 #include "mbed.h"
 #include "uLCD_4DGL.h"
+#include "profile_public.h"
 
 #define ARRAY_SIZE(X) sizeof(X)/sizeof(X[0])
 
@@ -33,6 +34,7 @@ uLCD_4DGL :: uLCD_4DGL(PinName tx, PinName rx, PinName rst) : _cmd(tx, rx),
 #endif // DEBUGMODE
 {
     // Constructor
+    tx_bytes = 0;
     _cmd.baud(9600);
 #if DEBUGMODE
     pc.baud(115200);
@@ -61,6 +63,7 @@ void uLCD_4DGL :: writeBYTE(char c)   // send a BYTE command to screen
 {
 
     _cmd.putc(c);
+    tx_bytes++;
     wait_us(500);  //mbed is too fast for LCD at high baud rates in some long commands
 
 #if DEBUGMODE
@@ -74,6 +77,7 @@ void uLCD_4DGL :: writeBYTEfast(char c)   // send a BYTE command to screen
 {
 
     _cmd.putc(c);
+    tx_bytes++;
     //wait_ms(0.0);  //mbed is too fast for LCD at high baud rates - but not in short commands
 
 #if DEBUGMODE
@@ -97,6 +101,7 @@ int uLCD_4DGL :: writeCOMMAND(char *command, int number)   // send several BYTES
     pc.printf("New COMMAND : 0x%02X\n", command[0]);
 #endif
     int i, resp = 0;
+    PROFILE_BEGIN(start);
     freeBUFFER();
     writeBYTE(0xFF);
     for (i = 0; i < number; i++) {
@@ -118,6 +123,7 @@ int uLCD_4DGL :: writeCOMMAND(char *command, int number)   // send several BYTES
             resp =  0;                                 // else return   0
             break;
     }
+    PROFILE_END(start, profile_lcd_zone(command[0]));
 #if DEBUGMODE
     pc.printf("   Answer received : %d\n",resp);
 #endif
@@ -145,6 +151,7 @@ int uLCD_4DGL :: writeCOMMANDnull(char *command, int number)   // send several B
     pc.printf("New COMMAND : 0x%02X\n", command[0]);
 #endif
     int i, resp = 0;
+    PROFILE_BEGIN(start);
     freeBUFFER();
     writeBYTE(0x00); //command has a null prefix byte
     for (i = 0; i < number; i++) {
@@ -166,6 +173,7 @@ int uLCD_4DGL :: writeCOMMANDnull(char *command, int number)   // send several B
             resp =  0;                                 // else return   0
             break;
     }
+    PROFILE_END(start, PROFILE_LCD_STRING);
 #if DEBUGMODE
     pc.printf("   Answer received : %d\n",resp);
 #endif
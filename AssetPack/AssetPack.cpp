@@ -0,0 +1,146 @@
+#include "mbed.h"
+#include <string.h>
+#include "mbed_debug.h"
+
+#include "AssetPack.h"
+
+#define ASSET_DBG 0
+
+AssetPack::AssetPack(const char *name) : FileSystemLike(name) {
+    _pack = NULL;
+    _index = NULL;
+    _count = 0;
+}
+
+AssetPack::~AssetPack() {
+    unload();
+}
+
+int AssetPack::load(FileSystemLike *fs, const char *path) {
+    unload();
+    _pack = fs->open(path, O_RDONLY);
+    if (_pack == NULL) {
+        debug_if(ASSET_DBG, "AssetPack: can't open %s\n", path);
+        return -1;
+    }
+    ASSET_PACK_HEADER header;
+    if (_pack->read(&header, sizeof(header)) != sizeof(header) ||
+        header.magic != ASSET_PACK_MAGIC || header.version != ASSET_PACK_VERSION ||
+        header.data < sizeof(header) + header.count * sizeof(ASSET_ENTRY)) {
+        debug_if(ASSET_DBG, "AssetPack: %s is not a pack\n", path);
+        unload();
+        return -1;
+    }
+    _index = new ASSET_ENTRY[header.count];
+    size_t bytes = header.count * sizeof(ASSET_ENTRY);
+    if (_pack->read(_index, bytes) != (ssize_t)bytes) {
+        unload();
+        return -1;
+    }
+    _count = header.count;
+    debug_if(ASSET_DBG, "AssetPack: %s has %d assets\n", path, _count);
+    return 0;
+}
+
+void AssetPack::unload() {
+    if (_pack) {
+        _pack->close();
+        _pack = NULL;
+    }
+    delete[] _index;
+    _index = NULL;
+    _count = 0;
+}
+
+const ASSET_ENTRY *AssetPack::find(const char *name) {
+    int lo = 0, hi = _count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        int cmp = strncmp(name, _index[mid].name, ASSET_NAME_LEN);
+        if (cmp == 0) {
+            return &_index[mid];
+        }
+        if (cmp < 0) {
+            hi = mid - 1;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return NULL;
+}
+
+int AssetPack::read(const ASSET_ENTRY *asset, uint32_t offset, void *buffer, uint32_t length) {
+    if (_pack == NULL) {
+        return -1;
+    }
+    if (offset >= asset->size) {
+        return 0;
+    }
+    if (length > asset->size - offset) {
+        length = asset->size - offset;
+    }
+    if (_pack->lseek(asset->offset + offset, SEEK_SET) < 0) {
+        return -1;
+    }
+    return _pack->read(buffer, length);
+}
+
+FileHandle *AssetPack::open(const char *filename, int flags) {
+    if (flags & (O_WRONLY | O_RDWR)) {
+        return NULL;
+    }
+    const ASSET_ENTRY *asset = find(filename);
+    if (asset == NULL) {
+        debug_if(ASSET_DBG, "AssetPack: no asset %s\n", filename);
+        return NULL;
+    }
+    return new AssetHandle(this, asset);
+}
+
+AssetHandle::AssetHandle(AssetPack *pack, const ASSET_ENTRY *asset) {
+    _pack = pack;
+    _asset = *asset;
+    _pos = 0;
+}
+
+int AssetHandle::close() {
+    delete this;
+    return 0;
+}
+
+ssize_t AssetHandle::write(const void* buffer, size_t length) {
+    return -1;
+}
+
+ssize_t AssetHandle::read(void* buffer, size_t length) {
+    int n = _pack->read(&_asset, _pos, buffer, length);
+    if (n > 0) {
+        _pos += n;
+    }
+    return n;
+}
+
+int AssetHandle::isatty() {
+    return 0;
+}
+
+off_t AssetHandle::lseek(off_t position, int whence) {
+    if (whence == SEEK_END) {
+        position += _asset.size;
+    } else if (whence == SEEK_CUR) {
+        position += _pos;
+    }
+    if (position < 0 || position > (off_t)_asset.size) {
+        return -1;
+    }
+    _pos = position;
+    return _pos;
+}
+
+int AssetHandle::fsync() {
+    return 0;
+}
+
+off_t AssetHandle::flen() {
+    return _asset.size;
+}
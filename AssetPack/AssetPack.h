@@ -0,0 +1,92 @@
+#ifndef MBED_ASSETPACK_H
+#define MBED_ASSETPACK_H
+
+#include "mbed.h"
+#include "FileSystemLike.h"
+#include "FileHandle.h"
+#include "AssetPackFormat.h"
+
+using namespace mbed;
+
+/** All the game's assets in one file, packed by tools/asset_pack
+ *
+ * The pack is opened once and its index read into RAM. After that, opening
+ * an asset is a binary search of the index: no directory lookup and no
+ * f_open(). Each asset starts on a sector boundary of the pack, so whole
+ * sector reads go straight from the card into the caller's buffer.
+ *
+ * The pack is also a file system: once loaded, assets open with
+ * fopen("/<name>/<asset>", "r") and play through wave_player like loose
+ * files. All the open assets share the pack's file handle; each read seeks
+ * it first, which is cheap with FATFileSystem::fast_seek() on.
+ *
+ * @code
+ * SDFileSystem sd(p5, p6, p7, p8, "sd");
+ * AssetPack pak("pak");
+ *
+ * sd.fast_seek(1);
+ * pak.load(&sd, "assets.pak");
+ * FILE *wav = fopen("/pak/BUZZER.wav", "r");
+ * @endcode
+ */
+class AssetPack : public FileSystemLike {
+public:
+
+    /** Create an empty pack, mounted as name */
+    AssetPack(const char *name);
+    virtual ~AssetPack();
+
+    /** Open a pack file and read its index
+     *
+     * @param fs the file system the pack is on
+     * @param path path of the pack on fs, without the mount name
+     * @returns 0 on success
+     */
+    int load(FileSystemLike *fs, const char *path);
+
+    /** Close the pack; assets still open fail to read after this */
+    void unload();
+
+    /** Look up an asset
+     *
+     * @returns its index entry, or NULL
+     */
+    const ASSET_ENTRY *find(const char *name);
+
+    /** Read part of an asset
+     *
+     * @returns the number of bytes read, or -1 on error
+     */
+    int read(const ASSET_ENTRY *asset, uint32_t offset, void *buffer, uint32_t length);
+
+    int count() { return _count; }
+    const ASSET_ENTRY *entry(int i) { return i >= 0 && i < _count ? &_index[i] : NULL; }
+
+    virtual FileHandle *open(const char *filename, int flags);
+
+protected:
+    FileHandle *_pack;
+    ASSET_ENTRY *_index;
+    int _count;
+};
+
+/** An asset opened through AssetPack::open() */
+class AssetHandle : public FileHandle {
+public:
+
+    AssetHandle(AssetPack *pack, const ASSET_ENTRY *asset);
+    virtual int close();
+    virtual ssize_t write(const void* buffer, size_t length);
+    virtual ssize_t read(void* buffer, size_t length);
+    virtual int isatty();
+    virtual off_t lseek(off_t position, int whence);
+    virtual int fsync();
+    virtual off_t flen();
+
+protected:
+    AssetPack *_pack;
+    ASSET_ENTRY _asset;
+    uint32_t _pos;
+};
+
+#endif
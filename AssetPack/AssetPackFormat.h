@@ -0,0 +1,37 @@
+#ifndef MBED_ASSETPACKFORMAT_H
+#define MBED_ASSETPACKFORMAT_H
+
+// The pack file layout, shared by AssetPack and tools/asset_pack.  All
+// fields are little endian.
+
+#include <stdint.h>
+
+#define ASSET_PACK_MAGIC    0x4B415041  // "APAK"
+#define ASSET_PACK_VERSION  1
+#define ASSET_NAME_LEN      32
+
+/** Asset types; the data is stored the way the device uses it */
+enum {
+    ASSET_RAW = 0,      ///< bytes as given to the packer
+    ASSET_WAVE = 1,     ///< a wave file, mono at the DAC rate unless ADPCM; info is the sample rate
+    ASSET_SPRITE = 2,   ///< RGB565 pixels, big endian as the uLCD takes them; info is width | height << 16
+};
+
+/** Pack header, at the start of the pack */
+typedef struct {
+    uint32_t magic;         ///< ASSET_PACK_MAGIC
+    uint32_t version;       ///< ASSET_PACK_VERSION
+    uint32_t count;         ///< entries in the index that follows
+    uint32_t data;          ///< offset of the first asset, past the index
+} ASSET_PACK_HEADER;
+
+/** Index entry; the index is sorted by name with strcmp() */
+typedef struct {
+    char name[ASSET_NAME_LEN];  ///< NUL terminated
+    uint32_t offset;            ///< from the start of the pack, a multiple of 512
+    uint32_t size;              ///< bytes
+    uint32_t type;              ///< ASSET_RAW, ASSET_WAVE or ASSET_SPRITE
+    uint32_t info;
+} ASSET_ENTRY;
+
+#endif
@@ -28,10 +28,26 @@ extern Serial pc;
 #define MMA8452_DBG(...)
 #endif
 
+#if defined(TARGET_LPC176X) && defined(LPC_I2C2)
+// I2CONSET and I2CONCLR bits
+#define I2C_AA   0x04
+#define I2C_SI   0x08
+#define I2C_STO  0x10
+#define I2C_STA  0x20
+
+MMA8452 *MMA8452::_i2cOwner = NULL;
+#endif
+
 // Connect module at I2C address using I2C port pins sda and scl
-MMA8452::MMA8452(PinName sda, PinName scl, int frequency) : _i2c(sda, scl) , _frequency(frequency) {
+MMA8452::MMA8452(PinName sda, PinName scl, int frequency) : _i2c(sda, scl) , _sda(sda), _frequency(frequency) {
    MMA8452_DBG("Creating MMA8452");
    
+   // no background sampling until startSampling
+   _int1 = NULL;
+   _busy = 0;
+   _paused = 0;
+   _stalled = 0;
+   
    // set I2C frequency
    _i2c.frequency(_frequency);
    
@@ -50,7 +66,16 @@ MMA8452::MMA8452(PinName sda, PinName scl, int frequency) : _i2c(sda, scl) , _fr
 
 
 // Destroys instance
-MMA8452::~MMA8452() {}
+MMA8452::~MMA8452() {
+   stopSampling();
+}
+
+void MMA8452::setFrequency(int frequency) {
+   pauseSampling();
+   _frequency = frequency;
+   _i2c.frequency(_frequency);
+   resumeSampling();
+}
 
 // Setting the control register bit 1 to true to activate the MMA8452
 int MMA8452::activate() {
@@ -118,13 +143,32 @@ int MMA8452::setDataRate(DataRateHz dataRate, int toggleActivation) {
 }
 
 int MMA8452::setBitDepth(BitDepth depth,int toggleActivation) {
+   // background reads follow the new sample size, and the average restarts in the new counts
+   pauseSampling();
    _bitDepth = depth;
-   return maskAndApplyRegister(
+   _rxLen = 3;
+   if(_bitDepth==BIT_DEPTH_12) {
+      _rxLen = 6;
+   }
+   _haveSample = 0;
+   int rval = maskAndApplyRegister(
       MMA8452_CTRL_REG_1,
       MMA8452_BIT_DEPTH_MASK,
       depth<<MMA8452_BIT_DEPTH_MASK_SHIFT,
       toggleActivation
    );
+   resumeSampling();
+   return rval;
+}
+
+int MMA8452::setLowLatency(DataRateHz rate) {
+   if(standby() ||
+      setBitDepth(BIT_DEPTH_8,0) ||
+      setDataRate(rate,0) ||
+      activate()) {
+      return 1;
+   }
+   return 0;
 }
 
 char MMA8452::getMaskedRegister(int addr, char mask) {
@@ -317,6 +361,19 @@ int MMA8452::readXYZGravity(double *x, double *y, double *z) {
    return 0;
 }
 
+int MMA8452::readXYZMilliG(int *x, int *y, int *z) {
+   int xCount = 0, yCount = 0, zCount = 0;
+   if(readXYZCounts(&xCount,&yCount,&zCount)) {
+      return 1;
+   }
+   int countsPerG = getCountsPerG();
+   
+   *x = xCount*1000/countsPerG;
+   *y = yCount*1000/countsPerG;
+   *z = zCount*1000/countsPerG;
+   return 0;
+}
+
 int MMA8452::readXGravity(double *x) {
    int xCount = 0;
    if(readXCount(&xCount)) {
@@ -400,7 +457,10 @@ int MMA8452::writeRegister(char addr, char data) {
     char buf[2] = {0,0};
     buf[0] = addr;
     buf[1] = data;
-    return _i2c.write(MMA8452_ADDRESS, buf,2);
+    pauseSampling();
+    int rval = _i2c.write(MMA8452_ADDRESS, buf,2);
+    resumeSampling();
+    return rval;
     // note, could also do return writeRegister(addr,&data,1);
 }
 
@@ -422,29 +482,34 @@ int MMA8452::writeRegister(char addr, char *data, int nbytes) {
     // writing multiple bytes is a little bit annoying because
     // the I2C library doesn't support sending the address separately
     // so we just do it manually
+    pauseSampling();
+    int rval = 1;
     
     // 1. tell I2C bus to start transaction
     _i2c.start();
     // 2. tell slave we want to write (slave address & write flag)
-    if(_i2c.write(_writeAddress)!=1) {
-       return 1;
-    }
     // 3. send the write address
-    if(_i2c.write(addr)!=1) {
-       return 1;
-    }
-    // 4. send the data to write
-    for(int i=0; i<nbytes; i++) {
-       if(_i2c.write(data[i])!=1) {
-          return 1;
+    if(_i2c.write(_writeAddress)==1 && _i2c.write(addr)==1) {
+       // 4. send the data to write
+       rval = 0;
+       for(int i=0; i<nbytes && !rval; i++) {
+          rval = _i2c.write(data[i])!=1;
        }
     }
     // 5. tell I2C bus to end transaction
     _i2c.stop();
-    return 0;
+    resumeSampling();
+    return rval;
 }
 
 int MMA8452::readRegister(char addr, char *dst, int nbytes) {
+    pauseSampling();
+    int rval = transferRead(addr,dst,nbytes);
+    resumeSampling();
+    return rval;
+}
+
+int MMA8452::transferRead(char addr, char *dst, int nbytes) {
     // this is a bit odd, but basically proceeds like this
     // 1. Send a start command
     // 2. Tell the slave we want to write (slave address & write flag)
@@ -466,6 +531,332 @@ int MMA8452::readRegister(char addr, char *dst) {
     return readRegister(addr,dst,1);
 }
 
+// Background sampling. INT1 falls when a sample is ready and rises once it
+// has been read, so dataReady() starts a read on the falling edge and, after
+// a pause, on the level. On the LPC1768 the read runs in i2cIRQ(), a state
+// per byte, with the I2C interrupt enabled only while it is in progress so
+// the mbed I2C functions poll the same block undisturbed the rest of the time.
+int MMA8452::startSampling(PinName int1, DataRateHz rate, int smoothing) {
+   stopSampling();
+   if(_bitDepth==BIT_DEPTH_UNKNOWN) {
+      return 1;
+   }
+   _smoothing = smoothing;
+   _ringHead = _ringTail = 0;
+   _haveSample = 0;
+   _retries = 0;
+   _stalled = 0;
+   memset(&_stats,0,sizeof(_stats));
+   
+   // the interrupt registers can only be written in standby
+   if(standby() ||
+      setDataRate(rate,0) ||
+      logicalORRegister(MMA8452_CTRL_REG_4,MMA8452_INT_EN_DRDY) ||
+      logicalORRegister(MMA8452_CTRL_REG_5,MMA8452_INT_CFG_DRDY)) {
+      return 1;
+   }
+   
+   #if defined(TARGET_LPC176X) && defined(LPC_I2C2)
+   // the I2C blocks on mbed pins; anything else reads from the pin interrupt
+   switch(_sda) {
+      case p9:
+         _i2cRegs = LPC_I2C1;
+         _i2cIRQn = I2C1_IRQn;
+      break;
+      case p28:
+         _i2cRegs = LPC_I2C2;
+         _i2cIRQn = I2C2_IRQn;
+      break;
+      default:
+         _i2cRegs = NULL;
+      break;
+   }
+   if(_i2cRegs) {
+      NVIC_DisableIRQ(_i2cIRQn);
+      NVIC_SetVector(_i2cIRQn,(uint32_t)&MMA8452::i2cIRQ);
+      _i2cOwner = this;
+   }
+   #endif
+   
+   _int1 = new InterruptIn(int1);
+   _int1->fall(this,&MMA8452::dataReady);
+   
+   // activating pauses and resumes, which picks up INT1 if it is already low
+   if(activate()) {
+      stopSampling();
+      return 1;
+   }
+   return 0;
+}
+
+void MMA8452::stopSampling() {
+   if(_int1==NULL) {
+      return;
+   }
+   pauseSampling();
+   delete _int1;
+   _int1 = NULL;
+   _paused = 0;
+   _stalled = 0;
+   #if defined(TARGET_LPC176X) && defined(LPC_I2C2)
+   if(_i2cRegs && _i2cOwner==this) {
+      NVIC_DisableIRQ(_i2cIRQn);
+      _i2cOwner = NULL;
+   }
+   #endif
+   maskAndApplyRegister(MMA8452_CTRL_REG_4,~MMA8452_INT_EN_DRDY,0,1);
+}
+
+int MMA8452::readSample(Sample *s) {
+   int rval = 1;
+   restartStalled();
+   __disable_irq();
+   if(_ringTail!=_ringHead) {
+      *s = _ring[_ringTail];
+      _ringTail = (_ringTail+1)&(MMA8452_RING_SIZE-1);
+      rval = 0;
+   }
+   __enable_irq();
+   return rval;
+}
+
+int MMA8452::readFilteredCounts(int *x, int *y, int *z) {
+   restartStalled();
+   if(!_haveSample) {
+      return 1;
+   }
+   __disable_irq();
+   int32_t fx = _filtered[0], fy = _filtered[1], fz = _filtered[2];
+   __enable_irq();
+   // round to the nearest count
+   *x = (fx+128)>>8;
+   *y = (fy+128)>>8;
+   *z = (fz+128)>>8;
+   return 0;
+}
+
+int MMA8452::readFilteredGravity(double *x, double *y, double *z) {
+   restartStalled();
+   if(!_haveSample) {
+      return 1;
+   }
+   __disable_irq();
+   int32_t fx = _filtered[0], fy = _filtered[1], fz = _filtered[2];
+   __enable_irq();
+   // the average keeps 8 bits below a count, so use them
+   double countsPerG = getCountsPerG()*256.0;
+   *x = fx/countsPerG;
+   *y = fy/countsPerG;
+   *z = fz/countsPerG;
+   return 0;
+}
+
+int MMA8452::readFilteredMilliG(int *x, int *y, int *z) {
+   restartStalled();
+   if(!_haveSample) {
+      return 1;
+   }
+   __disable_irq();
+   int32_t fx = _filtered[0], fy = _filtered[1], fz = _filtered[2];
+   __enable_irq();
+   // at most 2047*256*1000, which fits
+   int32_t countsPerG = getCountsPerG()*256;
+   *x = fx*1000/countsPerG;
+   *y = fy*1000/countsPerG;
+   *z = fz*1000/countsPerG;
+   return 0;
+}
+
+void MMA8452::getSamplingStats(SamplingStats *stats) {
+   __disable_irq();
+   *stats = _stats;
+   __enable_irq();
+}
+
+void MMA8452::pauseSampling() {
+   if(_int1 && _paused++==0) {
+      _int1->disable_irq();
+      // a read already started finishes in the I2C interrupt
+      while(_busy);
+   }
+}
+
+void MMA8452::resumeSampling() {
+   if(_int1 && --_paused==0) {
+      _int1->enable_irq();
+      // INT1 stays low until the sample is read, so an edge missed while
+      // paused would stop sampling for good
+      __disable_irq();
+      if(!_busy && !_int1->read()) {
+         _stalled = 0;
+         _retries = 0;
+         dataReady();
+      }
+      __enable_irq();
+   }
+}
+
+// A failed read leaves INT1 low, so no edge will start the next one. Try
+// again at once a few times, then leave it to the readers, so a stuck bus
+// can't keep the interrupt handler busy.
+void MMA8452::readFailed() {
+   _stats.errors++;
+   _busy = 0;
+   if(!_int1->read()) {
+      if(_retries<MMA8452_READ_RETRIES) {
+         _retries++;
+         dataReady();
+      } else {
+         _stalled = 1;
+      }
+   }
+}
+
+void MMA8452::restartStalled() {
+   if(!_stalled) {
+      return;
+   }
+   __disable_irq();
+   if(_stalled && !_busy && !_paused) {
+      _stalled = 0;
+      _retries = 0;
+      // INT1 may have been released since, and then an edge is on its way
+      if(!_int1->read()) {
+         _stats.restarts++;
+         dataReady();
+      }
+   }
+   __enable_irq();
+}
+
+void MMA8452::dataReady() {
+   if(_busy || _paused) {
+      return;
+   }
+   _busy = 1;
+   _rxPos = 0;
+   _readStart = us_ticker_read();
+   #if defined(TARGET_LPC176X) && defined(LPC_I2C2)
+   if(_i2cRegs) {
+      NVIC_EnableIRQ(_i2cIRQn);
+      _i2cRegs->I2CONSET = I2C_STA;
+      return;
+   }
+   #endif
+   if(transferRead(MMA8452_OUT_X_MSB,_rxBuf,_rxLen)) {
+      readFailed();
+      return;
+   }
+   sampleRead(_rxBuf);
+   _busy = 0;
+}
+
+void MMA8452::sampleRead(char *buf) {
+   Sample s;
+   if(_rxLen==6) {
+      s.x = twelveBitToSigned(&buf[0]);
+      s.y = twelveBitToSigned(&buf[2]);
+      s.z = twelveBitToSigned(&buf[4]);
+   } else {
+      s.x = eightBitToSigned(&buf[0]);
+      s.y = eightBitToSigned(&buf[1]);
+      s.z = eightBitToSigned(&buf[2]);
+   }
+   
+   // when the ring is full drop the oldest sample, the newest matter more
+   unsigned next = (_ringHead+1)&(MMA8452_RING_SIZE-1);
+   if(next==_ringTail) {
+      _ringTail = (_ringTail+1)&(MMA8452_RING_SIZE-1);
+      _stats.overruns++;
+   }
+   _ring[_ringHead] = s;
+   _ringHead = next;
+   
+   // exponential moving average in counts*256
+   int counts[3] = { s.x, s.y, s.z };
+   for(int i=0; i<3; i++) {
+      if(_haveSample) {
+         _filtered[i] += (counts[i]*256-_filtered[i])>>_smoothing;
+      } else {
+         _filtered[i] = counts[i]*256;
+      }
+   }
+   _haveSample = 1;
+   _retries = 0;
+   _stats.samples++;
+   uint32_t us = us_ticker_read()-_readStart;
+   _stats.readUs += us;
+   if(us>_stats.maxReadUs) {
+      _stats.maxReadUs = us;
+   }
+}
+
+#if defined(TARGET_LPC176X) && defined(LPC_I2C2)
+void MMA8452::i2cIRQ() {
+   MMA8452 *m = _i2cOwner;
+   LPC_I2C_TypeDef *i2c = m->_i2cRegs;
+   int done = 0;
+   switch(i2c->I2STAT) {
+      // start sent: address the MMA8452 for writing
+      case 0x08:
+         i2c->I2DAT = m->_writeAddress;
+         i2c->I2CONCLR = I2C_STA | I2C_SI;
+      break;
+      // address acked: send the register to read from
+      case 0x18:
+         i2c->I2DAT = MMA8452_OUT_X_MSB;
+         i2c->I2CONCLR = I2C_SI;
+      break;
+      // register acked: repeated start for the read
+      case 0x28:
+         i2c->I2CONSET = I2C_STA;
+         i2c->I2CONCLR = I2C_SI;
+      break;
+      // repeated start sent: address the MMA8452 for reading
+      case 0x10:
+         i2c->I2DAT = m->_readAddress;
+         i2c->I2CONCLR = I2C_STA | I2C_SI;
+      break;
+      // a byte in and acked, or the read address acked: ack all but the last byte
+      case 0x50:
+         m->_rxBuf[m->_rxPos++] = i2c->I2DAT;
+      case 0x40:
+         if(m->_rxPos<m->_rxLen-1) {
+            i2c->I2CONSET = I2C_AA;
+         } else {
+            i2c->I2CONCLR = I2C_AA;
+         }
+         i2c->I2CONCLR = I2C_SI;
+      break;
+      // the last byte in, not acked: stop
+      case 0x58:
+         m->_rxBuf[m->_rxPos++] = i2c->I2DAT;
+         i2c->I2CONSET = I2C_STO;
+         i2c->I2CONCLR = I2C_SI;
+         m->sampleRead(m->_rxBuf);
+         done = 1;
+      break;
+      // no ack, lost arbitration or bus error: stop, and try again
+      default:
+         i2c->I2CONSET = I2C_STO;
+         i2c->I2CONCLR = I2C_SI;
+         done = -1;
+      break;
+   }
+   if(done<0) {
+      NVIC_DisableIRQ(m->_i2cIRQn);
+      m->readFailed();
+   } else if(done) {
+      NVIC_DisableIRQ(m->_i2cIRQn);
+      m->_busy = 0;
+      // a sample that came in during the read left INT1 low
+      if(!m->_int1->read()) {
+         m->dataReady();
+      }
+   }
+}
+#endif
+
 MMA8452::BitDepth MMA8452::getBitDepth() {
    return _bitDepth;
 }
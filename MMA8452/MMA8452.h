@@ -102,6 +102,16 @@
 #define MMA8452_BIT_DEPTH_MASK 0xFD
 #define MMA8452_BIT_DEPTH_MASK_SHIFT 0x01
 
+// data ready interrupt: enabled in CTRL_REG_4, routed to INT1 (else INT2) in CTRL_REG_5
+#define MMA8452_INT_EN_DRDY 0x01
+#define MMA8452_INT_CFG_DRDY 0x01
+
+// samples kept by background sampling, a power of 2
+#define MMA8452_RING_SIZE 8
+
+// failed background reads tried again at once before waiting for a reader
+#define MMA8452_READ_RETRIES 3
+
 // status masks and shifts
 #define MMA8452_STATUS_ZYXDR_MASK 0x08
 #define MMA8452_STATUS_ZDR_MASK 0x04
@@ -139,13 +149,28 @@ class MMA8452 {
           RATE_1_563,
           RATE_UNKNOWN
        };
+       
+       /// One background sample, in signed counts. @sa readXYZCounts
+       struct Sample {
+          int16_t x, y, z;
+       };
+       
+       /// Background sampling counters. @sa getSamplingStats
+       struct SamplingStats {
+          unsigned samples;    ///< samples read on the data ready interrupt
+          unsigned overruns;   ///< samples dropped because the ring was full
+          unsigned errors;     ///< background reads that failed
+          unsigned restarts;   ///< reads restarted by a reader after the retries ran out
+          unsigned readUs;     ///< total time from starting a read to storing its sample, in us
+          unsigned maxReadUs;  ///< the slowest of those
+       };
          
        /**
         * Create an accelerometer object connected to the specified I2C pins.
         *
         * @param sda I2C data port
         * @param scl I2C clock port
-        * @param frequency 
+        * @param frequency I2C clock in Hz, up to 400000 (fast mode)
         * 
         */ 
       MMA8452(PinName sda, PinName scl, int frequency);
@@ -153,6 +178,9 @@ class MMA8452 {
       /// Destructor
       ~MMA8452();
       
+      /// Change the I2C clock, in Hz; the MMA8452 runs at up to 400000 (fast mode).
+      void setFrequency(int frequency);
+      
       /**
        * Puts the MMA8452 in active mode.
        * @return 0 on success, 1 on failure.
@@ -238,6 +266,16 @@ class MMA8452 {
        */
       int readXYZGravity(double *x, double *y, double *z);
       
+      /**
+       * Read the x, y, and z accelerations in thousandths of a G.
+       *
+       * The same burst read as readXYZGravity, scaled in integers, so no
+       * floating point is done.
+       *
+       * @return 0 on success, 1 on failure.
+       */
+      int readXYZMilliG(int *x, int *y, int *z);
+      
       /// Read the x gravity in G into the provided double pointer. @sa readXYZGravity
       int readXGravity(double *x);
       /// Read the y gravity in G into the provided double pointer. @sa readXYZGravity
@@ -245,6 +283,53 @@ class MMA8452 {
       /// Read the z gravity in G into the provided double pointer. @sa readXYZGravity
       int readZGravity(double *z);
       
+      /**
+       * Sample in the background on the data ready interrupt.
+       *
+       * The MMA8452's data ready interrupt is routed to its INT1 pin, which
+       * must be wired to the given mbed pin. On each falling edge the three
+       * axes are read in one burst into a ring of MMA8452_RING_SIZE samples,
+       * and into a moving average for readFilteredGravity(). On the LPC1768
+       * the read is run from the I2C interrupt, one state per byte, so no
+       * code waits for the bus; elsewhere the pin interrupt does the read.
+       *
+       * The other functions still work while sampling; they pause it around
+       * their own transfers.
+       *
+       * @param int1 The pin wired to INT1.
+       * @param rate The output data rate.
+       * @param smoothing Each sample moves the average 1/2^smoothing of the way to it, 0 for no filtering.
+       * @return 0 on success, 1 on failure.
+       */
+      int startSampling(PinName int1, DataRateHz rate=RATE_100, int smoothing=2);
+      
+      /// Stop background sampling and turn the data ready interrupt off.
+      void stopSampling();
+      
+      /**
+       * Take the oldest background sample from the ring.
+       *
+       * @param s Where to store the sample.
+       * @return 0 on success, 1 if the ring is empty.
+       */
+      int readSample(Sample *s);
+      
+      /**
+       * Read the filtered x, y, and z counts without touching the bus.
+       *
+       * @return 0 on success, 1 if no sample has been read yet.
+       */
+      int readFilteredCounts(int *x, int *y, int *z);
+      
+      /// Read the filtered accelerations in G without touching the bus. @sa readFilteredCounts
+      int readFilteredGravity(double *x, double *y, double *z);
+      
+      /// Read the filtered accelerations in thousandths of a G without touching the bus or floating point. @sa readFilteredCounts
+      int readFilteredMilliG(int *x, int *y, int *z);
+      
+      /// Copy the background sampling counters into stats.
+      void getSamplingStats(SamplingStats *stats);
+      
       /// Returns 1 if data has been internally sampled (is available) for all axes since last read, 0 otherwise.
       int isXYZReady();
       /// Returns 1 if data has been internally sampled (is available) for the x-axis since last read, 0 otherwise.
@@ -294,6 +379,17 @@ class MMA8452 {
       int setBitDepth(BitDepth depth, int toggleActivation=1);
       int setDataRate(DataRateHz dataRate, int toggleActivation=1);
       
+      /**
+       * Set up for the shortest reads: 8 bit samples in fast read mode, so
+       * the three axes are 3 bytes of data instead of 6, at the given data
+       * rate. The MMA8452 has no FIFO, so this is as little as a sample
+       * can be read in. Leaves the device active.
+       *
+       * @param rate The output data rate.
+       * @return 0 on success, 1 on failure.
+       */
+      int setLowLatency(DataRateHz rate);
+      
       DynamicRange getDynamicRange();
       DataRateHz getDataRate();
       BitDepth getBitDepth();
@@ -332,12 +428,54 @@ class MMA8452 {
       
       /// Get the counts per G for the current settings of bit depth and dynamic range.
       int getCountsPerG();
+      
+      /// Reads n bytes from a register without pausing background sampling.
+      int transferRead(char addr, char *dst, int nbytes);
+      
+      /// Keep background reads off the bus, waiting for one in progress to finish. Nests.
+      void pauseSampling();
+      /// Undo pauseSampling(), catching up on a data ready edge missed meanwhile.
+      void resumeSampling();
+      
+      /// INT1 fell: start reading the sample.
+      void dataReady();
+      /// Store a sample read from OUT_X_MSB onwards in the ring and the average.
+      void sampleRead(char *buf);
+      /// A background read failed: try again while INT1 is low, a few times.
+      void readFailed();
+      /// Start a read given up on in readFailed(). Called by the readers.
+      void restartStalled();
+      
+      #if defined(TARGET_LPC176X) && defined(LPC_I2C2)
+      /// I2C interrupt: the next step of the background read.
+      static void i2cIRQ();
+      static MMA8452 *_i2cOwner;
+      LPC_I2C_TypeDef *_i2cRegs;
+      IRQn_Type _i2cIRQn;
+      #endif
     
       I2C _i2c;
+      PinName _sda;
       int _frequency;
       int _readAddress;
       int _writeAddress;
       
       BitDepth _bitDepth;
       DynamicRange _dynamicRange;       
+      
+      // background sampling
+      InterruptIn *_int1;
+      volatile int _busy;        // a background read is in progress
+      int _paused;
+      int _retries;              // failed reads tried again since the last sample
+      volatile int _stalled;     // retries ran out with INT1 low
+      int _smoothing;
+      char _rxBuf[6];
+      int _rxLen, _rxPos;
+      uint32_t _readStart;
+      Sample _ring[MMA8452_RING_SIZE];
+      volatile unsigned _ringHead, _ringTail;
+      volatile int32_t _filtered[3];   // counts<<8
+      volatile int _haveSample;
+      SamplingStats _stats;
 };
\ No newline at end of file
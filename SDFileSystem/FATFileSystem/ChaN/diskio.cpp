@@ -9,6 +9,7 @@
 
 #include "mbed_debug.h"
 #include "FATFileSystem.h"
+#include "FATSectorCache.h"
 
 using namespace mbed;
 
@@ -36,13 +37,11 @@ DRESULT disk_read (
 )
 {
     debug_if(FFS_DBG, "disk_read(sector %d, count %d) on drv [%d]\n", sector, count, drv);
-    for(DWORD s=sector; s<sector+count; s++) {
-        debug_if(FFS_DBG, " disk_read(sector %d)\n", s);
-        int res = FATFileSystem::_ffs[drv]->disk_read((uint8_t*)buff, s);
-        if(res) {
-            return RES_PARERR;
-        }
-        buff += 512;
+    FATFileSystem *fs = FATFileSystem::_ffs[drv];
+    int res = fs->_cache ? fs->_cache->read((uint8_t*)buff, sector, count)
+                         : fs->disk_read_blocks((uint8_t*)buff, sector, count);
+    if(res) {
+        return RES_PARERR;
     }
     return RES_OK;
 }
@@ -56,13 +55,11 @@ DRESULT disk_write (
 )
 {
     debug_if(FFS_DBG, "disk_write(sector %d, count %d) on drv [%d]\n", sector, count, drv);
-    for(DWORD s = sector; s < sector + count; s++) {
-        debug_if(FFS_DBG, " disk_write(sector %d)\n", s);
-        int res = FATFileSystem::_ffs[drv]->disk_write((uint8_t*)buff, s);
-        if(res) {
-            return RES_PARERR;
-        }
-        buff += 512;
+    FATFileSystem *fs = FATFileSystem::_ffs[drv];
+    int res = fs->_cache ? fs->_cache->write((const uint8_t*)buff, sector, count)
+                         : fs->disk_write_blocks((const uint8_t*)buff, sector, count);
+    if(res) {
+        return RES_PARERR;
     }
     return RES_OK;
 }
@@ -79,6 +76,8 @@ DRESULT disk_ioctl (
         case CTRL_SYNC:
             if(FATFileSystem::_ffs[drv] == NULL) {
                 return RES_NOTRDY;
+            } else if(FATFileSystem::_ffs[drv]->_cache && FATFileSystem::_ffs[drv]->_cache->sync()) {
+                return RES_ERROR;
             } else if(FATFileSystem::_ffs[drv]->disk_sync()) {
                 return RES_ERROR;
             }
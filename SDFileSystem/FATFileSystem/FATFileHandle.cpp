@@ -27,10 +27,12 @@
 
 FATFileHandle::FATFileHandle(FIL fh) {
     _fh = fh;
+    _clmt = NULL;
 }
 
 int FATFileHandle::close() {
     int retval = f_close(&_fh);
+    delete[] _clmt;
     delete this;
     return retval;
 }
@@ -88,3 +90,42 @@ int FATFileHandle::fsync() {
 off_t FATFileHandle::flen() {
     return _fh.fsize;
 }
+
+int FATFileHandle::fast_seek(DWORD *table, UINT size) {
+#if _USE_FASTSEEK
+    if (_fh.flag & FA_WRITE) {
+        return -1;
+    }
+    _fh.cltbl = NULL;
+    delete[] _clmt;
+    _clmt = NULL;
+    
+    if (!table) {
+        // a one DWORD table only gets told the size it needs
+        DWORD need = 1;
+        _fh.cltbl = &need;
+        FRESULT res = f_lseek(&_fh, CREATE_LINKMAP);
+        _fh.cltbl = NULL;
+        if (res != FR_OK && res != FR_NOT_ENOUGH_CORE) {
+            debug_if(FFS_DBG, "fast_seek failed: %d\n", res);
+            return -1;
+        }
+        table = _clmt = new DWORD[need];
+        size = need;
+    }
+    
+    table[0] = size;
+    _fh.cltbl = table;
+    FRESULT res = f_lseek(&_fh, CREATE_LINKMAP);
+    if (res) {
+        debug_if(FFS_DBG, "fast_seek failed: %d\n", res);
+        _fh.cltbl = NULL;
+        delete[] _clmt;
+        _clmt = NULL;
+        return res == FR_NOT_ENOUGH_CORE ? (int)table[0] : -1;
+    }
+    return 0;
+#else
+    return -1;
+#endif
+}
@@ -38,9 +38,23 @@ public:
     virtual int fsync();
     virtual off_t flen();
 
+    /** Switch the file to FatFs fast seek
+     *
+     * The file's cluster chain is read once into a cluster link map table
+     * (CLMT); from then on seeks and reads find clusters in the table
+     * instead of following the FAT from the start of the chain. Fast seek
+     * mode cannot grow a file, so the file must be open read only.
+     *
+     * @param table DWORDs for the map, or NULL to have one allocated and freed on close()
+     * @param size number of DWORDs in table
+     * @returns 0 on success, -1 on error, or the number of DWORDs needed if table is too small
+     */
+    int fast_seek(DWORD *table = NULL, UINT size = 0);
+
 protected:
 
     FIL _fh;
+    DWORD *_clmt;   // link map allocated by fast_seek()
 
 };
 
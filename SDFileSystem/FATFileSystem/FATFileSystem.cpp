@@ -44,6 +44,8 @@ FATFileSystem *FATFileSystem::_ffs[_VOLUMES] = {0};
 
 FATFileSystem::FATFileSystem(const char* n) : FileSystemLike(n) {
     debug_if(FFS_DBG, "FATFileSystem(%s)\n", n);
+    _fast_seek = 0;
+    _cache = NULL;
     for(int i=0; i<_VOLUMES; i++) {
         if(_ffs[i] == 0) {
             _ffs[i] = this;
@@ -96,7 +98,11 @@ FileHandle *FATFileSystem::open(const char* name, int flags) {
     if (flags & O_APPEND) {
         f_lseek(&fh, fh.fsize);
     }
-    return new FATFileHandle(fh);
+    FATFileHandle *handle = new FATFileHandle(fh);
+    if (_fast_seek && openmode == FA_READ) {
+        handle->fast_seek();
+    }
+    return handle;
 }
     
 int FATFileSystem::remove(const char *filename) {
@@ -126,6 +132,26 @@ DirHandle *FATFileSystem::opendir(const char *name) {
     return new FATDirHandle(dir);
 }
 
+int FATFileSystem::disk_read_blocks(uint8_t *buffer, uint64_t sector, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        if (disk_read(buffer, sector + i)) {
+            return 1;
+        }
+        buffer += 512;
+    }
+    return 0;
+}
+
+int FATFileSystem::disk_write_blocks(const uint8_t *buffer, uint64_t sector, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        if (disk_write(buffer, sector + i)) {
+            return 1;
+        }
+        buffer += 512;
+    }
+    return 0;
+}
+
 int FATFileSystem::mkdir(const char *name, mode_t mode) {
     FRESULT res = f_mkdir(name);
     return res == 0 ? 0 : -1;
@@ -29,6 +29,8 @@
 
 using namespace mbed;
 
+class FATSectorCache;
+
 class FATFileSystem : public FileSystemLike {
 public:
 
@@ -38,6 +40,7 @@ public:
     static FATFileSystem * _ffs[_VOLUMES];   // FATFileSystem objects, as parallel to FatFs drives array
     FATFS _fs;                               // Work area (file system object) for logical drive
     int _fsid;
+    FATSectorCache *_cache;                  // between FatFs and the disk_ functions, see FATSectorCache.h
 
     virtual FileHandle *open(const char* name, int flags);
     virtual int remove(const char *filename);
@@ -45,13 +48,28 @@ public:
     virtual DirHandle *opendir(const char *name);
     virtual int mkdir(const char *name, mode_t mode);
 
+    /** Give files opened read only a cluster link map, see
+     *  FATFileHandle::fast_seek().  Off by default.
+     */
+    void fast_seek(int on) { _fast_seek = on; }
+
     virtual int disk_initialize() { return 0; }
     virtual int disk_status() { return 0; }
     virtual int disk_read(uint8_t * buffer, uint64_t sector) = 0;
     virtual int disk_write(const uint8_t * buffer, uint64_t sector) = 0;
+
+    /** Read or write count consecutive sectors.  The defaults go a sector
+     *  at a time; drivers that have a faster multiple sector transfer
+     *  override them.  Return 0 on success.
+     */
+    virtual int disk_read_blocks(uint8_t * buffer, uint64_t sector, uint32_t count);
+    virtual int disk_write_blocks(const uint8_t * buffer, uint64_t sector, uint32_t count);
     virtual int disk_sync() { return 0; }
     virtual uint64_t disk_sectors() = 0;
 
+protected:
+    int _fast_seek;
+
 };
 
 #endif
@@ -0,0 +1,315 @@
+#include "mbed.h"
+#include <stdarg.h>
+#include <string.h>
+#include "ffconf.h"
+#include "diskio.h"
+#include "mbed_debug.h"
+
+#include "FATFileSystem.h"
+#include "FATLogFile.h"
+
+#define FAT_LOG_MAGIC   0x474F4C46  // "FLOG"
+#define FAT_LOG_RECORDS 2           // commit record sectors ahead of the data
+#define FAT_LOG_LINE    128         // longest printf()
+
+static uint32_t crc32(const uint8_t *p, int n) {
+    uint32_t crc = 0xFFFFFFFF;
+    while (n--) {
+        crc ^= *p++;
+        for (int k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+FATLogFile::FATLogFile(FATFileSystem *fs, int buffer_sectors, uint8_t *memory) {
+    _fs = fs;
+    _open = 0;
+    // the last sector doubles as the commit record buffer
+    _buffer_sectors = buffer_sectors < 2 ? 2 : buffer_sectors;
+    _own_memory = memory == NULL;
+    _buffer = memory ? memory : new uint8_t[_buffer_sectors * 512];
+    _map = NULL;
+    _capacity = _length = _committed = _sequence = _stage_sector = 0;
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+FATLogFile::~FATLogFile() {
+    close();
+    if (_own_memory) {
+        delete[] _buffer;
+    }
+}
+
+int FATLogFile::open(const char *name, uint32_t capacity) {
+    close();
+    debug_if(FFS_DBG, "FATLogFile::open(%s, %u)\n", name, capacity);
+    char n[64];
+    sprintf(n, "%d:/%s", _fs->_fsid, name);
+
+    FIL fh;
+    FRESULT res = f_open(&fh, n, FA_READ | FA_WRITE | FA_OPEN_ALWAYS);
+    if (res) {
+        debug_if(FFS_DBG, "f_open() failed: %d\n", res);
+        return -1;
+    }
+    int fresh = fh.fsize < FAT_LOG_RECORDS * 512;
+    DWORD size = FAT_LOG_RECORDS * 512 + ((capacity + 511) & ~511);
+    if (fh.fsize < size) {
+        // seeking past the end in write mode allocates the clusters, which
+        // on a card that isn't fragmented come out contiguous
+        res = f_lseek(&fh, size);
+        if (!res && fh.fsize < size) {
+            res = FR_DENIED;
+        }
+        if (!res) {
+            res = f_sync(&fh);
+        }
+    }
+
+    DWORD need = 1;
+    if (!res) {
+        fh.cltbl = &need;
+        res = f_lseek(&fh, CREATE_LINKMAP);
+        if (res == FR_NOT_ENOUGH_CORE) {
+            _map = new DWORD[need];
+            _map[0] = need;
+            fh.cltbl = _map;
+            res = f_lseek(&fh, CREATE_LINKMAP);
+        }
+        fh.cltbl = NULL;
+    }
+    f_close(&fh);
+    if (res || !_map) {
+        debug_if(FFS_DBG, "FATLogFile: preallocating failed: %d\n", res);
+        delete[] _map;
+        _map = NULL;
+        return -1;
+    }
+    _stats.fragments = (_map[0] - 2) / 2;
+    debug_if(FFS_DBG && _stats.fragments > 1, "FATLogFile: %s is in %u pieces\n", name, _stats.fragments);
+    _capacity = (fh.fsize - FAT_LOG_RECORDS * 512) & ~511;
+
+    // new clusters may hold anything, including an old log's records
+    uint8_t *records = _buffer;
+    if (fresh) {
+        memset(records, 0, FAT_LOG_RECORDS * 512);
+        if (_transfer(records, 0, FAT_LOG_RECORDS, 1) || disk_ioctl(_fs->_fs.drv, CTRL_SYNC, NULL)) {
+            return -1;
+        }
+    } else if (_transfer(records, 0, FAT_LOG_RECORDS, 0)) {
+        return -1;
+    }
+
+    // newest valid record
+    _sequence = _committed = 0;
+    for (int i = 0; i < FAT_LOG_RECORDS; i++) {
+        uint32_t rec[4];
+        memcpy(rec, records + i * 512, sizeof(rec));
+        if (rec[0] == FAT_LOG_MAGIC && rec[3] == crc32((uint8_t*)rec, 12) &&
+            rec[2] <= _capacity && rec[1] >= _sequence) {
+            _sequence = rec[1];
+            _committed = rec[2];
+        }
+    }
+    _length = _committed;
+    _stage_sector = _length / 512;
+    if (_length % 512 && _transfer(_buffer, FAT_LOG_RECORDS + _stage_sector, 1, 0)) {
+        return -1;
+    }
+    _open = 1;
+    return 0;
+}
+
+int FATLogFile::write(const void *data, uint32_t length) {
+    if (!_open) {
+        return -1;
+    }
+    if (length > _capacity - _length) {
+        length = _capacity - _length;
+    }
+    const uint8_t *p = (const uint8_t*)data;
+    uint32_t left = length;
+    while (left) {
+        uint32_t staged = _length - _stage_sector * 512;
+        uint32_t n = _buffer_sectors * 512 - staged;
+        if (n > left) {
+            n = left;
+        }
+        memcpy(_buffer + staged, p, n);
+        p += n;
+        left -= n;
+        _length += n;
+        if (staged + n == (uint32_t)_buffer_sectors * 512) {
+            if (_flush(_buffer_sectors)) {
+                return -1;
+            }
+            _stage_sector += _buffer_sectors;
+        }
+    }
+    _stats.bytes += length;
+    return length;
+}
+
+int FATLogFile::printf(const char *format, ...) {
+    char line[FAT_LOG_LINE];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (n < 0) {
+        return -1;
+    }
+    return write(line, n < (int)sizeof(line) ? n : sizeof(line) - 1);
+}
+
+int FATLogFile::commit() {
+    if (!_open) {
+        return -1;
+    }
+    if (_length == _committed) {
+        return 0;
+    }
+    uint32_t start = us_ticker_read();
+    uint32_t staged = _length - _stage_sector * 512;
+    uint32_t sectors = (staged + 511) / 512;
+    memset(_buffer + staged, 0, sectors * 512 - staged);
+    if (sectors && _flush(sectors)) {
+        return -1;
+    }
+    // keep the partial last sector; the next commit writes it again
+    uint32_t full = staged / 512;
+    if (full) {
+        memmove(_buffer, _buffer + full * 512, staged % 512);
+        _stage_sector += full;
+    }
+
+    // the data must be on the card before the record that covers it
+    BYTE drv = _fs->_fs.drv;
+    if (disk_ioctl(drv, CTRL_SYNC, NULL) || _write_record() || disk_ioctl(drv, CTRL_SYNC, NULL)) {
+        return -1;
+    }
+    _committed = _length;
+    uint32_t us = us_ticker_read() - start;
+    if (us > _stats.max_flush_us) {
+        _stats.max_flush_us = us;
+    }
+    return 0;
+}
+
+int FATLogFile::close() {
+    if (!_open) {
+        return 0;
+    }
+    int res = commit();
+    _open = 0;
+    delete[] _map;
+    _map = NULL;
+    return res;
+}
+
+int FATLogFile::read(void *buffer, uint32_t offset, uint32_t length) {
+    if (!_open) {
+        return -1;
+    }
+    if (offset >= _length) {
+        return 0;
+    }
+    if (length > _length - offset) {
+        length = _length - offset;
+    }
+    uint8_t *p = (uint8_t*)buffer;
+    uint32_t left = length;
+    uint8_t sector[512];
+    while (left) {
+        uint32_t s = offset / 512, in = offset % 512;
+        uint32_t n = 512 - in;
+        if (n > left) {
+            n = left;
+        }
+        if (s >= _stage_sector) {
+            memcpy(p, _buffer + (s - _stage_sector) * 512 + in, n);
+        } else {
+            if (_transfer(sector, FAT_LOG_RECORDS + s, 1, 0)) {
+                return -1;
+            }
+            memcpy(p, sector + in, n);
+        }
+        p += n;
+        offset += n;
+        left -= n;
+    }
+    return length;
+}
+
+void FATLogFile::reset_stats() {
+    uint32_t fragments = _stats.fragments;
+    memset(&_stats, 0, sizeof(_stats));
+    _stats.fragments = fragments;
+}
+
+// sectors of the file through the link map, a fragment at a time
+int FATLogFile::_transfer(uint8_t *buffer, uint32_t sector, uint32_t count, int write) {
+    FATFS *fs = &_fs->_fs;
+    while (count) {
+        uint32_t cluster = sector / fs->csize;
+        uint32_t in = sector % fs->csize;
+        DWORD *frag = _map + 1;
+        while (frag[0] && cluster >= frag[0]) {
+            cluster -= frag[0];
+            frag += 2;
+        }
+        if (!frag[0]) {
+            return -1;
+        }
+        DWORD lba = fs->database + (frag[1] - 2 + cluster) * fs->csize + in;
+        uint32_t n = (frag[0] - cluster) * fs->csize - in;
+        if (n > count) {
+            n = count;
+        }
+        if (n > 128) {
+            n = 128;    // disk_read()/disk_write() count is a BYTE
+        }
+        DRESULT res = write ? disk_write(fs->drv, buffer, lba, n) : disk_read(fs->drv, buffer, lba, n);
+        if (res != RES_OK) {
+            debug_if(FFS_DBG, "FATLogFile: sector %u failed: %d\n", lba, res);
+            return -1;
+        }
+        buffer += n * 512;
+        sector += n;
+        count -= n;
+    }
+    return 0;
+}
+
+int FATLogFile::_flush(uint32_t sectors) {
+    uint32_t start = us_ticker_read();
+    if (_transfer(_buffer, FAT_LOG_RECORDS + _stage_sector, sectors, 1)) {
+        return -1;
+    }
+    _stats.flushes++;
+    _stats.sectors += sectors;
+    uint32_t us = us_ticker_read() - start;
+    if (us > _stats.max_flush_us) {
+        _stats.max_flush_us = us;
+    }
+    return 0;
+}
+
+// records alternate between the two sectors, so the previous one survives
+// a torn write
+int FATLogFile::_write_record() {
+    uint8_t *sector = _buffer + (_buffer_sectors - 1) * 512;
+    uint32_t rec[4] = { FAT_LOG_MAGIC, _sequence + 1, _length, 0 };
+    rec[3] = crc32((uint8_t*)rec, 12);
+    memset(sector, 0, 512);
+    memcpy(sector, rec, sizeof(rec));
+    if (_transfer(sector, rec[1] % FAT_LOG_RECORDS, 1, 1)) {
+        return -1;
+    }
+    _sequence = rec[1];
+    _stats.commits++;
+    _stats.sectors++;
+    return 0;
+}
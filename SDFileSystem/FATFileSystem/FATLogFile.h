@@ -0,0 +1,119 @@
+#ifndef MBED_FATLOGFILE_H
+#define MBED_FATLOGFILE_H
+
+#include <stdint.h>
+#include "ff.h"
+
+class FATFileSystem;
+
+/** Log counters, see FATLogFile::get_stats() */
+typedef struct {
+    uint32_t bytes;             ///< bytes appended
+    uint32_t sectors;           ///< sectors written to the disk, commit records included
+    uint32_t flushes;           ///< staging buffer writes
+    uint32_t commits;           ///< commit records written
+    uint32_t max_flush_us;      ///< slowest flush or commit
+    uint32_t fragments;         ///< pieces the preallocated file is in, 1 when contiguous
+} FAT_LOG_STATS;
+
+/** Append only log file that writes its sectors around FatFs
+ *
+ * open() grows the file to its full capacity once, with f_lseek() past the
+ * end, and reads its cluster chain into a link map. After that appends never
+ * touch the FAT or the directory entry: they collect in a RAM staging
+ * buffer, which is written as one multiple sector transfer when full, so a
+ * write() costs a memcpy and at most one flush of the buffer.
+ *
+ * The file's first two sectors hold commit records. commit() writes out
+ * what is staged, the partial last sector included, then a record with the
+ * logged length and a sequence number, alternating between the two sectors
+ * so a record torn by a reset leaves the previous one intact. open() picks
+ * up from the newest valid record; anything after it is lost. The data
+ * starts at byte 1024 of the file, and the file's size is always its
+ * capacity, so a PC reads the length from the records.
+ *
+ * Sectors go through disk_read()/disk_write(), so a FATSectorCache on the
+ * file system stays coherent; it is synced before and after each commit
+ * record.
+ *
+ * @code
+ * SDFileSystem sd(p5, p6, p7, p8, "sd");
+ * FATLogFile log(&sd, 4);             // 4 sector staging buffer
+ * log.open("telemetry.log", 256 * 1024);
+ * log.printf("%d %d\n", level, score);
+ * log.commit();
+ * @endcode
+ */
+class FATLogFile {
+public:
+
+    /** Create a log on a file system
+     *
+     * @param fs the file system to keep the file on
+     * @param buffer_sectors sectors in the staging buffer, at least 2
+     * @param memory buffer_sectors * 512 bytes to use, or NULL to allocate them
+     */
+    FATLogFile(FATFileSystem *fs, int buffer_sectors, uint8_t *memory = NULL);
+    ~FATLogFile();
+
+    /** Open or create a log file, preallocating it
+     *
+     * @param name path on the file system, without the mount name
+     * @param capacity bytes of log data the file holds; an existing file
+     *   that is larger keeps its size
+     * @returns 0 on success
+     */
+    int open(const char *name, uint32_t capacity);
+
+    /** Append bytes
+     *
+     * @returns the number of bytes appended, short when the file is full, or -1 on error
+     */
+    int write(const void *data, uint32_t length);
+
+    /** Append formatted text, up to 127 bytes of it */
+    int printf(const char *format, ...);
+
+    /** Write out the staged data and a commit record
+     *
+     * @returns 0 on success
+     */
+    int commit();
+
+    /** Commit and close the log */
+    int close();
+
+    /** Read committed or staged data back
+     *
+     * @returns the number of bytes read, or -1 on error
+     */
+    int read(void *buffer, uint32_t offset, uint32_t length);
+
+    uint32_t length() { return _length; }
+    uint32_t capacity() { return _capacity; }
+    void get_stats(FAT_LOG_STATS *stats) { *stats = _stats; }
+    void reset_stats();
+
+protected:
+
+    int _transfer(uint8_t *buffer, uint32_t sector, uint32_t count, int write);
+    int _flush(uint32_t sectors);
+    int _write_record();
+
+    FATFileSystem *_fs;
+    int _open;
+    uint8_t *_buffer;       // staging buffer, data from sector _stage_sector on
+    int _buffer_sectors;
+    int _own_memory;
+
+    DWORD *_map;            // cluster link map of the file, as f_lseek(CREATE_LINKMAP) makes it
+    uint32_t _capacity;     // data bytes
+    uint32_t _length;       // data bytes appended
+    uint32_t _committed;    // data bytes in the last commit record
+    uint32_t _sequence;     // of the last commit record
+    uint32_t _stage_sector; // data sector at the start of _buffer
+
+    FAT_LOG_STATS _stats;
+};
+
+#endif
@@ -0,0 +1,220 @@
+#include <string.h>
+#include "ffconf.h"
+#include "mbed_debug.h"
+
+#include "FATFileSystem.h"
+#include "FATSectorCache.h"
+
+FATSectorCache::FATSectorCache(FATFileSystem *fs, int sectors, int read_ahead, uint8_t *memory) {
+    _fs = fs;
+    _sectors = sectors;
+    _read_ahead = read_ahead;
+    _write_through = 0;
+    _own_memory = memory == NULL;
+    _memory = memory ? memory : new uint8_t[(sectors + read_ahead) * 512];
+    _data = _memory;
+    _ahead = _memory + sectors * 512;
+    _sector = new uint32_t[sectors];
+    _used = new uint32_t[sectors];
+    _dirty = new uint8_t[sectors];
+    invalidate();
+    reset_stats();
+    _next = 0;
+    _fs->_cache = this;
+}
+
+FATSectorCache::~FATSectorCache() {
+    sync();
+    if (_fs->_cache == this) {
+        _fs->_cache = NULL;
+    }
+    if (_own_memory) {
+        delete[] _memory;
+    }
+    delete[] _sector;
+    delete[] _used;
+    delete[] _dirty;
+}
+
+int FATSectorCache::read(uint8_t *buffer, uint64_t sector, uint32_t count) {
+    uint32_t start = (uint32_t)sector;
+    // FatFs reads a FAT sector now and then in the middle of a file, so
+    // running on from the window counts as sequential too
+    int sequential = start == _next || (_ahead_count && start == _ahead_start + _ahead_count);
+    _next = start + count;
+
+    uint32_t i = 0;
+    while (i < count) {
+        uint32_t s = start + i;
+        uint8_t *dst = buffer + i * 512;
+
+        int slot = _find(s);
+        if (slot >= 0) {
+            memcpy(dst, _data + slot * 512, 512);
+            _used[slot] = ++_clock;
+            _stats.hits++;
+            i++;
+            continue;
+        }
+        if (s - _ahead_start < _ahead_count) {
+            memcpy(dst, _ahead + (s - _ahead_start) * 512, 512);
+            _stats.read_ahead_hits++;
+            i++;
+            continue;
+        }
+
+        // run of sectors held nowhere
+        uint32_t n = 1;
+        while (i + n < count && _find(s + n) < 0 && s + n - _ahead_start >= _ahead_count) {
+            n++;
+        }
+        _stats.misses += n;
+
+        // reading on from where the last read ended: refill the window
+        if (sequential && n < (uint32_t)_read_ahead) {
+            uint32_t fill = _read_ahead;
+            uint64_t end = _fs->disk_sectors();
+            if (end && s + fill > end) {
+                fill = end - s;
+            }
+            _ahead_count = 0;
+            if (_fs->disk_read_blocks(_ahead, s, fill)) {
+                return 1;
+            }
+            _ahead_start = s;
+            _ahead_count = fill;
+            _stats.read_ahead_fills++;
+            // the disk is behind any dirty slots, and they may go before the window does
+            for (slot = 0; slot < _sectors; slot++) {
+                if (_dirty[slot] && _sector[slot] - s < fill) {
+                    memcpy(_ahead + (_sector[slot] - s) * 512, _data + slot * 512, 512);
+                }
+            }
+            memcpy(dst, _ahead, n * 512);
+            i += n;
+            continue;
+        }
+
+        if (_fs->disk_read_blocks(dst, s, n)) {
+            return 1;
+        }
+
+        // only single sectors are kept: FAT and directory sectors come one
+        // at a time, longer runs are file data that is read once
+        if (n == 1 && (slot = _victim()) >= 0) {
+            memcpy(_data + slot * 512, dst, 512);
+            _sector[slot] = s;
+            _used[slot] = ++_clock;
+        }
+        i += n;
+    }
+    return 0;
+}
+
+int FATSectorCache::write(const uint8_t *buffer, uint64_t sector, uint32_t count) {
+    uint32_t start = (uint32_t)sector;
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (start + i - _ahead_start < _ahead_count) {
+            memcpy(_ahead + (start + i - _ahead_start) * 512, buffer + i * 512, 512);
+        }
+    }
+
+    if (_write_through || count > 1) {
+        if (_fs->disk_write_blocks(buffer, start, count)) {
+            return 1;
+        }
+        for (int slot = 0; slot < _sectors; slot++) {
+            if (_used[slot] && _sector[slot] - start < count) {
+                memcpy(_data + slot * 512, buffer + (_sector[slot] - start) * 512, 512);
+                _dirty[slot] = 0;
+            }
+        }
+        return 0;
+    }
+
+    int slot = _find(start);
+    if (slot < 0) {
+        slot = _victim();
+        if (slot < 0) {
+            return 1;
+        }
+        _sector[slot] = start;
+    }
+    memcpy(_data + slot * 512, buffer, 512);
+    _dirty[slot] = 1;
+    _used[slot] = ++_clock;
+    return 0;
+}
+
+int FATSectorCache::sync() {
+    // lowest sector first, so the card sees ascending addresses
+    for (;;) {
+        int next = -1;
+        for (int slot = 0; slot < _sectors; slot++) {
+            if (_dirty[slot] && (next < 0 || _sector[slot] < _sector[next])) {
+                next = slot;
+            }
+        }
+        if (next < 0) {
+            return 0;
+        }
+        if (_write_back(next)) {
+            return 1;
+        }
+    }
+}
+
+void FATSectorCache::invalidate() {
+    for (int slot = 0; slot < _sectors; slot++) {
+        _used[slot] = 0;
+        _dirty[slot] = 0;
+    }
+    _clock = 0;
+    _ahead_count = 0;
+}
+
+void FATSectorCache::write_through(int on) {
+    if (on) {
+        sync();
+    }
+    _write_through = on;
+}
+
+void FATSectorCache::reset_stats() {
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+int FATSectorCache::_find(uint32_t sector) {
+    for (int slot = 0; slot < _sectors; slot++) {
+        if (_used[slot] && _sector[slot] == sector) {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+// an empty slot, or the least recently used one once it is written back
+int FATSectorCache::_victim() {
+    int victim = 0;
+    for (int slot = 0; slot < _sectors; slot++) {
+        if (_used[slot] < _used[victim]) {
+            victim = slot;
+        }
+    }
+    if (_dirty[victim] && _write_back(victim)) {
+        return -1;
+    }
+    _used[victim] = 0;
+    return victim;
+}
+
+int FATSectorCache::_write_back(int slot) {
+    if (_fs->disk_write_blocks(_data + slot * 512, _sector[slot], 1)) {
+        debug_if(FFS_DBG, "cache write back of sector %d failed\n", _sector[slot]);
+        return 1;
+    }
+    _dirty[slot] = 0;
+    _stats.write_backs++;
+    return 0;
+}
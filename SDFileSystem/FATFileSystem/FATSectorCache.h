@@ -0,0 +1,97 @@
+#ifndef MBED_FATSECTORCACHE_H
+#define MBED_FATSECTORCACHE_H
+
+#include <stdint.h>
+
+class FATFileSystem;
+
+/** Cache counters, see FATSectorCache::get_stats() */
+typedef struct {
+    uint32_t hits;              ///< sectors found in the LRU slots
+    uint32_t misses;            ///< sectors read from the disk
+    uint32_t read_ahead_hits;   ///< sectors found in the read-ahead window
+    uint32_t read_ahead_fills;  ///< disk reads that refilled the window
+    uint32_t write_backs;       ///< dirty sectors written to the disk
+} FAT_CACHE_STATS;
+
+/** Sector cache between FatFs's disk_read/disk_write and a FATFileSystem
+ *
+ * Single sector requests, which is how FatFs reads and writes FAT and
+ * directory sectors, are kept in N least recently used slots. Writes stay
+ * in the slots until FatFs syncs the volume (disk_ioctl(CTRL_SYNC), from
+ * f_sync(), f_close() and friends), the slot is reused, or sync() is
+ * called, unless write through is selected.
+ *
+ * When a read misses straight after the previous one ended, the following
+ * sectors are fetched with one multiple sector read into a separate read
+ * ahead window, so streaming a file a sector at a time turns into a few
+ * long transfers without pushing the FAT out of the slots. Requests too big
+ * to be worth copying go straight to the disk.
+ *
+ * Anything that goes to the disk around FatFs, like
+ * SDFileSystem::read_start(), doesn't see dirty sectors until sync().
+ *
+ * @code
+ * SDFileSystem sd(p5, p6, p7, p8, "sd");
+ * FATSectorCache cache(&sd, 8, 4);   // 8 slots, 4 sectors of read ahead
+ * @endcode
+ */
+class FATSectorCache {
+public:
+
+    /** Attach a cache to a file system
+     *
+     * @param fs the file system whose disk is cached
+     * @param sectors number of LRU slots
+     * @param read_ahead sectors in the read-ahead window, 0 to turn it off
+     * @param memory (sectors + read_ahead) * 512 bytes to use, or NULL to allocate them
+     */
+    FATSectorCache(FATFileSystem *fs, int sectors, int read_ahead, uint8_t *memory = NULL);
+    ~FATSectorCache();
+
+    int read(uint8_t *buffer, uint64_t sector, uint32_t count);
+    int write(const uint8_t *buffer, uint64_t sector, uint32_t count);
+
+    /** Write dirty sectors back to the disk
+     *
+     * @returns 0 on success
+     */
+    int sync();
+
+    /** Drop everything cached, e.g. after the card has been changed; dirty sectors are lost */
+    void invalidate();
+
+    /** Pass writes straight to the disk, keeping a clean copy (default off) */
+    void write_through(int on);
+
+    void get_stats(FAT_CACHE_STATS *stats) { *stats = _stats; }
+    void reset_stats();
+
+protected:
+
+    int _find(uint32_t sector);
+    int _victim();
+    int _write_back(int slot);
+
+    FATFileSystem *_fs;
+    int _sectors;
+    int _read_ahead;
+    int _write_through;
+    uint8_t *_memory;
+    int _own_memory;
+
+    uint8_t *_data;         // _sectors slots of 512 bytes
+    uint32_t *_sector;      // sector held by each slot
+    uint32_t *_used;        // _clock when each slot was last used, 0 if empty
+    uint8_t *_dirty;
+    uint32_t _clock;
+
+    uint8_t *_ahead;        // read-ahead window
+    uint32_t _ahead_start;
+    uint32_t _ahead_count;  // valid sectors in the window
+    uint32_t _next;         // sector after the last read, for spotting sequential reads
+
+    FAT_CACHE_STATS _stats;
+};
+
+#endif
@@ -60,10 +60,13 @@
  * just always use the Standard Capacity cards with a block size of 512 bytes.
  * This is set with CMD16.
  *
- * You can read and write single blocks (CMD17, CMD25) or multiple blocks
- * (CMD18, CMD25). For simplicity, I'll just use single block accesses. When
- * the card gets a read command, it responds with a response token, and then
- * a data token or an error.
+ * You can read and write single blocks (CMD17, CMD24) or multiple blocks
+ * (CMD18, CMD25). Single sector requests use the single block commands;
+ * when FatFs asks for several consecutive sectors the multiple block
+ * commands are used, which saves a command/response handshake and the
+ * card's access time for every block after the first. When the card gets a
+ * read command, it responds with a response token, and then a data token or
+ * an error.
  *
  * SPI Command Format
  * ------------------
@@ -111,17 +114,81 @@
  * +------+---------+---------+- -  - -+---------+-----------+----------+
  * | 0xFE | data[0] | data[1] |        | data[n] | crc[15:8] | crc[7:0] |
  * +------+---------+---------+- -  - -+---------+-----------+----------+
+ *
+ * Multiple Block Read and Write
+ * -----------------------------
+ *
+ * After CMD18 the card sends data blocks back to back until it receives
+ * STOP_TRANSMISSION (CMD12), which is an R1b command: the card may hold
+ * the data line low (busy) after the response.
+ *
+ * After CMD25 every block starts with the 0xFC token instead of 0xFE and is
+ * acknowledged with a data response token and busy signal. The transfer
+ * ends with the Stop Tran token 0xFD, followed by busy while the card
+ * finishes programming.
+ *
+ * Background Reads
+ * ----------------
+ *
+ * read_start() sends CMD17/CMD18 and returns with CS still low; read_poll()
+ * then looks for each start token a few bytes at a time and hands the data
+ * block to the GPDMA, so the caller only spends time on the bus while it is
+ * polling. Channel 0 drains the SSP receive FIFO into the buffer and channel
+ * 1 feeds the transmit FIFO 0xFF bytes. Neither raises an interrupt (the
+ * DMA interrupt belongs to wave_player's DAC output on channel 7); a block
+ * is in when both channels have disabled themselves.
  */
 #include "SDFileSystem.h"
 #include "mbed_debug.h"
 
 #define SD_COMMAND_TIMEOUT 5000
 
+// fastest data clock to ask for; the SPI driver rounds down to a divider of
+// the SSP's PCLK
+#define SD_MAX_FREQUENCY   25000000
+
+// SSP status register bits
+#define SSP_TNF            (1 << 1)    // transmit FIFO not full
+#define SSP_RNE            (1 << 2)    // receive FIFO not empty
+#define SSP_FIFO_DEPTH     8
+
+// bytes read_poll() clocks looking for a start token before it returns,
+// and how many it looks at in all before giving up (100ms at 25MHz)
+#define SD_POLL_BYTES      16
+#define SD_READ_TIMEOUT    312500
+
+// background read states
+#define SD_ASYNC_IDLE      0
+#define SD_ASYNC_TOKEN     1    // waiting for the start token
+#define SD_ASYNC_DATA      2    // GPDMA moving a data block
+
+#if defined(TARGET_LPC176X) && defined(LPC_GPDMA)
+#define SD_DMA_RX          LPC_GPDMACH0    // highest priority, so the RX FIFO can't overrun
+#define SD_DMA_TX          LPC_GPDMACH1
+#define SD_DMA_CHANNELS    0x3
+#define SSP_DMACR_RX       (1 << 0)
+#define SSP_DMACR_TX       (1 << 1)
+
+// the GPDMA can only reach the AHB SRAM banks (see LPC1768.sct)
+#define AHB_SRAM_BASE      0x2007C000
+#define AHB_SRAM_SIZE      0x8000
+#if defined(__ARMCC_VERSION)
+static uint8_t sd_dma_ff __attribute__((section("AHBSRAM0")));
+#else
+static uint8_t sd_dma_ff;
+#endif
+#endif
+
 #define SD_DBG             0
 
 SDFileSystem::SDFileSystem(PinName mosi, PinName miso, PinName sclk, PinName cs, const char* name) :
     FATFileSystem(name), _spi(mosi, miso, sclk), _cs(cs) {
     _cs = 1;
+    _max_hz = 0;
+    _fifo = 1;
+    _dma = 1;
+    _async_state = SD_ASYNC_IDLE;
+    _async_result = 0;
 }
 
 #define R1_IDLE_STATE           (1 << 0)
@@ -210,11 +277,20 @@ int SDFileSystem::disk_initialize() {
         return 1;
     }
     
-    _spi.frequency(1000000); // Set to 1MHz for data transfer
+    // Run data transfers as fast as the card's CSD says it can go, 1MHz if
+    // the CSD couldn't be read
+    int hz = _max_hz ? _max_hz : 1000000;
+    if (hz > SD_MAX_FREQUENCY) {
+        hz = SD_MAX_FREQUENCY;
+    }
+    debug_if(SD_DBG, "data clock %d Hz\n", hz);
+    _spi.frequency(hz);
     return 0;
 }
 
 int SDFileSystem::disk_write(const uint8_t *buffer, uint64_t block_number) {
+    read_wait();
+    
     // set write address for single block (CMD24)
     if (_cmd(24, block_number * cdv) != 0) {
         return 1;
@@ -226,6 +302,8 @@ int SDFileSystem::disk_write(const uint8_t *buffer, uint64_t block_number) {
 }
 
 int SDFileSystem::disk_read(uint8_t *buffer, uint64_t block_number) {
+    read_wait();
+    
     // set read address for single block (CMD17)
     if (_cmd(17, block_number * cdv) != 0) {
         return 1;
@@ -236,10 +314,131 @@ int SDFileSystem::disk_read(uint8_t *buffer, uint64_t block_number) {
     return 0;
 }
 
+int SDFileSystem::disk_write_blocks(const uint8_t *buffer, uint64_t block_number, uint32_t count) {
+    if (count == 1) {
+        return disk_write(buffer, block_number);
+    }
+    read_wait();
+    
+    // set write address for multiple blocks (CMD25), keeping CS low
+    if (_cmdx(25, block_number * cdv) != 0) {
+        _cs = 1;
+        _spi.write(0xFF);
+        return 1;
+    }
+    
+    // send the data blocks
+    int err = 0;
+    for (uint32_t i = 0; i < count && !err; i++) {
+        err = _write_data(buffer, 512, 0xFC);
+        buffer += 512;
+    }
+    
+    // stop tran token, then wait for the card to finish programming
+    _spi.write(0xFD);
+    _spi.write(0xFF);
+    while (_spi.write(0xFF) == 0);
+    
+    _cs = 1;
+    _spi.write(0xFF);
+    return err;
+}
+
+int SDFileSystem::disk_read_blocks(uint8_t *buffer, uint64_t block_number, uint32_t count) {
+    if (count == 1) {
+        return disk_read(buffer, block_number);
+    }
+    read_wait();
+    
+    // set read address for multiple blocks (CMD18), keeping CS low
+    if (_cmdx(18, block_number * cdv) != 0) {
+        _cs = 1;
+        _spi.write(0xFF);
+        return 1;
+    }
+    
+    // receive the data
+    for (uint32_t i = 0; i < count; i++) {
+        _read_data(buffer, 512);
+        buffer += 512;
+    }
+    
+    // stop the card sending
+    if (_cmd12() != 0) {
+        return 1;
+    }
+    return 0;
+}
+
 int SDFileSystem::disk_status() { return 0; }
 int SDFileSystem::disk_sync() { return 0; }
 uint64_t SDFileSystem::disk_sectors() { return _sectors; }
 
+int SDFileSystem::read_start(uint8_t *buffer, uint64_t block_number, uint32_t count,
+                             void (*done)(void *context, int result), void *context) {
+    read_wait();
+    if (count == 0) {
+        return 1;
+    }
+    
+    // set read address, keeping CS low until the last block is in
+    _async_multi = count > 1;
+    if (_cmdx(_async_multi ? 18 : 17, block_number * cdv) != 0) {
+        _cs = 1;
+        _spi.write(0xFF);
+        return 1;
+    }
+    _async_buf = buffer;
+    _async_left = count;
+    _async_waited = 0;
+    _async_done = done;
+    _async_context = context;
+    _async_state = SD_ASYNC_TOKEN;
+    return 0;
+}
+
+int SDFileSystem::read_poll() {
+    if (_async_state == SD_ASYNC_TOKEN) {
+        int response = 0xFF;
+        for (int i = 0; i < SD_POLL_BYTES && response == 0xFF; i++) {
+            response = _spi.write(0xFF);
+        }
+        if (response == 0xFF) {
+            _async_waited += SD_POLL_BYTES;
+            if (_async_waited > SD_READ_TIMEOUT) {
+                debug_if(SD_DBG, "read timed out\n");
+                return _read_end(1);
+            }
+            return 1;
+        }
+        if (response != 0xFE) {
+            debug_if(SD_DBG, "read error token %02x\n", response);
+            return _read_end(1);
+        }
+        _async_waited = 0;
+        if (_dma_read_start(_async_buf, 512)) {
+            _async_state = SD_ASYNC_DATA;
+            return 1;
+        }
+        // the GPDMA can't reach the buffer
+        _spi_read_block(_async_buf, 512);
+        return _read_block_done();
+    }
+    if (_async_state == SD_ASYNC_DATA) {
+        if (_dma_busy()) {
+            return 1;
+        }
+        return _read_block_done();
+    }
+    return _async_result;
+}
+
+int SDFileSystem::read_wait() {
+    int r;
+    while ((r = read_poll()) == 1);
+    return r ? 1 : 0;
+}
+
 
 // PRIVATE FUNCTIONS
 int SDFileSystem::_cmd(int cmd, int arg) {
@@ -349,34 +548,66 @@ int SDFileSystem::_cmd8() {
     return -1; // timeout
 }
 
+int SDFileSystem::_cmd12() {
+    // STOP_TRANSMISSION goes out while the card is still sending data, so
+    // CS is already low and whatever comes back during the command is junk
+    _spi.write(0x40 | 12);
+    _spi.write(0x00);
+    _spi.write(0x00);
+    _spi.write(0x00);
+    _spi.write(0x00);
+    _spi.write(0x95);
+    _spi.write(0xFF); // stuff byte
+    
+    // wait for the repsonse (response[7] == 0)
+    for (int i = 0; i < SD_COMMAND_TIMEOUT; i++) {
+        int response = _spi.write(0xFF);
+        if (!(response & 0x80)) {
+            // R1b: wait while the card signals busy
+            while (_spi.write(0xFF) == 0);
+            _cs = 1;
+            _spi.write(0xFF);
+            return response;
+        }
+    }
+    _cs = 1;
+    _spi.write(0xFF);
+    return -1; // timeout
+}
+
 int SDFileSystem::_read(uint8_t *buffer, uint32_t length) {
     _cs = 0;
-    
-    // read until start byte (0xFF)
+    _read_data(buffer, length);
+    _cs = 1;
+    _spi.write(0xFF);
+    return 0;
+}
+
+int SDFileSystem::_read_data(uint8_t *buffer, uint32_t length) {
+    // read until start byte (0xFE)
     while (_spi.write(0xFF) != 0xFE);
     
     // read data
-    for (int i = 0; i < length; i++) {
-        buffer[i] = _spi.write(0xFF);
-    }
+    _spi_read_block(buffer, length);
     _spi.write(0xFF); // checksum
     _spi.write(0xFF);
-    
-    _cs = 1;
-    _spi.write(0xFF);
     return 0;
 }
 
 int SDFileSystem::_write(const uint8_t*buffer, uint32_t length) {
     _cs = 0;
-    
+    int err = _write_data(buffer, length, 0xFE);
+    _cs = 1;
+    _spi.write(0xFF);
+    return err;
+}
+
+int SDFileSystem::_write_data(const uint8_t *buffer, uint32_t length, int token) {
     // indicate start of block
-    _spi.write(0xFE);
+    _spi.write(token);
     
     // write the data
-    for (int i = 0; i < length; i++) {
-        _spi.write(buffer[i]);
-    }
+    _spi_write_block(buffer, length);
     
     // write the checksum
     _spi.write(0xFF);
@@ -384,16 +615,134 @@ int SDFileSystem::_write(const uint8_t*buffer, uint32_t length) {
     
     // check the response token
     if ((_spi.write(0xFF) & 0x1F) != 0x05) {
-        _cs = 1;
-        _spi.write(0xFF);
         return 1;
     }
     
     // wait for write to finish
     while (_spi.write(0xFF) == 0);
-    
+    return 0;
+}
+
+// _spi.write() waits for each byte to come back before the next one goes
+// out, so the bus sits idle for the call and FIFO polling between bytes.
+// For data blocks the SSP FIFO is kept topped up instead, never with more
+// bytes in flight than the receive FIFO can hold.
+void SDFileSystem::_spi_read_block(uint8_t *buffer, uint32_t length) {
+#if defined(TARGET_LPC176X)
+    if (_fifo) {
+        LPC_SSP_TypeDef *ssp = _spi.ssp();
+        uint32_t tx = 0, rx = 0;
+        while (rx < length) {
+            if (tx < length && tx - rx < SSP_FIFO_DEPTH && (ssp->SR & SSP_TNF)) {
+                ssp->DR = 0xFF;
+                tx++;
+            }
+            if (ssp->SR & SSP_RNE) {
+                buffer[rx++] = ssp->DR;
+            }
+        }
+        return;
+    }
+#endif
+    for (uint32_t i = 0; i < length; i++) {
+        buffer[i] = _spi.write(0xFF);
+    }
+}
+
+void SDFileSystem::_spi_write_block(const uint8_t *buffer, uint32_t length) {
+#if defined(TARGET_LPC176X)
+    if (_fifo) {
+        LPC_SSP_TypeDef *ssp = _spi.ssp();
+        uint32_t tx = 0, rx = 0;
+        while (rx < length) {
+            if (tx < length && tx - rx < SSP_FIFO_DEPTH && (ssp->SR & SSP_TNF)) {
+                ssp->DR = buffer[tx++];
+            }
+            if (ssp->SR & SSP_RNE) {
+                // read to pop the byte sent back
+                (void)(uint32_t)ssp->DR;
+                rx++;
+            }
+        }
+        return;
+    }
+#endif
+    for (uint32_t i = 0; i < length; i++) {
+        _spi.write(buffer[i]);
+    }
+}
+
+// a data block is in: skip the CRC, then wait for the next block or end
+// the read
+int SDFileSystem::_read_block_done() {
+    _spi.write(0xFF); // checksum
+    _spi.write(0xFF);
+    _async_buf += 512;
+    if (--_async_left) {
+        _async_state = SD_ASYNC_TOKEN;
+        return 1;
+    }
+    if (_async_multi) {
+        return _read_end(_cmd12() != 0);
+    }
     _cs = 1;
     _spi.write(0xFF);
+    return _read_end(0);
+}
+
+int SDFileSystem::_read_end(int err) {
+    if (err) {
+        _cs = 1;
+        _spi.write(0xFF);
+    }
+    _async_state = SD_ASYNC_IDLE;
+    _async_result = err ? -1 : 0;
+    if (_async_done) {
+        _async_done(_async_context, err);
+    }
+    return err ? -1 : 0;
+}
+
+// Start the GPDMA on one data block; returns 0 if it can't be used
+int SDFileSystem::_dma_read_start(uint8_t *buffer, uint32_t length) {
+#if defined(TARGET_LPC176X) && defined(LPC_GPDMA)
+    if (!_dma || (uint32_t)buffer - AHB_SRAM_BASE >= AHB_SRAM_SIZE) {
+        return 0;
+    }
+    LPC_SSP_TypeDef *ssp = _spi.ssp();
+    int tx_req = ssp == LPC_SSP0 ? 0 : 2;   // SSPn Tx request line, Rx is the next one
+    
+    LPC_SC->PCONP |= 1 << 29;                // power up the GPDMA
+    LPC_GPDMA->DMACConfig = 1;               // enable, little endian
+    LPC_GPDMA->DMACIntTCClear = SD_DMA_CHANNELS;
+    LPC_GPDMA->DMACIntErrClr = SD_DMA_CHANNELS;
+    sd_dma_ff = 0xFF;
+    
+    // byte wide single transfers; only the receive side's address moves
+    SD_DMA_RX->DMACCSrcAddr = (uint32_t)&ssp->DR;
+    SD_DMA_RX->DMACCDestAddr = (uint32_t)buffer;
+    SD_DMA_RX->DMACCLLI = 0;
+    SD_DMA_RX->DMACCControl = length | (1 << 27);                 // destination increment
+    SD_DMA_RX->DMACCConfig = 1 | ((tx_req + 1) << 1) | (2 << 11); // enable, peripheral to memory
+    SD_DMA_TX->DMACCSrcAddr = (uint32_t)&sd_dma_ff;
+    SD_DMA_TX->DMACCDestAddr = (uint32_t)&ssp->DR;
+    SD_DMA_TX->DMACCLLI = 0;
+    SD_DMA_TX->DMACCControl = length;
+    SD_DMA_TX->DMACCConfig = 1 | (tx_req << 6) | (1 << 11);       // enable, memory to peripheral
+    ssp->DMACR = SSP_DMACR_RX | SSP_DMACR_TX;
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+int SDFileSystem::_dma_busy() {
+#if defined(TARGET_LPC176X) && defined(LPC_GPDMA)
+    if (LPC_GPDMA->DMACEnbldChns & SD_DMA_CHANNELS) {
+        return 1;
+    }
+    _spi.ssp()->DMACR = 0;
+#endif
     return 0;
 }
 
@@ -410,6 +759,18 @@ static uint32_t ext_bits(unsigned char *data, int msb, int lsb) {
     return bits;
 }
 
+// TRAN_SPEED : csd[103:96], a transfer rate unit in bits 2:0 (100kbit/s
+// times a power of 10) and a multiplier in tenths in bits 6:3.  Every SD
+// card reports 0x32, 25MHz; high speed cards report 0x5A, 50MHz.
+static int tran_speed_hz(uint32_t tran_speed) {
+    static const int unit[4] = {100000, 1000000, 10000000, 100000000};
+    static const int value[16] = {0, 10, 12, 13, 15, 20, 25, 30, 35, 40, 45, 50, 55, 60, 70, 80};
+    if ((tran_speed & 7) > 3) {
+        return 0;
+    }
+    return unit[tran_speed & 7] / 10 * value[(tran_speed >> 3) & 15];
+}
+
 uint64_t SDFileSystem::_sd_sectors() {
     uint32_t c_size, c_size_mult, read_bl_len;
     uint32_t block_len, mult, blocknr, capacity;
@@ -429,11 +790,13 @@ uint64_t SDFileSystem::_sd_sectors() {
     }
     
     // csd_structure : csd[127:126]
+    // tran_speed    : csd[103:96]
     // c_size        : csd[73:62]
     // c_size_mult   : csd[49:47]
     // read_bl_len   : csd[83:80] - the *maximum* read block length
     
     int csd_structure = ext_bits(csd, 127, 126);
+    _max_hz = tran_speed_hz(ext_bits(csd, 103, 96));
     
     switch (csd_structure) {
         case 0:
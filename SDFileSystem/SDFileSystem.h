@@ -40,6 +40,17 @@
  *     fclose(fp);
  * }
  */
+/** SPI with access to the SSP block behind it, so that data blocks can be
+ *  moved with the FIFO kept full
+ */
+class SDFileSystemSPI : public SPI {
+public:
+    SDFileSystemSPI(PinName mosi, PinName miso, PinName sclk) : SPI(mosi, miso, sclk) {}
+#if defined(TARGET_LPC176X)
+    LPC_SSP_TypeDef *ssp() { return _spi.spi; }
+#endif
+};
+
 class SDFileSystem : public FATFileSystem {
 public:
 
@@ -56,25 +67,79 @@ public:
     virtual int disk_status();
     virtual int disk_read(uint8_t * buffer, uint64_t block_number);
     virtual int disk_write(const uint8_t * buffer, uint64_t block_number);
+    virtual int disk_read_blocks(uint8_t * buffer, uint64_t block_number, uint32_t count);
+    virtual int disk_write_blocks(const uint8_t * buffer, uint64_t block_number, uint32_t count);
     virtual int disk_sync();
     virtual uint64_t disk_sectors();
 
+    /** Start reading sectors in the background
+     *
+     * Data blocks are moved by the GPDMA while the caller gets on with
+     * something else, when buffer is in AHB SRAM (the GPDMA cannot reach the
+     * CPU's local SRAM); otherwise each block goes through the SSP FIFO
+     * inside read_poll(). Any other disk access first waits for the read to
+     * finish.
+     *
+     * @param buffer where to put count * 512 bytes
+     * @param block_number first sector to read
+     * @param count number of sectors
+     * @param done optional, called from read_poll() with 0, or 1 on error, once the read has finished
+     * @param context passed to done
+     * @returns 0 if the read was started, 1 if the card refused the command
+     */
+    int read_start(uint8_t * buffer, uint64_t block_number, uint32_t count,
+                   void (*done)(void *context, int result) = 0, void *context = 0);
+    
+    /** Move a background read along; call it from the main loop
+     *
+     * @returns 1 while the read is in progress, 0 once it has finished, -1 if it failed
+     */
+    int read_poll();
+    
+    /** Finish a background read
+     *
+     * @returns 0 on success, 1 if the read failed
+     */
+    int read_wait();
+
 protected:
 
     int _cmd(int cmd, int arg);
     int _cmdx(int cmd, int arg);
     int _cmd8();
     int _cmd58();
+    int _cmd12();
     int initialise_card();
     int initialise_card_v1();
     int initialise_card_v2();
     
     int _read(uint8_t * buffer, uint32_t length);
     int _write(const uint8_t *buffer, uint32_t length);
+    int _read_data(uint8_t * buffer, uint32_t length);
+    int _write_data(const uint8_t *buffer, uint32_t length, int token);
+    void _spi_read_block(uint8_t *buffer, uint32_t length);
+    void _spi_write_block(const uint8_t *buffer, uint32_t length);
+    int _read_block_done();
+    int _read_end(int err);
+    int _dma_read_start(uint8_t *buffer, uint32_t length);
+    int _dma_busy();
     uint64_t _sd_sectors();
     uint64_t _sectors;
+    int _max_hz;    // fastest clock the card allows, from the CSD
+    int _fifo;      // move data blocks through the SSP FIFO
+    int _dma;       // let the GPDMA move background reads
+    
+    // background read, see read_start()
+    uint8_t *_async_buf;
+    uint32_t _async_left;   // blocks still to come
+    uint32_t _async_waited; // bytes polled for the current start token
+    int _async_state;
+    int _async_multi;       // CMD18, ended with CMD12
+    int _async_result;
+    void (*_async_done)(void *context, int result);
+    void *_async_context;
     
-    SPI _spi;
+    SDFileSystemSPI _spi;
     DigitalOut _cs;
     int cdv;
 };
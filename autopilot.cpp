@@ -0,0 +1,126 @@
+// ============================================
+// The file implement the autopilot module
+// Fall 2016 Gatech ECE 2035
+//=============================================
+
+#include "autopilot_private.h"
+
+void autopilot_input(GAME_WORLD* world, GAME_INPUT* input)
+{
+    PLAYER* player = &world->player;
+    int shooter = player->x + player->width/2;
+    int launch = player->y - player->delta;     // where player_fire() starts a shot
+    MISSILE* target = NULL;
+    
+    input->frame = world->frame;
+    input->tilt = 0;
+    input->fires = 0;
+    input->held = 0;
+    if(player->status != ALIVE)
+        return;
+    
+    // step out from under a missile about to land on the player
+    if(autopilot_threat(world, player->x)) {
+        int step = player->delta*AUTOPILOT_DODGE_FRAMES;
+        if(player->x + step <= PLAYER_MAX_X && !autopilot_threat(world, player->x + step))
+            input->tilt = AUTOPILOT_TILT;
+        else
+            input->tilt = -AUTOPILOT_TILT;
+        return;
+    }
+    
+    // the missile to hit a city soonest that a shot can still stop and
+    // none in flight will; failing that, the lowest
+    MISSILE* threats[AUTOPILOT_THREATS];
+    int found = missile_threats(world, threats, AUTOPILOT_THREATS);
+    for(int i = 0; i < found && target == NULL; i++)
+        if(autopilot_open(world, threats[i], launch))
+            target = threats[i];
+    if(target == NULL) {
+        for(int i = 0; i < MAX_MISSILES; i++) {
+            MISSILE* missile = &world->missiles.missile[i];
+            if(missile->status == MISSILE_ACTIVE && (target == NULL || missile->y > target->y) &&
+               autopilot_open(world, missile, launch))
+                target = missile;
+        }
+    }
+    if(target == NULL)
+        return;
+    
+    if(autopilot_hits(world, target, shooter, launch)) {
+        input->fires = 1;
+        return;
+    }
+    // move towards where a shot will meet it, but not under a missile
+    int frames;
+    int aim = missile_intercept(world, target, launch, PLAYER_MISSILE_SPEED, &frames);
+    if(aim < shooter - player->delta/2 - 1 && !autopilot_threat(world, player->x - player->delta))
+        input->tilt = -AUTOPILOT_TILT;
+    else if(aim > shooter + player->delta/2 + 1 && !autopilot_threat(world, player->x + player->delta))
+        input->tilt = AUTOPILOT_TILT;
+}
+
+/** 1 if a missile will land on the player, were it at x, within
+    AUTOPILOT_DODGE_FRAMES; the test is checkCollisions()'
+*/
+int autopilot_threat(GAME_WORLD* world, int x)
+{
+    int y = world->player.y;
+    int mx, my;
+    for(int i = 0; i < MAX_MISSILES; i++) {
+        const MISSILE* missile = &world->missiles.missile[i];
+        if(missile->status != MISSILE_ACTIVE)
+            continue;
+        for(int k = 1; k <= AUTOPILOT_DODGE_FRAMES; k++) {
+            missile_position(world, missile, missile->tick + k - 1, &mx, &my);
+            if(my - y < 1 && y - my < 5 && x - mx < 1 && mx - x < 5)
+                return 1;
+        }
+    }
+    return 0;
+}
+
+/** 1 if a shot from height y can still meet the missile, and no shot in
+    flight will hit it
+*/
+int autopilot_open(GAME_WORLD* world, const MISSILE* missile, int y)
+{
+    int frames;
+    if(missile_intercept(world, missile, y, PLAYER_MISSILE_SPEED, &frames) < 0)
+        return 0;
+    for(int j = 0; j < MAX_PLAYER_MISSILES; j++) {
+        PLAYER_MISSILE* shot = &world->player.playerMissiles[j];
+        if(shot->status == PMISSILE_ACTIVE && autopilot_hits(world, missile, shot->x, shot->y))
+            return 0;
+    }
+    return 1;
+}
+
+/** 1 if an interceptor now at x, y hits the missile as both fly on
+    Each frame the missile moves first and then the interceptor climbs,
+    and then checkCollisions() compares them. Only the frames around
+    where their paths cross are stepped through.
+*/
+int autopilot_hits(GAME_WORLD* world, const MISSILE* missile, int x, int y)
+{
+    int mx, my, k, back = 0;
+    if(missile_intercept(world, missile, y, PLAYER_MISSILE_SPEED, &k) < 0)
+        return 0;
+    // below the crossing the shot gains at least PLAYER_MISSILE_SPEED a
+    // frame on the missile, so it is out of reach this many frames before
+    while(back*back*PLAYER_MISSILE_SPEED*PLAYER_MISSILE_SPEED < world->missileMissileTolerance)
+        back++;
+    for(k = k > back ? k - back : 1; y - k*PLAYER_MISSILE_SPEED >= 0; k++) {
+        if(missile->path.impact >= 0 && missile->tick + k - 1 > missile->path.impact)
+            return 0;
+        int dy = y - k*PLAYER_MISSILE_SPEED;
+        missile_position(world, missile, missile->tick + k - 1, &mx, &my);
+        dy -= my;
+        if((x-mx)*(x-mx) + dy*dy < world->missileMissileTolerance)
+            return 1;
+        // above the missile and still climbing away from it
+        if(dy < 0 && dy*dy >= world->missileMissileTolerance)
+            return 0;
+    }
+    return 0;
+}
@@ -0,0 +1,23 @@
+// ============================================
+// The header file is for module "autopilot"
+// Fall 2016 Gatech ECE 2035
+//=============================================
+#ifndef AUTOPILOT_PRIVATE_H
+#define AUTOPILOT_PRIVATE_H
+
+#include "mbed.h"
+#include "missile_public.h"
+#include "player_public.h"
+#include "autopilot_public.h"
+
+//==== [private settings] ====
+#define AUTOPILOT_TILT 1000     // thousandths of a G, past GAME_TILT_MOVE
+#define AUTOPILOT_DODGE_FRAMES 3    // how far ahead a missile on the player is seen
+#define AUTOPILOT_THREATS 4     // missiles headed for cities looked at, soonest first
+
+//==== [private function] ====
+int autopilot_threat(GAME_WORLD* world, int x);
+int autopilot_open(GAME_WORLD* world, const MISSILE* missile, int y);
+int autopilot_hits(GAME_WORLD* world, const MISSILE* missile, int x, int y);
+
+#endif //AUTOPILOT_PRIVATE_H
@@ -0,0 +1,22 @@
+// ============================================
+// The header file is for module "autopilot"
+// A player that needs no one at the controls, for soak and load tests:
+// it works out where each missile will be and shoots it down
+// Fall 2016 Gatech ECE 2035
+//=============================================
+/** @file autopilot_public.h */
+#ifndef AUTOPILOT_PUBLIC_H
+#define AUTOPILOT_PUBLIC_H
+
+#include "game_public.h"
+
+/** Work out the controls for the next game_input(), in place of the board's.
+    The target is the missile to hit a city soonest that no interceptor in
+    flight will hit, or the lowest if none is headed for a city: the player
+    moves under where a shot will meet it, and fires once a shot from where
+    it stands would hit it. Only the world is read, so a game played
+    by the autopilot is recorded and replayed like any other.
+*/
+void autopilot_input(GAME_WORLD* world, GAME_INPUT* input);
+
+#endif //AUTOPILOT_PUBLIC_H
@@ -6,12 +6,12 @@
 
 #include "city_landscape_private.h"
 
-CITY city_record[MAX_NUM_CITY];
-int building_height[NUM_BUILDING];
-
 // See the comments in city_landscape_public.h
-void city_landscape_init(int num_city) {
+void city_landscape_init(GAME_WORLD* world, int num_city) {
+    CITY* city_record = world->cities.city_record;
+    int* building_height = world->cities.building_height;
     int i;
+    RNG skyline;
     int city_distance = (SIZE_X-CITY_TO_SCREEN_MARGIN*2)/num_city;
     
     // All interface for user should have error checking
@@ -32,26 +32,28 @@ void city_landscape_init(int num_city) {
         }
     }
     
-    //initialize the height of the buildings
-    srand(1);
+    //initialize the height of the buildings, the same every game
+    rng_seed(&skyline, 1);
     for(i=0;i<NUM_BUILDING;i++){
-        building_height[i] = (rand() % MAX_BUILDING_HEIGHT*2/3)+MAX_BUILDING_HEIGHT/3;
+        building_height[i] = (rng_range(&skyline, MAX_BUILDING_HEIGHT)*2/3)+MAX_BUILDING_HEIGHT/3;
     }
     
     //draw city landscape on the screen
-    draw_cities();
+    draw_cities(world);
     draw_landscape();
 
 }
 
-CITY city_get_info(int index){
+CITY city_get_info(GAME_WORLD* world, int index){
     // All interface for user should have error checking
     ASSERT_P(index<MAX_NUM_CITY,ERROR_CITY_INDEX_GET_INFO);
     
-    return city_record[index];
+    return world->cities.city_record[index];
 }
 
-void city_destory(int index){
+void city_destory(GAME_WORLD* world, int index){
+    CITY* city_record = world->cities.city_record;
+    int* building_height = world->cities.building_height;
     int j;
     int city_x, city_y, building_x, building_y;
     int height;
@@ -73,10 +75,13 @@ void city_destory(int index){
     }
 }
 
-void draw_cities(void){
+void draw_cities(GAME_WORLD* world){
+    CITY* city_record = world->cities.city_record;
+    int* building_height = world->cities.building_height;
     int i,j;
     int city_x, city_y, building_x, building_y;
     int height;
+    PROFILE_BEGIN(start);
     
     for(i=0;i<MAX_NUM_CITY;i++){
         
@@ -94,6 +99,7 @@ void draw_cities(void){
             }
         }
     }
+    PROFILE_END(start, PROFILE_DRAW_CITIES);
 }
 
 void draw_landscape(void){
@@ -9,6 +9,8 @@
 #include "mbed.h"
 #include "globals.h"
 #include "city_landscape_public.h"
+#include "game_public.h"
+#include "profile_public.h"
 
 //==== [private type] ====
 // N/A
@@ -28,9 +30,7 @@
 // You could modify these settings, but try to keep them be used only inside city_landscape.cpp
 // Here are the settings to define the looking of your city landscape
 #define CITY_TO_SCREEN_MARGIN 25 // pixel on the screen
-#define CITY_WIDTH 10 // pixel on the screen
-#define BUILDING_WIDTH 2 // pixel on the screen
-#define NUM_BUILDING (CITY_WIDTH/BUILDING_WIDTH)
+// CITY_WIDTH and BUILDING_WIDTH are in city_landscape_public.h, for CITY_STATE
 #define BUILDING_COLOR 0x00FF00
 #define LANDSCAPE_COLOR 0xCCAA00
 
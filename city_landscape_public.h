@@ -23,27 +23,39 @@ typedef struct {
 } CITY;
 
 #define MAX_NUM_CITY 6
+#define CITY_WIDTH 10 // pixel on the screen
+#define BUILDING_WIDTH 2 // pixel on the screen
+#define NUM_BUILDING (CITY_WIDTH/BUILDING_WIDTH)
 
-/** Call city_landscape_init() only once at the begining of your code
+/// The city landscape module's part of a GAME_WORLD
+typedef struct {
+    CITY city_record[MAX_NUM_CITY];
+    int building_height[NUM_BUILDING];
+} CITY_STATE;
+
+/// All of one game's state, see game_public.h
+typedef struct GAME_WORLD GAME_WORLD;
+
+/** Call city_landscape_init() at the begining of each game
     @param num_city number of city to be draw. It must be less/equal to MAX_NUM_CITY.
 */
-void city_landscape_init(int num_city);
+void city_landscape_init(GAME_WORLD* world, int num_city);
 
 /** Get the information of city
     @param index The index in city_record. It must be smaller than MAX_NUM_CITY.
     @return The structure of city information
 */
-CITY city_get_info(int index);
+CITY city_get_info(GAME_WORLD* world, int index);
 
 /** Remove the city from record and screen
     @param index The index in city_record. It must be smaller than MAX_NUM_CITY.
 */
-void city_destory(int index);
+void city_destory(GAME_WORLD* world, int index);
 
 /** Draw all exist cities onto the screen
     @brief You might not need to use this function, but you could still use it if you want.
 */
-void draw_cities(void);
+void draw_cities(GAME_WORLD* world);
 
 /** Draw the landscape
     @brief You might not need to use this function, but you could still use it if you want.
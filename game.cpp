@@ -0,0 +1,228 @@
+// ============================================
+// The file implement the game module
+// Fall 2016 Gatech ECE 2035
+//=============================================
+
+#include "game_private.h"
+
+LEVEL_INFO game_levels[GAME_LEVELS] = {
+    // speed, interval, missile tolerance, player tolerance
+    { 7, 60, 90, 10 },
+    { 5, 40, 80, 12 },
+    { 3, 20, 60, 13 },
+    { 1, 10, 40, 15 },
+};
+
+void game_start(GAME_WORLD* world, int start_level, uint32_t seed)
+{
+    world->numMissilesDestroyed = 0;
+    world->level = start_level;
+    world->numCities = GAME_CITIES;
+    world->numLives = GAME_LIVES;
+    world->isGameOver = 0;
+    world->score = 0;
+    world->frame = 0;
+    memset(&world->gameInput, 0, sizeof(world->gameInput));
+    rng_seed(&world->rng, seed);
+    
+    city_landscape_init(world, world->numCities);
+    player_init(world);
+    missile_init(world);
+    getLevelInfo(world);
+}
+
+// A snapshot must fit GAME_SNAPSHOT_BUDGET: fails to compile (array of
+// negative size) when the world grows past it
+typedef char game_snapshot_fits_budget[sizeof(GAME_SNAPSHOT) <= GAME_SNAPSHOT_BUDGET ? 1 : -1];
+
+void game_save(const GAME_WORLD* world, GAME_SNAPSHOT* snapshot)
+{
+    snapshot->magic = GAME_SNAPSHOT_MAGIC;
+    snapshot->size = sizeof(GAME_WORLD);
+    memcpy(&snapshot->world, world, sizeof(GAME_WORLD));
+}
+
+int game_restore(GAME_WORLD* world, const GAME_SNAPSHOT* snapshot)
+{
+    if(snapshot->magic != GAME_SNAPSHOT_MAGIC || snapshot->size != sizeof(GAME_WORLD))
+        return -1;
+    memcpy(world, &snapshot->world, sizeof(GAME_WORLD));
+    return 0;
+}
+
+void game_restart(GAME_WORLD* world, const GAME_SNAPSHOT* start, int start_level, uint32_t seed)
+{
+    if(game_restore(world, start) != 0) {
+        game_start(world, start_level, seed);
+        return;
+    }
+    world->level = start_level;
+    rng_seed(&world->rng, seed);
+    getLevelInfo(world);
+    game_draw(world);
+}
+
+void game_draw(GAME_WORLD* world)
+{
+    draw_landscape();
+    draw_cities(world);
+    player_redraw(world);
+    missile_redraw(world);
+}
+
+void game_input(GAME_WORLD* world, const GAME_INPUT* input)
+{
+    world->gameInput = *input;
+    for(int i = 0; i < input->fires; i++)
+        player_fire(world);
+    if(input->tilt < -GAME_TILT_MOVE) {
+        player_moveLeft(world);   
+    }
+    else if(input->tilt > GAME_TILT_MOVE) {
+        player_moveRight(world);   
+    }
+}
+
+int game_step(GAME_WORLD* world)
+{
+    getLevelInfo(world);
+    
+    // 1. Update missiles
+    missile_generator(world);
+    player_missile_draw(world);
+    // 2. Check for collisions
+    checkCollisions(world);
+    checkCityCollisions(world);
+    // 3. Check for endgame
+    if(world->player.status == DESTROYED || world->numCities <= 0)
+        world->isGameOver = 1;
+    if((world->numMissilesDestroyed >= GAME_MISSILES_PER_LEVEL || ((world->gameInput.held & (1 << BUTTON_LEFT)) && (world->gameInput.held & (1 << BUTTON_RIGHT)))) && world->level < GAME_LEVELS)
+        nextLevel(world);
+    world->frame++;
+    if(world->isGameOver)
+        world->score = (world->level*10) + world->numMissilesDestroyed;
+    return world->isGameOver;
+}
+
+void checkCollisions(GAME_WORLD* world) {
+    int playerX;
+    int playerY;
+    int missileX;
+    int missileY;
+    double distance;
+    int midX, midY;
+    PROFILE_BEGIN(start);
+    
+    //Check missile collisions with other missiles. 
+    for(int i = 0; i < MAX_MISSILES; i++) {
+        MISSILE* eMissile = &world->missiles.missile[i];
+        if(eMissile->status != MISSILE_ACTIVE)
+            continue;
+        missileX = eMissile->x;
+        missileY = eMissile->y;
+        // every interceptor against every missile
+        for(int j = 0; j < MAX_PLAYER_MISSILES && eMissile->status == MISSILE_ACTIVE; j++) {
+            PLAYER_MISSILE* pMissile = &world->player.playerMissiles[j];
+            if(pMissile->status != PMISSILE_ACTIVE)
+                continue;
+            playerX = pMissile->x;
+            playerY = pMissile->y;
+            //calculations
+            distance = (playerX-missileX)*(playerX-missileX) + (playerY-missileY)*(playerY-missileY);
+            midX = (playerX + missileX)/2;
+            midY = (playerY + missileY)/2;
+            //Missile Collision happened.
+            if(distance < world->missileMissileTolerance) { 
+                eMissile->status = MISSILE_EXPLODED;
+                pMissile->status = PMISSILE_EXPLODED;
+                uLCD.circle(midX,midY,3,0x800003);
+                wait(.1);
+                uLCD.circle(midX,midY,3,0x000000);
+                wait(.1);
+                uLCD.circle(midX,midY,5,0x800003);
+                wait(.1);
+                uLCD.circle(midX,midY,5,0x000000);
+                world->numMissilesDestroyed++;
+            }
+        }
+        
+        //check collisions with player
+        //(player.x)-(missile->x)<1 && missile->x - player.x <playerMissileRad  && (player.y)-(missile->y)<5 && missile->y - player.y <1
+        //(player.x)-(missile->x)<1 && missile->x - player.x <pMRad  && (player.y)-(missile->y)<5 && missile->y - player.y <1)
+        if((missileY - world->player.y < 1 && (world->player.y - missileY) < 5) && ((world->player.x - missileX) < 1 && (missileX - world->player.x) < 5)) {
+            world->numLives--;
+            if(world->numLives == 0)
+                world->player.status = DESTROYED;
+            eMissile->status = MISSILE_EXPLODED;
+        }
+        
+        if(missileY > 128)
+            eMissile->status = MISSILE_EXPLODED;
+    }
+    PROFILE_END(start, PROFILE_CHECK_COLLISIONS);
+}
+
+void checkCityCollisions(GAME_WORLD* world)
+{
+    int i, xMin, xMax, y;
+    PROFILE_BEGIN(start);
+    for(int m = 0; m < MAX_MISSILES; m++)
+    {
+        MISSILE* eMissile = &world->missiles.missile[m];
+        for(i = 0; i <= 4 && eMissile->status == MISSILE_ACTIVE; i++)
+        {
+            CITY city = city_get_info(world, i);
+            if(city.status == DESTORIED)
+                continue;
+            xMin = city.x;
+            xMax = xMin + city.width;
+            y = 128-city.height;    
+            if(xMin-(eMissile->x)<1 && eMissile->x - xMax <1  && y-(eMissile->y)<1 && 128-eMissile->y>0){
+                eMissile->status = MISSILE_EXPLODED;
+                city.status = DESTORIED; 
+                city_destory(world, i);
+                world->numCities--;
+                missile_replan(world);
+                int X = (xMin + xMax)/2;
+                int Y = y;
+                uLCD.circle(X,Y,3,0x800003);
+                wait(.1);
+                uLCD.circle(X,Y,3,0x000000);
+                wait(.1);
+                uLCD.circle(X,Y,5,0x800003);
+                wait(.1);
+                uLCD.circle(X,Y,5,0x000000);
+                wait(.1);
+                uLCD.circle(X,Y,7,0x800003);
+                wait(.1);
+                uLCD.circle(X,Y,7,0x000000);
+                wait(.1);
+                uLCD.circle(X,Y,10,0x800003);
+                wait(.1);
+                uLCD.circle(X,Y,10,0x000000);
+            }
+        } 
+    }
+    PROFILE_END(start, PROFILE_CHECK_CITY_COLLISIONS);
+}
+
+void nextLevel(GAME_WORLD* world) {
+    //clear the missiles from the screen. 
+    for(int i = 0; i < MAX_MISSILES; i++) {
+        if(world->missiles.missile[i].status == MISSILE_ACTIVE)
+            world->missiles.missile[i].status = MISSILE_EXPLODED;
+    }
+    if(world->level != GAME_LEVELS)
+        world->level++;
+    world->numMissilesDestroyed = 0;
+    getLevelInfo(world);
+}
+
+void getLevelInfo(GAME_WORLD* world) {
+    // out of range levels play like level 2
+    const LEVEL_INFO* info = &game_levels[(world->level >= 1 && world->level <= GAME_LEVELS ? world->level : 2) - 1];
+    set_missile_speed(world, info->missile_speed);
+    set_missile_interval(world, info->missile_interval);
+    world->missileMissileTolerance = info->missile_tolerance;
+    world->missilePlayerTolerance = info->player_tolerance;
+}
@@ -0,0 +1,28 @@
+// ============================================
+// The header file is for module "game"
+// Fall 2016 Gatech ECE 2035
+//=============================================
+#ifndef GAME_PRIVATE_H
+#define GAME_PRIVATE_H
+
+#include "mbed.h"
+#include "globals.h"
+#include "city_landscape_public.h"
+#include "missile_public.h"
+#include "input_public.h"
+#include "game_public.h"
+#include "profile_public.h"
+
+//==== [private settings] ====
+#define GAME_CITIES 4
+#define GAME_LIVES 3
+#define GAME_MISSILES_PER_LEVEL 10
+#define GAME_TILT_MOVE 500      // thousandths of a G
+
+//==== [private function] ====
+void checkCollisions(GAME_WORLD* world);
+void checkCityCollisions(GAME_WORLD* world);
+void nextLevel(GAME_WORLD* world);
+void getLevelInfo(GAME_WORLD* world);
+
+#endif //GAME_PRIVATE_H
@@ -0,0 +1,102 @@
+// ============================================
+// The header file is for module "game"
+// The rules of the game: one frame at a time, from the controls' input,
+// with no timing or hardware of its own, so it runs the same on the
+// board, in a replay, or on the host
+// Fall 2016 Gatech ECE 2035
+//=============================================
+/** @file game_public.h */
+#ifndef GAME_PUBLIC_H
+#define GAME_PUBLIC_H
+
+#include <stdint.h>
+#include "rng_public.h"
+#include "missile_public.h"
+#include "player_public.h"
+#include "city_landscape_public.h"
+
+#define GAME_LEVELS 4
+
+/// What the controls gave the game before a frame
+typedef struct {
+    uint32_t frame;     ///< The frame it was applied before
+    int16_t tilt;       ///< Left/right tilt in thousandths of a G
+    uint8_t fires;      ///< Fire presses and repeats
+    uint8_t held;       ///< Buttons held down, bit (1<<BUTTON)
+} GAME_INPUT;
+
+/// How hard a level is
+typedef struct {
+    int missile_speed;      ///< See set_missile_speed()
+    int missile_interval;   ///< See set_missile_interval()
+    int missile_tolerance;  ///< Squared distance at which an interceptor hits a missile
+    int player_tolerance;
+} LEVEL_INFO;
+
+/// Levels 1 to GAME_LEVELS; other levels play like level 2
+extern LEVEL_INFO game_levels[GAME_LEVELS];
+
+/// All of one game's state.  Every module function takes the world it
+/// works on, so worlds are independent of each other.  A world holds no
+/// pointers, only fixed pools, so it can be copied as it is: see
+/// GAME_SNAPSHOT.  game_start() sets every field.
+struct GAME_WORLD {
+    MISSILE_STATE missiles;
+    PLAYER player;
+    CITY_STATE cities;
+    RNG rng;                        ///< The game's random numbers
+    int numMissilesDestroyed;       ///< On this level
+    int level;
+    int numCities;
+    int numLives;
+    int isGameOver;
+    int score;                      ///< Set when the game ends
+    unsigned frame;                 ///< Frames played
+    int missileMissileTolerance;
+    int missilePlayerTolerance;
+    GAME_INPUT gameInput;           ///< The last input applied
+};
+
+/** Start a new game: cities, player and missiles are set up and drawn
+    @param start_level The level to play first
+    @param seed The same seed and input give the same game
+*/
+void game_start(GAME_WORLD* world, int start_level, uint32_t seed);
+
+/** Apply the controls: fire, and move the player */
+void game_input(GAME_WORLD* world, const GAME_INPUT* input);
+
+/** Play one frame
+    @return 1 once the game is over
+*/
+int game_step(GAME_WORLD* world);
+
+#define GAME_SNAPSHOT_MAGIC 0x534D4347      // "GCMS"
+#define GAME_SNAPSHOT_BUDGET 1536           // bytes of RAM a snapshot may take
+
+/// A copy of a world, to restart a game or roll one back
+typedef struct {
+    uint32_t magic;     ///< GAME_SNAPSHOT_MAGIC
+    uint32_t size;      ///< sizeof(GAME_WORLD) of the build that saved it
+    GAME_WORLD world;
+} GAME_SNAPSHOT;
+
+/** Copy a world into a snapshot; nothing is drawn */
+void game_save(const GAME_WORLD* world, GAME_SNAPSHOT* snapshot);
+
+/** Copy a snapshot back into a world; the screen still shows the old world,
+    see game_draw()
+    @return 0, or -1 if the snapshot is not from this build
+*/
+int game_restore(GAME_WORLD* world, const GAME_SNAPSHOT* snapshot);
+
+/** Start a new game from a snapshot taken just after game_start(): the same
+    as game_start(), without setting up the cities and the player again.
+    Falls back to game_start() if start holds no snapshot.
+*/
+void game_restart(GAME_WORLD* world, const GAME_SNAPSHOT* start, int start_level, uint32_t seed);
+
+/** Draw the whole world on a clear screen */
+void game_draw(GAME_WORLD* world);
+
+#endif //GAME_PUBLIC_H
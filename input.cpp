@@ -0,0 +1,146 @@
+// ============================================
+// The file implement the input module
+// Fall 2016 Gatech ECE 2035
+//=============================================
+
+#include "input_private.h"
+
+// pressed buttons pull their pin low
+InterruptIn input_left(INPUT_LEFT_PIN);
+InterruptIn input_right(INPUT_RIGHT_PIN);
+InterruptIn input_fire(INPUT_FIRE_PIN);
+InterruptIn input_down(INPUT_DOWN_PIN);
+InterruptIn* input_pins[NUM_BUTTONS] = { &input_left, &input_right, &input_fire, &input_down };
+
+Ticker input_ticker;
+volatile int input_ticking = 0;
+
+// per button: the last raw reading and how many ticks it has held, the
+// debounced state, and ticks held down for repeats
+int input_raw[NUM_BUTTONS];
+int input_raw_ticks[NUM_BUTTONS];
+volatile int input_state[NUM_BUTTONS];
+int input_held_ticks[NUM_BUTTONS];
+int input_repeat_delay[NUM_BUTTONS];
+int input_repeat_interval[NUM_BUTTONS];
+
+// events, written by the debounce timer and read by the game
+INPUT_EVENT input_queue[INPUT_QUEUE_SIZE];
+volatile unsigned int input_head = 0;
+volatile unsigned int input_tail = 0;
+unsigned int input_lost = 0;
+
+void input_init(void)
+{
+    for(int i = 0; i < NUM_BUTTONS; i++) {
+        input_pins[i]->mode(PullUp);
+        input_raw[i] = 0;
+        input_raw_ticks[i] = 0;
+        input_state[i] = 0;
+        input_repeat_interval[i] = 0;
+        input_pins[i]->rise(&input_edge);
+        input_pins[i]->fall(&input_edge);
+    }
+    // a button already held gets its press
+    __disable_irq();
+    input_edge();
+    __enable_irq();
+}
+
+// any edge on any button: sample them all until they settle
+void input_edge(void)
+{
+    if(!input_ticking) {
+        input_ticking = 1;
+        input_ticker.attach_us(&input_tick, INPUT_TICK_US);
+    }
+}
+
+void input_tick(void)
+{
+    int busy = 0;
+    for(int i = 0; i < NUM_BUTTONS; i++) {
+        int raw = !input_pins[i]->read();
+        if(raw != input_raw[i]) {
+            // still bouncing
+            input_raw[i] = raw;
+            input_raw_ticks[i] = 0;
+            busy = 1;
+        }
+        else if(raw != input_state[i]) {
+            if(++input_raw_ticks[i] >= INPUT_SETTLE_TICKS) {
+                input_state[i] = raw;
+                input_held_ticks[i] = 0;
+                input_push((BUTTON)i, raw ? INPUT_PRESS : INPUT_RELEASE);
+            }
+            busy = 1;
+        }
+        else if(raw && input_repeat_interval[i]) {
+            int held = ++input_held_ticks[i] - input_repeat_delay[i];
+            if(held >= 0 && held % input_repeat_interval[i] == 0)
+                input_push((BUTTON)i, INPUT_REPEAT);
+            busy = 1;
+        }
+    }
+    // nothing to watch until the next edge
+    if(!busy) {
+        input_ticker.detach();
+        input_ticking = 0;
+    }
+}
+
+void input_push(BUTTON button, INPUT_EVENT_TYPE type)
+{
+    unsigned int next = (input_head + 1) & (INPUT_QUEUE_SIZE - 1);
+    if(next == input_tail) {
+        input_lost++;
+        return;
+    }
+    input_queue[input_head].button = button;
+    input_queue[input_head].type = type;
+    input_queue[input_head].time_ms = us_ticker_read() / 1000;
+    input_head = next;
+}
+
+int input_get_event(INPUT_EVENT* event)
+{
+    if(input_tail == input_head)
+        return 0;
+    *event = input_queue[input_tail];
+    input_tail = (input_tail + 1) & (INPUT_QUEUE_SIZE - 1);
+    return 1;
+}
+
+int input_pending(void)
+{
+    return input_tail != input_head;
+}
+
+void input_flush(void)
+{
+    input_tail = input_head;
+}
+
+int input_is_down(BUTTON button)
+{
+    return input_state[button];
+}
+
+void input_set_repeat(BUTTON button, int delay_ms, int interval_ms)
+{
+    int interval = interval_ms * 1000 / INPUT_TICK_US;
+    if(interval_ms > 0 && interval == 0)
+        interval = 1;
+    __disable_irq();
+    input_repeat_delay[button] = delay_ms * 1000 / INPUT_TICK_US;
+    input_repeat_interval[button] = interval;
+    input_held_ticks[button] = 0;
+    // a button held now starts repeating
+    input_edge();
+    __enable_irq();
+}
+
+unsigned int input_dropped(void)
+{
+    return input_lost;
+}
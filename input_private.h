@@ -0,0 +1,25 @@
+// ============================================
+// The header file is for module "input"
+// Fall 2016 Gatech ECE 2035
+//=============================================
+#ifndef INPUT_PRIVATE_H
+#define INPUT_PRIVATE_H
+
+#include "mbed.h"
+#include "input_public.h"
+
+//==== [private settings] ====
+#define INPUT_LEFT_PIN p21
+#define INPUT_RIGHT_PIN p22
+#define INPUT_FIRE_PIN p23
+#define INPUT_DOWN_PIN p24
+#define INPUT_TICK_US 5000        // debounce timer period
+#define INPUT_SETTLE_TICKS 4      // a button must read the same for this many ticks, 20ms
+#define INPUT_QUEUE_SIZE 16       // a power of 2
+
+//==== [private function] ====
+void input_edge(void);
+void input_tick(void);
+void input_push(BUTTON button, INPUT_EVENT_TYPE type);
+
+#endif //INPUT_PRIVATE_H
@@ -0,0 +1,63 @@
+// ============================================
+// The header file is for module "input"
+// Debounced push buttons with an event queue
+// Fall 2016 Gatech ECE 2035
+//=============================================
+/** @file input_public.h */
+#ifndef INPUT_PUBLIC_H
+#define INPUT_PUBLIC_H
+
+/// The push buttons, by what the game uses them for
+typedef enum {
+    BUTTON_LEFT = 0,    ///< p21
+    BUTTON_RIGHT,       ///< p22
+    BUTTON_FIRE,        ///< p23, "Up" on the menus
+    BUTTON_DOWN,        ///< p24
+    NUM_BUTTONS
+} BUTTON;
+
+typedef enum {
+    INPUT_PRESS = 0,    ///< The button went down and stayed down
+    INPUT_RELEASE,      ///< The button came back up
+    INPUT_REPEAT        ///< The button is still held, see input_set_repeat()
+} INPUT_EVENT_TYPE;
+
+typedef struct {
+    BUTTON button;
+    INPUT_EVENT_TYPE type;
+    unsigned int time_ms;   ///< When the event was raised, on the us ticker's clock
+} INPUT_EVENT;
+
+/** Set the buttons up with pull-ups and start watching them. Call once.
+    A button edge wakes a debounce timer, which runs only until all the
+    buttons have settled and none is repeating.
+*/
+void input_init(void);
+
+/** Take the oldest event from the queue
+    @param event Where to store it
+    @return 1 if there was an event, 0 if the queue was empty
+*/
+int input_get_event(INPUT_EVENT* event);
+
+/** @return 1 if an event is waiting in the queue */
+int input_pending(void);
+
+/** Drop all queued events, such as presses made while a sound played */
+void input_flush(void);
+
+/** The debounced state of a button
+    @return 1 if it is held down
+*/
+int input_is_down(BUTTON button);
+
+/** Raise INPUT_REPEAT events while a button is held
+    @param delay_ms Time from the press to the first repeat
+    @param interval_ms Time between repeats, 0 for no repeats
+*/
+void input_set_repeat(BUTTON button, int delay_ms, int interval_ms);
+
+/** Events lost because the queue was full */
+unsigned int input_dropped(void);
+
+#endif //INPUT_PUBLIC_H
@@ -3,43 +3,100 @@
 #include "mbed.h"
 #include "wave_player.h"
 #include "MMA8452.h"
+#include "FATSectorCache.h"
+#include "FATLogFile.h"
+#include "AssetPack.h"
 
 // Projet includes
 #include "globals.h"
 #include "city_landscape_public.h"
 #include "missile_public.h"
 #include "player_public.h"
+#include "game_public.h"
+#include "input_public.h"
+#include "menu_public.h"
+#include "scheduler_public.h"
+#include "replay_public.h"
+#include "autopilot_public.h"
+#include "profile_public.h"
 #include "testbench.h"
 //#include <math.h>
 
 
 #define CITY_HIT_MARGIN 1
 #define CITY_UPPER_BOUND (SIZE_Y-(LANDSCAPE_HEIGHT+MAX_BUILDING_HEIGHT))
+#define MUSIC_FILE "music.wav"
+#define ASSET_PACK "assets.pak"
+#define MUSIC_READS_PER_FRAME 2
+#define SD_CACHE_SECTORS 8
+#define SD_CACHE_AHEAD 4
+#define TLOG_FILE "telemetry.log"
+#define TLOG_CAPACITY (256*1024)
+#define TLOG_SECTORS 4
+#define TLOG_FRAMES_PER_COMMIT 64
+#define REPLAY_FILE "/sd/replay.bin"
+#define ACCEL_I2C_HZ 400000
+#define ACCEL_INT_PIN p29
+#define ACCEL_RATE MMA8452::RATE_100
+#define ACCEL_SMOOTHING 2
+#define FIRE_REPEAT_DELAY_MS 300
+#define FIRE_REPEAT_MS 300
+#define PROMPT_BLINK_MS 500
+// Game tasks: period and deadline in ms, and priority (0 first).  The
+// simulation period sets the game's speed.
+#define AUDIO_PERIOD_MS 10
+#define INPUT_PERIOD_MS 20
+#define SIM_PERIOD_MS 40
+#define RENDER_PERIOD_MS 40
+#define RENDER_DEADLINE_MS 80
+// Soak test: the autopilot plays this level game after game, and reports
+// over pc this often
+#define SOAK_LEVEL 4
+#define SOAK_REPORT_MS 60000
+#define HEAP_PROBE_MAX 32768
+#define HEAP_PROBE_MIN 16
+#define HEAP_PROBE_BLOCKS 16
+// Profiling report: queued this often, and written out a FIFO at a time
+#define PROFILE_REPORT_MS 10000
+#define PROFILE_SERVICE_MS 10
 
 // Helper function declarations
 void playSound(char* wav);
-void checkCollisions(void);
+char* soundPath(const char* name);
 void clearMissiles(void);
-void nextLevel(void);
-void getLevelInfo(void);
-void checkCityCollisions(void);
 void levelSetup(void);
 void play(void);
 void loadGame(void);
 void gameOver(void);
+void reportMenu(const char* name, MENU_STATS* stats);
+void titleDraw(void);
+MENU_ACTION titleHandle(const INPUT_EVENT* event);
+void levelDraw(void);
+MENU_ACTION levelHandle(const INPUT_EVENT* event);
+void gameOverDraw(void);
+MENU_ACTION gameOverHandle(const INPUT_EVENT* event);
+void audioTask(void);
+void inputTask(void);
+void simTask(void);
+void renderTask(void);
+void showLives(void);
+void replayInputs(void);
+void soakTask(void);
+void profileTask(void);
+void soakCount(void);
+unsigned heapProbe(unsigned* largest);
 
 
 // Console output
 Serial pc(USBTX,USBRX);
 
 // Accelerometer
-MMA8452 accel(p28, p27, 100000);
+MMA8452 accel(p28, p27, ACCEL_I2C_HZ);
+// With the MMA8452's INT1 wired to ACCEL_INT_PIN it is sampled in the
+// background on data ready, and the game loop only reads the average
+int accelSampling = 0;
 
-// Control buttons
-DigitalIn left_pb(p21);
-DigitalIn right_pb(p22); 
-DigitalIn fire_pb(p23);
-DigitalIn pb(p24);
+// Control buttons are in the input module: left p21, right p22, fire p23, down p24
 
 // Screen
 uLCD_4DGL uLCD(p9,p10,p11); // serial tx, serial rx, reset pin;
@@ -52,24 +109,61 @@ wave_player waver(&DACout);
 // SD Card
 SDFileSystem sd(p5, p6, p7, p8, "sd"); // mosi, miso, sck, cs
 
-//player
-PLAYER thisPlayer;
+// FatFs sector cache: FAT and directory sectors stay put between the wave
+// file opens, and music is read ahead.  Kept in AHB SRAM next to the DAC's
+// DMA buffers to spare the main RAM.
+static uint8_t sd_cache_ram[(SD_CACHE_SECTORS+SD_CACHE_AHEAD)*512] DMA_RAM;
+FATSectorCache sd_cache(&sd, SD_CACHE_SECTORS, SD_CACHE_AHEAD, sd_cache_ram);
+
+// Gameplay telemetry, a line per frame.  The log file is preallocated and
+// written a staging buffer at a time, so logging never touches the FAT.
+static uint8_t tlog_ram[TLOG_SECTORS*512] DMA_RAM;
+FATLogFile tlog(&sd, TLOG_SECTORS, tlog_ram);
+int tlogOpen = 0;
+
+// Sounds come from one pack file, made by tools/asset_pack; opening one is a
+// lookup in the pack's index instead of a directory walk
+AssetPack pak("pak");
+int packLoaded = 0;
 
 //LEDs
 DigitalOut led1(LED1);
 DigitalOut led2(LED2);
 DigitalOut led3(LED3);
 
-//Other useful Variables
-int numMissilesDestroyed = 0;
-int level = 1;
-int numCities = 4;
-int missileMissileTolerance;
-int missilePlayerTolerance;
-int isGameOver = 0;
-int score = 0;
-int numLives = 3;
+//Other useful Variables; the game's own are in its world
+GAME_WORLD world;
+GAME_SNAPSHOT freshGame;    // the world of a game just started, to restart from
 int highScore = 0;
+
+// Menu screens: each is drawn once and the CPU sleeps between button presses
+const MENU_SCREEN titleScreen = { titleDraw, titleHandle, PROMPT_BLINK_MS };
+const MENU_SCREEN levelScreen = { levelDraw, levelHandle, 0 };
+const MENU_SCREEN gameOverScreen = { gameOverDraw, gameOverHandle, 0 };
+int titleChoice = BUTTON_FIRE;
+int titleBlink = 0;
+int menuLevel = 1;
+
+// Every game's input is recorded to REPLAY_FILE; Left on the title screen
+// plays the last one back, frame for frame
+int recording = 0;
+int replaying = 0;
+REPLAY_HEADER replayHeader;
+GAME_INPUT replayInput;     // the next recorded input
+int replayPending = 0;
+
+// Right on the title screen hands the controls to the autopilot, for
+// unattended soak tests; the totals cover every game since
+int autopilot = 0;
+int simTaskId, renderTaskId;
+unsigned soakGames = 0;
+unsigned long long soakFrames = 0;
+unsigned long long soakUs = 0;
+uint32_t soakLast;
+unsigned soakSlowestSim = 0, soakSlowestRender = 0, soakMissed = 0;
+unsigned soakMostMissiles = 0;
+
+int profileRuns = 0;
 // ===User implementations start===
 int main()
 {
@@ -83,43 +177,55 @@ int main()
     //playSound("/sd/wavfiles/BUZZER.wav");
     
     //Initialize hardware buttons
-    left_pb.mode(PullUp); 
-    right_pb.mode(PullUp);
-    fire_pb.mode(PullUp);
-    pb.mode(PullUp);
+    input_init();
+    
+#if PROFILE_ENABLE
+    profile_init(&pc);
+#endif
+    
+    // wave files are only ever read; a cluster map per file keeps FAT
+    // lookups out of streaming and looping
+    sd.fast_seek(1);
+    
+    packLoaded = !pak.load(&sd, ASSET_PACK);
+    if(!packLoaded)
+        printf("No %s, using /sd/wavfiles\n", ASSET_PACK);
+    
+    tlogOpen = !tlog.open(TLOG_FILE, TLOG_CAPACITY);
+    if(!tlogOpen)
+        printf("Could not open %s\n", TLOG_FILE);
+    
+    // 8 bit samples are plenty for steering, and halve every read; the
+    // moving average gets back resolution below a count. Sampling runs only
+    // during play(), or INT1 would wake the menus at the data rate
+    accel.setLowLatency(ACCEL_RATE);
     
     
     
     // ===User implementations start===
-    int waiting = 1;
-    while(waiting)
-    {
-        uLCD.locate(4,0);
-        uLCD.printf("Now Playing");
-        uLCD.locate(1,1);
-        uLCD.printf("Missile Command");
-        uLCD.locate(0,3);
-        uLCD.printf("Press Up to Begin");
-        uLCD.locate(0,5);
-        uLCD.printf("Press Down for the");
-        uLCD.locate(0,6);
-        uLCD.printf("Level Selection");
-        if(!fire_pb)
-        {
-            uLCD.cls();
-            waiting = 0;
-            level = 1;
-            play();
-        }
-        else if(!pb){
-            uLCD.cls();
-            levelSetup();
-            waiting = 0;
-            play();
-        }  
+    MENU_STATS menuStats;
+    menu_run(&titleScreen, &menuStats);
+    reportMenu("Title", &menuStats);
+    uLCD.cls();
+    if(titleChoice == BUTTON_DOWN)
+        levelSetup();
+    else if(titleChoice == BUTTON_LEFT && !replay_open(REPLAY_FILE, &replayHeader)) {
+        replaying = 1;
+        world.level = replayHeader.level;
+    }
+    else if(titleChoice == BUTTON_RIGHT) {
+        autopilot = 1;
+        soakLast = us_ticker_read();
+        world.level = SOAK_LEVEL;
+    }
+    else
+        world.level = 1;
+    // A game after another, without piling up the stack
+    for(;;) {
+        play();
+        gameOver();
+        loadGame();
     }
-    uLCD.locate(5,1);
-    uLCD.printf("");
     
     // Initialization goes here
     
@@ -131,305 +237,434 @@ int main()
 // ===User implementations start===
 void levelSetup()
 {
-       int waiting = 1;
-       int lvl = 1;
-       while(waiting)
-       {
-            uLCD.locate(0,0);
-            uLCD.printf("Level Selection:");
-            uLCD.locate(0,2);
-            uLCD.printf("Level: %d", lvl);
-            uLCD.locate(0,3);
-            uLCD.printf("Value must be set between 1 and 4");
-            uLCD.locate(0,5);
-            uLCD.printf("Right to Add");
-            uLCD.locate(0,6);
-            uLCD.printf("Left to Subtract");
-            uLCD.locate(0,8);
-            uLCD.printf("Press Up to Start");
-            if(!left_pb)
-            {
-                lvl--;
-            }
-            else if(!right_pb)
-                lvl++;
-            else if(!fire_pb)
-            {
-                uLCD.cls();
-                waiting = 0;
-            }
-       }
-       level = lvl;
+    MENU_STATS menuStats;
+    menuLevel = 1;
+    menu_run(&levelScreen, &menuStats);
+    reportMenu("Level", &menuStats);
+    uLCD.cls();
+    world.level = menuLevel;
+}
+
+void titleDraw()
+{
+    uLCD.locate(4,0);
+    uLCD.printf("Now Playing");
+    uLCD.locate(1,1);
+    uLCD.printf("Missile Command");
+    uLCD.locate(0,3);
+    uLCD.printf("Press Up to Begin");
+    uLCD.locate(0,5);
+    uLCD.printf("Press Down for the");
+    uLCD.locate(0,6);
+    uLCD.printf("Level Selection");
+    uLCD.locate(0,8);
+    uLCD.printf("Left to Replay");
+    uLCD.locate(0,9);
+    uLCD.printf("Right: Autopilot");
+}
+
+MENU_ACTION titleHandle(const INPUT_EVENT* event)
+{
+    if(event == NULL) {
+        // blink the prompt
+        titleBlink = !titleBlink;
+        uLCD.color(titleBlink ? BACKGROUND_COLOR : WHITE);
+        uLCD.locate(0,3);
+        uLCD.printf("Press Up to Begin");
+        uLCD.color(WHITE);
+        return MENU_STAY;
+    }
+    if(event->type != INPUT_PRESS)
+        return MENU_STAY;
+    if(event->button == BUTTON_FIRE || event->button == BUTTON_DOWN || event->button == BUTTON_LEFT ||
+       event->button == BUTTON_RIGHT) {
+        titleChoice = event->button;
+        return MENU_DONE;
+    }
+    return MENU_STAY;
+}
+
+void levelDraw()
+{
+    uLCD.locate(0,0);
+    uLCD.printf("Level Selection:");
+    uLCD.locate(0,2);
+    uLCD.printf("Level: %d", menuLevel);
+    uLCD.locate(0,3);
+    uLCD.printf("Value must be set between 1 and 4");
+    uLCD.locate(0,5);
+    uLCD.printf("Right to Add");
+    uLCD.locate(0,6);
+    uLCD.printf("Left to Subtract");
+    uLCD.locate(0,8);
+    uLCD.printf("Press Up to Start");
+}
+
+MENU_ACTION levelHandle(const INPUT_EVENT* event)
+{
+    if(event == NULL || event->type != INPUT_PRESS)
+        return MENU_STAY;
+    if(event->button == BUTTON_FIRE)
+        return MENU_DONE;
+    if(event->button == BUTTON_LEFT && menuLevel > 1)
+        menuLevel--;
+    else if(event->button == BUTTON_RIGHT && menuLevel < 4)
+        menuLevel++;
+    else
+        return MENU_STAY;
+    // only the number changes
+    uLCD.locate(0,2);
+    uLCD.printf("Level: %d", menuLevel);
+    return MENU_STAY;
+}
+
+void gameOverDraw()
+{
+    uLCD.locate(0,2);
+    uLCD.printf("Final Score: %d", world.score);
+    uLCD.locate(0,4);
+    uLCD.printf("Press [Fire] to \nplay again.");
+}
+
+MENU_ACTION gameOverHandle(const INPUT_EVENT* event)
+{
+    if(event != NULL && event->button == BUTTON_FIRE && event->type == INPUT_PRESS)
+        return MENU_DONE;
+    return MENU_STAY;
+}
+
+void reportMenu(const char* name, MENU_STATS* stats)
+{
+    printf("%s screen: %u draws, %u events, %u wakeups, %u LCD bytes, asleep %u of %u ms\n",
+           name, stats->draws, stats->events, stats->wakeups, stats->lcd_bytes,
+           stats->asleep_ms, stats->asleep_ms + stats->awake_ms);
 }
 
 void loadGame()
 {
     uLCD.cls();
-    level = 1;
-    getLevelInfo();
-    play(); 
+    world.level = autopilot ? SOAK_LEVEL : 1;
 }
 
 void play() {
-    city_landscape_init(numCities);
-    draw_cities();
-    draw_landscape();
-    player_init();
-    thisPlayer = player_get_info();
-    missile_init();
-    double x;
-    double y;
-    double z;
-    int readXYZ;
-    
     int active = accel.activate();
     
+    accelSampling = !accel.startSampling(ACCEL_INT_PIN, ACCEL_RATE, ACCEL_SMOOTHING);
+    if(!accelSampling)
+        printf("Accelerometer sampling not started, reading it every frame\n");
+    
+    // The seed is all a replay needs besides the input
+    uint32_t seed;
+    if(replaying) {
+        seed = replayHeader.seed;
+        replayPending = replay_read(&replayInput);
+    }
+    else {
+        seed = us_ticker_read();
+        recording = !replay_record(REPLAY_FILE, seed, world.level);
+        if(!recording)
+            printf("Could not record to %s\n", REPLAY_FILE);
+    }
+    // The first game is set up in full, later ones are a copy and a redraw
+    game_restart(&world, &freshGame, world.level, seed);
+    if(freshGame.magic != GAME_SNAPSHOT_MAGIC)
+        game_save(&world, &freshGame);
+    showLives();
     
+    // Holding fire shoots at the repeat rate, not every frame
+    input_flush();
+    input_set_repeat(BUTTON_FIRE, FIRE_REPEAT_DELAY_MS, FIRE_REPEAT_MS);
+    
+    // Background music is streamed from the SD card while the game runs
+    FILE *music = fopen(soundPath(MUSIC_FILE), "r");
+    if(music != NULL && !waver.start(music, 1)) {
+        fclose(music);
+        music = NULL;
+    }
     
 
-    // Main game loop
-    while(!isGameOver)
-    {
-        //Display to screen level info and number of missiles destroyed. 
-        uLCD.locate(0,0);
-        uLCD.printf("Level: %d", level);
-        uLCD.locate(14,0);
-        uLCD.printf("%d", numMissilesDestroyed);
-        
-        
-        //PLAYER player = player_get_info();
-        //led1 = !led1;
-        getLevelInfo();
-        
-        // 1. Update missiles
-        missile_generator();
-        
-        // 2. Read input
-        readXYZ = accel.readXYZGravity(&x, &y, &z);
-        //printf("x: %d y: %d z: %d\n\r", x,y,z);
-        if(!fire_pb) {
-            player_fire();   
-        }
-        player_missile_draw();
-        // 3. Update player position
-        if(x < -0.5) {
-            player_moveLeft();   
-        }
-        else if( x > 0.5) {
-            player_moveRight();   
-        }
-        // 4. Check for collisions
-        checkCollisions();
-        checkCityCollisions();
-        // 5. Redraw city landscape
-        draw_cities();
-        draw_landscape();
-        // 6. Check for endgame
-        if(thisPlayer.status == DESTROYED || numCities <= 0)
-            isGameOver = 1;
-        if((numMissilesDestroyed >= 10 || (!left_pb && !right_pb)) && level < 4)
-            nextLevel();
+    // The game runs as separate tasks: music refill first, as the DAC
+    // can't wait, then the controls, the game itself, and the redraw,
+    // which can fall behind a frame without harm
+    sched_reset();
+    sched_add("audio", audioTask, 0, AUDIO_PERIOD_MS, AUDIO_PERIOD_MS);
+    sched_add("input", inputTask, 1, INPUT_PERIOD_MS, INPUT_PERIOD_MS);
+    simTaskId = sched_add("sim", simTask, 2, SIM_PERIOD_MS, SIM_PERIOD_MS);
+    renderTaskId = sched_add("render", renderTask, 3, RENDER_PERIOD_MS, RENDER_DEADLINE_MS);
+    if(autopilot)
+        sched_add("soak", soakTask, 4, SOAK_REPORT_MS, SOAK_REPORT_MS);
+#if PROFILE_ENABLE
+    sched_add("profile", profileTask, 5, PROFILE_SERVICE_MS, PROFILE_SERVICE_MS);
+#endif
+    sched_run(&world.isGameOver);
+    
+    input_set_repeat(BUTTON_FIRE, 0, 0);
+    if(music != NULL) {
+        WAVE_STREAM_STATS stats;
+        waver.get_stream_stats(&stats);
+        waver.stop();
+        fclose(music);
+        printf("Music: %u underruns, %u samples starved, low water %u, %u reads, slowest %u us\n",
+               stats.underruns, stats.starved, stats.low_water, stats.reads, stats.max_read_us);
+    }
+    if(recording) {
+        if(replay_finish(world.frame, world.score))
+            printf("Recording to %s failed\n", REPLAY_FILE);
+        recording = 0;
+    }
+    if(replaying) {
+        printf("Replay %s: %u of %u frames, score %d of %d\n",
+               world.frame == replayHeader.frames && world.score == replayHeader.score ? "matched" : "diverged",
+               world.frame, replayHeader.frames, world.score, replayHeader.score);
+        replay_close();
+        replaying = 0;
+    }
+    if(tlogOpen) {
+        FAT_LOG_STATS stats;
+        tlog.printf("end %d\n", world.score);
+        tlog.commit();
+        tlog.get_stats(&stats);
+        printf("Telemetry: %u bytes in %u sectors, slowest write %u us\n",
+               stats.bytes, stats.sectors, stats.max_flush_us);
+    }
+    if(accelSampling) {
+        MMA8452::SamplingStats stats;
+        accel.getSamplingStats(&stats);
+        printf("Accelerometer: %u samples, %u us each, slowest %u us, %u errors\n",
+               stats.samples, stats.samples ? stats.readUs/stats.samples : 0, stats.maxReadUs, stats.errors);
+        accel.stopSampling();
+        accelSampling = 0;
+    }
+    sched_report();
+#if PROFILE_ENABLE
+    profile_report();
+    profile_flush();
+#endif
+    if(autopilot)
+        soakCount();
+}
+
+void audioTask()
+{
+    // Keep the music's prefetch buffer topped up
+    waver.service(MUSIC_READS_PER_FRAME);
+}
+
+void inputTask()
+{
+    int x, y, z;
+    INPUT_EVENT event;
+    GAME_INPUT input;
+    
+    if(replaying || autopilot) {
+        // the controls do nothing, but presses mustn't pile up
+        while(input_get_event(&event))
+            ;
+    }
+    if(replaying) {
+        replayInputs();
+        return;
+    }
+    if(autopilot) {
+        autopilot_input(&world, &input);
+        game_input(&world, &input);
+        if(recording)
+            replay_write(&input);
+        return;
     }
-    score = (level*10) + numMissilesDestroyed;
-    gameOver();
+    if(accelSampling)
+        accel.readFilteredMilliG(&x, &y, &z);
+    else
+        accel.readXYZMilliG(&x, &y, &z);
+    //printf("x: %d y: %d z: %d\n\r", x,y,z);
+    input.frame = world.frame;
+    input.tilt = x;
+    input.fires = 0;
+    input.held = 0;
+    while(input_get_event(&event)) {
+        if(event.button == BUTTON_FIRE && event.type != INPUT_RELEASE && input.fires < 255)
+            input.fires++;
+    }
+    for(int i = 0; i < NUM_BUTTONS; i++) {
+        if(input_is_down((BUTTON)i))
+            input.held |= 1 << i;
+    }
+    game_input(&world, &input);
+    if(recording)
+        replay_write(&input);
+}
+
+// Apply the recorded input given before this frame.  The simulation calls
+// it as well, in case the input task hasn't run since the last frame.
+void replayInputs()
+{
+    while(replayPending && replayInput.frame <= world.frame) {
+        game_input(&world, &replayInput);
+        replayPending = replay_read(&replayInput);
+    }
+}
+
+void simTask()
+{
+    //PLAYER player = player_get_info();
+    //led1 = !led1;
+    if(replaying)
+        replayInputs();
+    unsigned played = world.frame;
+    game_step(&world);
+    showLives();
+    if(autopilot) {
+        unsigned missiles = 0;
+        for(int i = 0; i < MAX_MISSILES; i++)
+            missiles += world.missiles.missile[i].status == MISSILE_ACTIVE;
+        if(missiles > soakMostMissiles)
+            soakMostMissiles = missiles;
+    }
+    // Log the frame
+    if(tlogOpen) {
+        tlog.printf("%u %d %d %d %d %d\n", played, world.level, world.numMissilesDestroyed, world.numCities, world.numLives, world.gameInput.tilt);
+        if(played % TLOG_FRAMES_PER_COMMIT == TLOG_FRAMES_PER_COMMIT-1)
+            tlog.commit();
+    }
+}
+
+// A LED per life left
+void showLives()
+{
+    led1 = world.numLives >= 1;
+    led2 = world.numLives >= 2;
+    led3 = world.numLives >= 3;
+}
+
+void renderTask()
+{
+    //Display to screen level info and number of missiles destroyed. 
+    uLCD.locate(0,0);
+    uLCD.printf("Level: %d", world.level);
+    uLCD.locate(14,0);
+    uLCD.printf("%d", world.numMissilesDestroyed);
+    // Redraw city landscape
+    draw_cities(&world);
+    draw_landscape();
 }
 
 void gameOver() {
     uLCD.cls();
     uLCD.locate(0,0);
     uLCD.printf("Game Over!");
-    if(score > highScore) {
-        highScore = score;
+    if(world.score > highScore) {
+        highScore = world.score;
         uLCD.locate(0,1);
         uLCD.printf("New High Score!");   
-        playSound("/sd/wavfiles/NewHighScore.wav");
+        playSound(soundPath("NewHighScore.wav"));
     }
     
-    uLCD.locate(0,2);
-    uLCD.printf("Final Score: %d", score);
-    uLCD.locate(0,4);
-    uLCD.printf("Press [Fire] to \nplay again.");
-    
-    int playAgain = 0;
-    while(!playAgain) {
-        if(!fire_pb) {
-            playAgain = 1;
-        }   
-    }
-    loadGame();
+    // nobody is there to press fire in a soak test
+    if(autopilot)
+        return;
+    // presses made during the sound don't count
+    input_flush();
+    MENU_STATS menuStats;
+    menu_run(&gameOverScreen, &menuStats);
+    reportMenu("Game over", &menuStats);
 }
 
-void checkCollisions() {
-    int playerX;// = ((PLAYER_MISSILE*) (((thisPlayer.playerMissiles)->head)->data))->x;
-    int playerY;// = ((PLAYER_MISSILE*) (((thisPlayer.playerMissiles)->head)->data))->y;
-    int missileX;
-    int missileY;
-    double distance;
-    int midX, midY;
-    CITY city;
-    int cityMinX, cityMaxX, cityMaxY;
-    
-    //Check missile collisions with other missiles. 
-    PLAYER_MISSILE* pMissile = (PLAYER_MISSILE*) getHead(thisPlayer.playerMissiles);
-    MISSILE* eMissile = (MISSILE*) getHead(get_missile_list());
-    while (eMissile != NULL) {
-        missileX = eMissile->x;
-        missileY = eMissile->y;
-        while(pMissile != NULL) {
-            playerX = pMissile->x;
-            playerY = pMissile->y;
-            //calculations
-            distance = (playerX-missileX)*(playerX-missileX) + (playerY-missileY)*(playerY-missileY);
-            midX = (playerX + missileX)/2;
-            midY = (playerY + missileY)/2;
-            //Missile Collision happened.
-            if(distance < missileMissileTolerance) { 
-                eMissile->status = MISSILE_EXPLODED;
-                pMissile->status = PMISSILE_EXPLODED;
-                uLCD.circle(midX,midY,3,0x800003);
-                wait(.1);
-                uLCD.circle(midX,midY,3,0x000000);
-                wait(.1);
-                uLCD.circle(midX,midY,5,0x800003);
-                wait(.1);
-                uLCD.circle(midX,midY,5,0x000000);
-                numMissilesDestroyed++;
-            }
-            pMissile = (PLAYER_MISSILE*) getNext(thisPlayer.playerMissiles);
-        }
-        
-        //check collisions with player
-        //(player.x)-(missile->x)<1 && missile->x - player.x <playerMissileRad  && (player.y)-(missile->y)<5 && missile->y - player.y <1
-        //(player.x)-(missile->x)<1 && missile->x - player.x <pMRad  && (player.y)-(missile->y)<5 && missile->y - player.y <1)
-        if((missileY - thisPlayer.y < 1 && (thisPlayer.y - missileY) < 5) && ((thisPlayer.x - missileX) < 1 && (missileX - thisPlayer.x) < 5)) {
-            numLives--;
-            if(numLives == 0)
-                thisPlayer.status = DESTROYED;
-            eMissile->status = MISSILE_EXPLODED;
-        }
-        
-        switch(numLives) {
-            case 1:
-                led1 = 1;
-                led2 = 0;
-                led3 = 0;
-                break;
-            case 2:
-                led1 = 1;
-                led2 = 1;
-                led3 = 0;
-                break;
-            case 3:
-                led1 = 1;
-                led2 = 1;
-                led3 = 1;
-                break;
-            default:
-                led1 = 0;
-                led2 = 0;
-                led3 = 0;
-                break;   
-        }
-        
-        if(missileY > 128)
-            eMissile->status = MISSILE_EXPLODED;
-        
-        eMissile = (MISSILE*) getNext(get_missile_list());   
+#if PROFILE_ENABLE
+// Queue a profiling report now and then, and write it out without waiting
+// on the port, so that reporting doesn't show up in the game's timing
+void profileTask()
+{
+    if(++profileRuns >= PROFILE_REPORT_MS / PROFILE_SERVICE_MS) {
+        profileRuns = 0;
+        profile_report();
     }
+    profile_service();
 }
+#endif
 
-void checkCityCollisions()
+// Add a finished autopilot game to the soak totals
+void soakCount()
 {
-    int i, xMin, xMax, y;
-    MISSILE* eMissile = (MISSILE*) getHead(get_missile_list());
-    while(eMissile != NULL)
-    {
-        for(i = 0; i <= 4; i++)
-        {
-            CITY city = city_get_info(i);
-            if(city.status == DESTORIED)
-                continue;
-            xMin = city.x;
-            xMax = xMin + city.width;
-            y = 128-city.height;    
-            if(xMin-(eMissile->x)<1 && eMissile->x - xMax <1  && y-(eMissile->y)<1 && 128-eMissile->y>0){
-                eMissile->status = MISSILE_EXPLODED;
-                city.status = DESTORIED; 
-                city_destory(i);
-                numCities--;
-                int X = (xMin + xMax)/2;
-                int Y = y;
-                uLCD.circle(X,Y,3,0x800003);
-                wait(.1);
-                uLCD.circle(X,Y,3,0x000000);
-                wait(.1);
-                uLCD.circle(X,Y,5,0x800003);
-                wait(.1);
-                uLCD.circle(X,Y,5,0x000000);
-                wait(.1);
-                uLCD.circle(X,Y,7,0x800003);
-                wait(.1);
-                uLCD.circle(X,Y,7,0x000000);
-                wait(.1);
-                uLCD.circle(X,Y,10,0x800003);
-                wait(.1);
-                uLCD.circle(X,Y,10,0x000000);
-            }
-        } 
-        eMissile = (MISSILE*) getNext(get_missile_list());   
-    }
+    TASK_STATS stats;
+    soakGames++;
+    soakFrames += world.frame;
+    sched_get_stats(simTaskId, &stats);
+    soakMissed += stats.missed;
+    if(stats.max_us > soakSlowestSim)
+        soakSlowestSim = stats.max_us;
+    sched_get_stats(renderTaskId, &stats);
+    soakMissed += stats.missed;
+    if(stats.max_us > soakSlowestRender)
+        soakSlowestRender = stats.max_us;
 }
 
-void nextLevel() {
-    //clear the missiles from the screen. 
-    MISSILE* eMissile = (MISSILE*) getHead(get_missile_list());
-    while(eMissile != NULL) {
-        eMissile->status = MISSILE_EXPLODED;
-        eMissile = (MISSILE*) getNext(get_missile_list());
-    }
-    if(level != 4)
-        level++;
-    numMissilesDestroyed = 0;
-    getLevelInfo();
+// One line of soak totals, with the game in play: frame times, deadlines
+// missed, free heap and how broken up it is, and missiles in flight and
+// dropped for want of a slot
+void soakTask()
+{
+    TASK_STATS sim, render;
+    unsigned largest, total;
+    uint32_t now = us_ticker_read();
+    
+    // the microsecond ticker wraps every 71 minutes; this runs more often
+    soakUs += now - soakLast;
+    soakLast = now;
+    sched_get_stats(simTaskId, &sim);
+    sched_get_stats(renderTaskId, &render);
+    total = heapProbe(&largest);
+    printf("Soak %u s: %u games, %llu frames, sim %u us mean %u max, render %u max, %u missed, "
+           "heap %u free %u%% broken up, missiles %u most, %u+%u dropped\n",
+           (unsigned)(soakUs / 1000000), soakGames, soakFrames + world.frame,
+           sim.runs ? sim.cpu_us / sim.runs : 0, sim.max_us > soakSlowestSim ? sim.max_us : soakSlowestSim,
+           render.max_us > soakSlowestRender ? render.max_us : soakSlowestRender,
+           soakMissed + sim.missed + render.missed, total, total ? 100 - largest*100/total : 0,
+           soakMostMissiles, world.missiles.dropped, world.player.dropped);
 }
 
-void getLevelInfo() {
-    switch(level) {
-        case 1: //level 1
-            set_missile_speed(7);
-            set_missile_interval(60);
-            missileMissileTolerance = 90;
-            missilePlayerTolerance = 10;
-            break;
-        case 2: //level 2
-            set_missile_speed(5);
-            set_missile_interval(40);
-            missileMissileTolerance = 80;
-            missilePlayerTolerance = 12;
-            break;
-        case 3: //level 3
-            set_missile_speed(3);
-            set_missile_interval(20);
-            missileMissileTolerance = 60;
-            missilePlayerTolerance = 13;
-            break;
-        case 4: //level 4
-            set_missile_speed(1);
-            set_missile_interval(10);
-            missileMissileTolerance = 40;
-            missilePlayerTolerance = 15;
+// Free heap, found by taking it: the biggest block malloc() gives, and the
+// total of that and the biggest blocks left after it
+unsigned heapProbe(unsigned* largest)
+{
+    void* blocks[HEAP_PROBE_BLOCKS];
+    unsigned total = 0;
+    int n = 0;
+    
+    *largest = 0;
+    while(n < HEAP_PROBE_BLOCKS) {
+        unsigned lo = 0, hi = HEAP_PROBE_MAX;
+        while(hi - lo > HEAP_PROBE_MIN) {
+            unsigned mid = (lo + hi) / 2;
+            void* p = malloc(mid);
+            if(p != NULL) {
+                free(p);
+                lo = mid;
+            }
+            else
+                hi = mid;
+        }
+        if(lo == 0 || (blocks[n] = malloc(lo)) == NULL)
             break;
-        default: //level 2 is medium
-            set_missile_speed(5);
-            set_missile_interval(40);
-            missileMissileTolerance = 80;
-            missilePlayerTolerance = 12;
+        if(n == 0)
+            *largest = lo;
+        total += lo;
+        n++;
     }
+    while(n > 0)
+        free(blocks[--n]);
+    return total;
 }
 
 
 // ===User implementations end===
 
+// The pack's copy of a sound, or the loose file when there is no pack
+char* soundPath(const char* name) {
+    static char path[64];
+    sprintf(path, packLoaded ? "/pak/%s" : "/sd/wavfiles/%s", name);
+    return path;
+}
+
 // Plays a wavfile
 void playSound(char* wav) {
     //open wav file
@@ -0,0 +1,63 @@
+// ============================================
+// The file implement the menu module
+// Fall 2016 Gatech ECE 2035
+//=============================================
+
+#include "menu_private.h"
+
+Ticker menu_ticker;
+volatile int menu_timer_fired = 0;
+
+void menu_timer(void)
+{
+    menu_timer_fired = 1;
+}
+
+void menu_run(const MENU_SCREEN* screen, MENU_STATS* stats)
+{
+    MENU_STATS s = { 0, 0, 0, 0, 0, 0 };
+    unsigned int start = us_ticker_read();
+    unsigned int asleep_us = 0;
+    unsigned int lcd_start = uLCD.tx_bytes;
+    INPUT_EVENT event;
+    MENU_ACTION action = MENU_REDRAW;
+
+    menu_timer_fired = 0;
+    if(screen->timer_ms > 0)
+        menu_ticker.attach_us(&menu_timer, screen->timer_ms * 1000);
+    while(action != MENU_DONE) {
+        if(action == MENU_REDRAW) {
+            screen->draw();
+            s.draws++;
+        }
+        if(input_get_event(&event)) {
+            action = screen->handle(&event);
+            s.events++;
+        }
+        else if(menu_timer_fired) {
+            menu_timer_fired = 0;
+            action = screen->handle(NULL);
+            s.events++;
+        }
+        else {
+            // an interrupt between the checks and sleep() still wakes it,
+            // since it is left pending until interrupts are enabled again
+            unsigned int t = us_ticker_read();
+            __disable_irq();
+            if(!input_pending() && !menu_timer_fired) {
+                sleep();
+                s.wakeups++;
+            }
+            __enable_irq();
+            asleep_us += us_ticker_read() - t;
+            action = MENU_STAY;
+        }
+    }
+    menu_ticker.detach();
+    if(stats != NULL) {
+        s.lcd_bytes = uLCD.tx_bytes - lcd_start;
+        s.asleep_ms = asleep_us / 1000;
+        s.awake_ms = (us_ticker_read() - start - asleep_us) / 1000;
+        *stats = s;
+    }
+}
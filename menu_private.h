@@ -0,0 +1,16 @@
+// ============================================
+// The header file is for module "menu"
+// Fall 2016 Gatech ECE 2035
+//=============================================
+#ifndef MENU_PRIVATE_H
+#define MENU_PRIVATE_H
+
+#include "mbed.h"
+#include "sleep_api.h"
+#include "globals.h"
+#include "menu_public.h"
+
+//==== [private function] ====
+void menu_timer(void);
+
+#endif //MENU_PRIVATE_H
@@ -0,0 +1,46 @@
+// ============================================
+// The header file is for module "menu"
+// Screens that draw once and sleep between button and timer events
+// Fall 2016 Gatech ECE 2035
+//=============================================
+/** @file menu_public.h */
+#ifndef MENU_PUBLIC_H
+#define MENU_PUBLIC_H
+
+#include "input_public.h"
+
+/// What a screen's handler wants done after an event
+typedef enum {
+    MENU_STAY = 0,   ///< Nothing, or the handler drew the change itself
+    MENU_REDRAW,     ///< Draw the whole screen again
+    MENU_DONE        ///< Leave the screen
+} MENU_ACTION;
+
+/// A screen, see menu_run()
+typedef struct {
+    void (*draw)(void);                                ///< Draws the whole screen
+    MENU_ACTION (*handle)(const INPUT_EVENT* event);   ///< Called with each button event, and with NULL when the timer fires
+    int timer_ms;                                      ///< Timer period, 0 for no timer
+} MENU_SCREEN;
+
+/// Where the time went while a screen was up
+typedef struct {
+    unsigned int draws;       ///< Whole screen draws
+    unsigned int events;      ///< Button and timer events handled
+    unsigned int wakeups;     ///< Times the CPU slept and was woken
+    unsigned int lcd_bytes;   ///< Bytes sent to the uLCD
+    unsigned int awake_ms;    ///< Time spent running
+    unsigned int asleep_ms;   ///< Time spent in sleep()
+} MENU_STATS;
+
+/** Show a screen until its handler returns MENU_DONE
+    The screen is drawn once; after that the CPU sleeps until an interrupt,
+    and only button events, and the timer if there is one, reach the handler.
+    Any interrupt ends the sleep, so background work such as accelerometer
+    sampling is best stopped while a screen is up.
+    @param screen The screen
+    @param stats Where to store the screen's statistics, or NULL
+*/
+void menu_run(const MENU_SCREEN* screen, MENU_STATS* stats);
+
+#endif //MENU_PUBLIC_H
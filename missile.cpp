@@ -4,69 +4,83 @@
 //=============================================
 
 #include "missile_private.h"
-#include "doubly_linked_list.h"
 
 
-int missile_tick=0;
-
-//Create a DLL for missiles
-DLinkedList* missileDLL = NULL;
-
-void missile_init(void)
+void missile_init(GAME_WORLD* world)
 {
-    missileDLL = create_dlinkedlist();
+    MISSILE_STATE* missiles = &world->missiles;
+    for(int i = 0; i < MAX_MISSILES; i++) {
+        missiles->missile[i].status = MISSILE_FREE;
+        missiles->missile[i].threat = -1;
+    }
+    missiles->threats = 0;
+    missiles->tick = 0;
+    missiles->interval = MISSILE_INTERVAL;
+    missiles->speed = MISSILE_SPEED;
+    missiles->dropped = 0;
 }
 
 // See the comments in missile_public.h
-void missile_generator(void){
-    missile_tick++;
+void missile_generator(GAME_WORLD* world){
+    MISSILE_STATE* missiles = &world->missiles;
+    PROFILE_BEGIN(start);
+    missiles->tick++;
     // only fire the missile at certain ticks
-    if((missile_tick % MISSILE_INTERVAL)==0 || missile_tick==0){
+    if((missiles->tick % missiles->interval)==0 || missiles->tick==0){
         //printf("missile_create()");
-        missile_create();
+        missile_create(world);
     }        
     // update the missiles and draw them
-    missile_update_position();
+    missile_update_position(world);
+    PROFILE_END(start, PROFILE_MISSILE_GENERATOR);
 }
 
 /** This function finds an empty slot of missile record, and active it.
 */
-void missile_create(void){
-    MISSILE* missle = (MISSILE*)malloc(sizeof(MISSILE));
+void missile_create(GAME_WORLD* world){
+    MISSILE* missle = NULL;
+    for(int i = 0; i < MAX_MISSILES && missle == NULL; i++)
+        if(world->missiles.missile[i].status == MISSILE_FREE)
+            missle = &world->missiles.missile[i];
+    if(missle == NULL) {
+        world->missiles.dropped++;
+        return;
+    }
     missle->y = 0;
     //each missile has its own tick
     missle->tick = 0;
     //set a random source for the missile
-    missle->source_x = rand() % SIZE_X;
+    missle->source_x = rng_range(&world->rng, SIZE_X);
     //set a random target for the missile
-    missle->target_x = rand() % SIZE_X;
+    missle->target_x = rng_range(&world->rng, SIZE_X);
     //the missile starts at its source
     missle->x = missle->source_x;
     
     missle->status = MISSILE_ACTIVE;
-    
-    insertHead(missileDLL, missle);
+    missle->path.launch = world->missiles.tick;
+    missile_plan(world, missle);
+    if(missle->path.city >= 0)
+        missile_threat_add(&world->missiles, missle - world->missiles.missile);
 }
 
 /** This function update the position of all missiles and draw them
 */
-void missile_update_position(void){    
-    //controls how fast the missile will move
-    int rate = MISSILE_SPEED * 25;
-    //delta_x and delta_y account for the slope of the missile
-    double delta_x, delta_y;
-     
-    MISSILE* newMissile = (MISSILE*)getHead(missileDLL);
+void missile_update_position(GAME_WORLD* world){    
     //iterate over all missiles
-    while(newMissile)
+    for(int i = 0; i < MAX_MISSILES; i++)
     {            
+        MISSILE* newMissile = &world->missiles.missile[i];
+        if(newMissile->status == MISSILE_FREE)
+            continue;
         if(newMissile->status == MISSILE_EXPLODED)
         {
             // clear the missile on the screen
             missile_draw(newMissile, BACKGROUND_COLOR);
                         
-            // Remove it from the list
-            newMissile = (MISSILE*)deleteForward(missileDLL, 1);
+            // Free its slot
+            if(newMissile->threat >= 0)
+                missile_threat_remove(&world->missiles, newMissile->threat);
+            newMissile->status = MISSILE_FREE;
         }
         else 
         {
@@ -74,40 +88,224 @@ void missile_update_position(void){
             missile_draw(newMissile, BACKGROUND_COLOR);
 
             // update missile position
-            delta_y = 200/rate;
-            delta_x = (newMissile->target_x - newMissile->source_x)/rate;
-            newMissile->y = (int)(delta_y*(newMissile->tick%rate));
-            newMissile->x = (int)(newMissile->source_x + delta_x*(newMissile->tick%rate));
+            missile_position(world, newMissile, newMissile->tick, &newMissile->x, &newMissile->y);
             // draw missile
             missile_draw(newMissile, MISSILE_COLOR);
             //update missile's internal tick
             newMissile->tick++;            
-            
-            // Advance the loop
-            newMissile = (MISSILE*)getNext(missileDLL);
         }       
     }
 }
 
+// See the comments in missile_public.h
+void missile_position(GAME_WORLD* world, const MISSILE* missile, int tick, int* x, int* y){
+    //controls how fast the missile will move
+    int rate = world->missiles.speed * 25;
+    //delta_x and delta_y account for the slope of the missile
+    double delta_y = 200/rate;
+    double delta_x = (missile->target_x - missile->source_x)/rate;
+    *y = (int)(delta_y*(tick%rate));
+    *x = (int)(missile->source_x + delta_x*(tick%rate));
+}
+
 // set missile speed (default speed is 4)
-void set_missile_speed(int speed){
+void set_missile_speed(GAME_WORLD* world, int speed){
     ASSERT_P(speed>=1 && speed<=8,ERROR_MISSILE_SPEED);
-    if(speed>=1 && speed<=8){  
-        MISSILE_SPEED = speed;
+    if(speed>=1 && speed<=8 && speed != world->missiles.speed){  
+        world->missiles.speed = speed;
+        // the missiles in flight take the new speed from where they are
+        missile_replan(world);
     }
 }
 
 // set missile interval (default interval is 10)
-void set_missile_interval(int interval){
+void set_missile_interval(GAME_WORLD* world, int interval){
     ASSERT_P(interval>=1 && interval<=100,ERROR_MISSILE_INTERVAL);
     if(interval>=1 && interval<=100){
-        MISSILE_INTERVAL = interval;
+        world->missiles.interval = interval;
+    }
+}
+
+// See the comments in missile_public.h
+void missile_replan(GAME_WORLD* world){
+    MISSILE_STATE* missiles = &world->missiles;
+    missiles->threats = 0;
+    for(int i = 0; i < MAX_MISSILES; i++) {
+        MISSILE* missile = &missiles->missile[i];
+        missile->threat = -1;
+        if(missile->status != MISSILE_ACTIVE)
+            continue;
+        missile_plan(world, missile);
+        if(missile->path.city >= 0)
+            missile_threat_add(missiles, i);
+    }
+}
+
+// See the comments in missile_public.h
+int missile_threats(GAME_WORLD* world, MISSILE** out, int max){
+    MISSILE_STATE* missiles = &world->missiles;
+    // The heap's soonest is at the root, and each entry is sooner than its
+    // children: walk it from the root, always taking the soonest entry
+    // reached so far. The entries reached are kept in a heap of their own.
+    unsigned char open[MAX_MISSILES];
+    int opened = 0, found = 0;
+    if(missiles->threats > 0)
+        open[opened++] = 0;
+    while(found < max && opened > 0) {
+        int at = open[0];
+        open[0] = open[--opened];
+        missile_open_down(missiles, open, opened, 0);
+        MISSILE* missile = &missiles->missile[missiles->threat[at]];
+        if(missile->status == MISSILE_ACTIVE)
+            out[found++] = missile;
+        for(int child = 2*at+1; child <= 2*at+2 && child < missiles->threats; child++) {
+            open[opened++] = child;
+            missile_open_up(missiles, open, opened-1);
+        }
+    }
+    return found;
+}
+
+// See the comments in missile_public.h
+int missile_intercept(GAME_WORLD* world, const MISSILE* missile, int y, int climb, int* frames){
+    const MISSILE_PATH* path = &missile->path;
+    int delta_y = 200/path->rate;
+    // k frames from now the missile is drawn delta_y*(tick+k-1) down and
+    // the shot is at y-climb*k; they cross at the first k with the missile
+    // as low as the shot
+    int k = (y - delta_y*(missile->tick-1) + delta_y + climb - 1) / (delta_y + climb);
+    if(k < 1)
+        k = 1;
+    int tick = missile->tick + k - 1;
+    if(y - climb*k < 0 || tick >= path->rate || (path->impact >= 0 && tick > path->impact))
+        return -1;
+    *frames = k;
+    return (int)(missile->source_x + path->slope*tick);
+}
+
+void missile_redraw(GAME_WORLD* world){
+    for(int i = 0; i < MAX_MISSILES; i++)
+        if(world->missiles.missile[i].status == MISSILE_ACTIVE)
+            missile_draw(&world->missiles.missile[i], MISSILE_COLOR);
+}
+
+/** Work out where a missile comes down: the first of its ticks at which
+    it is below the screen, as checkCollisions() tests, or on a standing
+    city, as checkCityCollisions() tests. Only the ticks at which it is as
+    low as a city are stepped through.
+*/
+void missile_plan(GAME_WORLD* world, MISSILE* missile){
+    MISSILE_PATH* path = &missile->path;
+    CITY city[MAX_NUM_CITY];
+    int top = MISSILE_GROUND;
+    int x, y;
+    
+    path->rate = world->missiles.speed * 25;
+    path->slope = (missile->target_x - missile->source_x)/path->rate;
+    path->impact = -1;
+    path->impact_x = -1;
+    path->city = -1;
+    for(int i = 0; i < MAX_NUM_CITY; i++) {
+        city[i] = city_get_info(world, i);
+        if(city[i].status == EXIST && MISSILE_GROUND - city[i].height < top)
+            top = MISSILE_GROUND - city[i].height;
+    }
+    // past rate ticks the missile starts again from the top, on the same path
+    for(int t = top/(200/path->rate); t < path->rate; t++) {
+        missile_position(world, missile, t, &x, &y);
+        if(y > MISSILE_GROUND) {
+            path->impact = t;
+            path->impact_x = x;
+            return;
+        }
+        for(int i = 0; i < MAX_NUM_CITY; i++) {
+            if(city[i].status == EXIST && x >= city[i].x && x <= city[i].x + city[i].width &&
+               y >= MISSILE_GROUND - city[i].height && y < MISSILE_GROUND) {
+                path->impact = t;
+                path->impact_x = x;
+                path->city = i;
+                return;
+            }
+        }
+    }
+}
+
+// The generator tick at which the missile in a slot hits its city
+int missile_threat_key(MISSILE_STATE* missiles, int slot){
+    return missiles->missile[slot].path.launch + missiles->missile[slot].path.impact;
+}
+
+void missile_threat_swap(MISSILE_STATE* missiles, int a, int b){
+    unsigned char slot = missiles->threat[a];
+    missiles->threat[a] = missiles->threat[b];
+    missiles->threat[b] = slot;
+    missiles->missile[missiles->threat[a]].threat = a;
+    missiles->missile[missiles->threat[b]].threat = b;
+}
+
+// Move the entry at a place in the threat heap up or down to where it belongs
+void missile_threat_sift(MISSILE_STATE* missiles, int at){
+    while(at > 0 && missile_threat_key(missiles, missiles->threat[at]) < missile_threat_key(missiles, missiles->threat[(at-1)/2])) {
+        missile_threat_swap(missiles, at, (at-1)/2);
+        at = (at-1)/2;
     }
+    for(;;) {
+        int soonest = at;
+        for(int child = 2*at+1; child <= 2*at+2 && child < missiles->threats; child++)
+            if(missile_threat_key(missiles, missiles->threat[child]) < missile_threat_key(missiles, missiles->threat[soonest]))
+                soonest = child;
+        if(soonest == at)
+            return;
+        missile_threat_swap(missiles, at, soonest);
+        at = soonest;
+    }
+}
+
+void missile_threat_add(MISSILE_STATE* missiles, int slot){
+    int at = missiles->threats++;
+    missiles->threat[at] = slot;
+    missiles->missile[slot].threat = at;
+    missile_threat_sift(missiles, at);
+}
+
+void missile_threat_remove(MISSILE_STATE* missiles, int at){
+    int last = --missiles->threats;
+    missiles->missile[missiles->threat[at]].threat = -1;
+    if(at == last)
+        return;
+    missiles->threat[at] = missiles->threat[last];
+    missiles->missile[missiles->threat[at]].threat = at;
+    missile_threat_sift(missiles, at);
 }
 
-// See comments in missile_public.h
-DLinkedList* get_missile_list() {
-    return missileDLL;
+// The walk in missile_threats() keeps places in the threat heap in a heap
+// of its own, on the same key
+int missile_open_key(MISSILE_STATE* missiles, unsigned char* open, int i){
+    return missile_threat_key(missiles, missiles->threat[open[i]]);
+}
+
+void missile_open_up(MISSILE_STATE* missiles, unsigned char* open, int at){
+    while(at > 0 && missile_open_key(missiles, open, at) < missile_open_key(missiles, open, (at-1)/2)) {
+        unsigned char place = open[at];
+        open[at] = open[(at-1)/2];
+        open[(at-1)/2] = place;
+        at = (at-1)/2;
+    }
+}
+
+void missile_open_down(MISSILE_STATE* missiles, unsigned char* open, int opened, int at){
+    for(;;) {
+        int soonest = at;
+        for(int child = 2*at+1; child <= 2*at+2 && child < opened; child++)
+            if(missile_open_key(missiles, open, child) < missile_open_key(missiles, open, soonest))
+                soonest = child;
+        if(soonest == at)
+            return;
+        unsigned char place = open[at];
+        open[at] = open[soonest];
+        open[soonest] = place;
+        at = soonest;
+    }
 }
 
 /** This function draw a missile.
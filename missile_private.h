@@ -8,18 +8,31 @@
 #include "mbed.h"
 #include "globals.h"
 #include "missile_public.h"
+#include "city_landscape_public.h"
+#include "profile_public.h"
+#include "game_public.h"
 
 //==== [private settings] ====
-int MISSILE_INTERVAL = 10;
-int MISSILE_SPEED = 6;
+#define MISSILE_INTERVAL 10   // until set_missile_interval()
+#define MISSILE_SPEED 6        // until set_missile_speed()
 #define MISSILE_COLOR    0xFF0000
+#define MISSILE_GROUND 128      // missiles lower than this have come down
 
 //==== [private type] ====
 
 //==== [private function] ====
-void missile_create(void);
-void missile_update_position(void);
+void missile_create(GAME_WORLD* world);
+void missile_update_position(GAME_WORLD* world);
 void missile_draw(MISSILE* missile, int color);
+void missile_plan(GAME_WORLD* world, MISSILE* missile);
+int missile_threat_key(MISSILE_STATE* missiles, int slot);
+void missile_threat_swap(MISSILE_STATE* missiles, int a, int b);
+void missile_threat_sift(MISSILE_STATE* missiles, int at);
+void missile_threat_add(MISSILE_STATE* missiles, int slot);
+void missile_threat_remove(MISSILE_STATE* missiles, int at);
+int missile_open_key(MISSILE_STATE* missiles, unsigned char* open, int i);
+void missile_open_up(MISSILE_STATE* missiles, unsigned char* open, int at);
+void missile_open_down(MISSILE_STATE* missiles, unsigned char* open, int opened, int at);
 
 #endif //MISSILE_PRIVATE_H
 
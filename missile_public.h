@@ -6,13 +6,27 @@
 #ifndef MISSILE_PUBLIC_H
 #define MISSILE_PUBLIC_H
 
-#include "doubly_linked_list.h"
+#include <stdint.h>
 
 typedef enum {
     MISSILE_EXPLODED=0,
     MISSILE_ACTIVE=1,
+    MISSILE_FREE=2,          ///< The slot holds no missile
 } MISSILE_STATUS;
 
+#define MAX_MISSILES 16
+
+/// Where a missile will come down, worked out when it is launched and
+/// again whenever a city falls or the speed changes
+typedef struct {
+    int launch;              ///< missile_generator() tick it was launched on
+    double slope;            ///< Pixels it moves sideways each tick
+    int16_t rate;            ///< Its ticks from the top of the screen to the bottom
+    int16_t impact;          ///< Its tick when it hits, -1 if it never comes down
+    int16_t impact_x;        ///< The x-coordinate where it hits
+    int16_t city;            ///< The city it hits, -1 for the ground
+} MISSILE_PATH;
+
 /// The structure to store the information of a missile
 typedef struct {
     int x;                   ///< The x-coordinate of missile current position
@@ -21,33 +35,80 @@ typedef struct {
     double target_x;           ///< The x-coordinate of the missile's target
     int tick;                  ///< The missile's internal tick
     MISSILE_STATUS status;   ///< The missile status, see MISSILE_STATUS
+    MISSILE_PATH path;       ///< Where it will come down
+    int threat;              ///< Its place in MISSILE_STATE.threat, -1 if not there
 } MISSILE;
 
-/** Call missile_init() only once at the begining of your code */
-void missile_init(void);
+/// The missile module's part of a GAME_WORLD.  Marking a missile with
+/// status MISSILE_EXPLODED will cue its erasure from the screen and the
+/// freeing of its slot at the next missile_generator() call.
+typedef struct {
+    MISSILE missile[MAX_MISSILES];  ///< In no order; free slots are MISSILE_FREE
+    int tick;               ///< missile_generator() calls this game
+    int interval;           ///< See set_missile_interval()
+    int speed;              ///< See set_missile_speed()
+    unsigned int dropped;   ///< Missiles not launched because every slot was taken
+    /// The missiles headed for a city, as a heap on the generator tick they
+    /// hit at: soonest first
+    unsigned char threat[MAX_MISSILES];
+    int threats;
+} MISSILE_STATE;
 
-/** Call missile_init() only once at the begining of your code */
-void missile_init(void);
+/// All of one game's state, see game_public.h
+typedef struct GAME_WORLD GAME_WORLD;
 
-/** This function draw the missiles onto the screen
-    Call missile_generator() repeatedly in your game-loop. ex: main()
+/** Call missile_init() at the begining of each game; missiles left from
+    the last game are cleared
 */
-void missile_generator(void);
+void missile_init(GAME_WORLD* world);
 
-/** This function will return a linked-list of all active MISSILE structures.
-    This can be used to modify the active missiles. Marking missiles with status
-    MISSILE_EXPLODED will cue their erasure from the screen and removal from the
-    list at the next missile_generator() call.
+/** This function draw the missiles onto the screen
+    Call missile_generator() repeatedly in your game-loop. ex: main()
 */
-DLinkedList* get_missile_list();
+void missile_generator(GAME_WORLD* world);
 
 /** Set the speed of missiles, Speed has range of 1-8 with 1 being fastest and 8 being slowest
 */
-void set_missile_speed(int speed);
+void set_missile_speed(GAME_WORLD* world, int speed);
 
 /** Set the interval that the missiles fire, interval has range of 1-100 with 1 being fired in
     very quick succession and 100 being fired very slowly after one another
 */
-void set_missile_interval(int interval);
+void set_missile_interval(GAME_WORLD* world, int interval);
+
+/** Where a missile is drawn when its tick is tick, at the current speed.
+    missile_generator() moves each missile to its tick and then counts the
+    tick up, so n calls from now it will be at missile->tick+n-1.
+*/
+void missile_position(GAME_WORLD* world, const MISSILE* missile, int tick, int* x, int* y);
+
+/** Work out every missile's path again, after a city has fallen; the
+    missiles that were headed for it now come down somewhere else
+*/
+void missile_replan(GAME_WORLD* world);
+
+/** The missiles that will hit a city, soonest first. Missiles that have
+    exploded since the last missile_generator() are left out.
+    Takes O(log n) for each missile returned.
+    @param out Filled with the missiles
+    @param max The most to return
+    @return How many were returned
+*/
+int missile_threats(GAME_WORLD* world, MISSILE** out, int max);
+
+/** Where a shot now at height y, climbing climb pixels a frame, crosses
+    the path of a missile, from the missile's path, without stepping
+    through the frames in between
+    @param frames Set to the frames until then; the shot is checked
+                  against the missile at the end of each
+    @return The missile's x-coordinate then, or -1 if the missile comes
+            down first or the shot leaves the screen
+*/
+int missile_intercept(GAME_WORLD* world, const MISSILE* missile, int y, int climb, int* frames);
+
+/** Draw every missile in flight, as after restoring a game; the screen
+    is assumed clear
+*/
+void missile_redraw(GAME_WORLD* world);
 
 #endif //MISSILE_PUBLIC_H
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include "mbed.h"
 #include "globals.h"
 #include "player_public.h"
+#include "game_public.h"
 
 //==== [private settings] ====
 #define PLAYER_INIT_X 60
@@ -17,14 +18,11 @@
 #define PLAYER_WIDTH 10 
 #define PLAYER_HEIGHT 3
 #define PLAYER_COLOR 0x0000FF //blue
-#define PLAYER_MISSILE_SPEED 3
 #define PLAYER_MISSILE_COLOR 0x0000FF //blue
 
 
 //==== [private type] ====
 
-void player_draw(int color);
-void player_missile_draw(PLAYER_MISSILE* missile, int color);
 
 //==== [private function] ====
 
@@ -7,13 +7,16 @@
 #ifndef PLAYER_PUBLIC_H
 #define PLAYER_PUBLIC_H
 
-#include "doubly_linked_list.h"
-
 typedef enum {
     PMISSILE_EXPLODED = 0,
-    PMISSILE_ACTIVE = 1
+    PMISSILE_ACTIVE = 1,
+    PMISSILE_FREE = 2       // the slot holds no missile
 } PLAYER_MISSILE_STATUS; // is missile active or deactive?
 
+#define MAX_PLAYER_MISSILES 16
+#define PLAYER_MISSILE_SPEED 3 // pixels a missile climbs each player_missile_draw()
+#define PLAYER_MAX_X 117 // rightmost x the player can move to
+
 typedef struct {
     int x;                   ///< The x-coordinate of missile current position
     int y;                   ///< The y-coordinate of missile current position
@@ -30,22 +33,26 @@ typedef struct {
     int delta;     // delta x,y
     int width; int height;
     PLAYER_STATUS status;
-    DLinkedList* playerMissiles;
+    PLAYER_MISSILE playerMissiles[MAX_PLAYER_MISSILES]; // in no order, free slots are PMISSILE_FREE
+    unsigned int dropped;   // shots not fired because every slot was taken
 } PLAYER; // structure for player
 
+/// All of one game's state, see game_public.h
+typedef struct GAME_WORLD GAME_WORLD;
 
-PLAYER player_get_info(void);
-void player_init(void); // initialize the player's attributes
-void player_moveLeft(void); // move delta pixels to the left 
-void player_moveRight(void); // move delta pixels to the right
-void player_fire(void); // fire missiles
+PLAYER player_get_info(GAME_WORLD* world);
+void player_init(GAME_WORLD* world); // initialize the player's attributes
+void player_moveLeft(GAME_WORLD* world); // move delta pixels to the left 
+void player_moveRight(GAME_WORLD* world); // move delta pixels to the right
+void player_fire(GAME_WORLD* world); // fire missiles
 
-void player_missile_draw(void); // updates the drawing of missiles on screen
-void player_draw(int color);
+void player_missile_draw(GAME_WORLD* world); // updates the drawing of missiles on screen
+void player_draw(GAME_WORLD* world, int color);
+void player_redraw(GAME_WORLD* world); // draw the player and its missiles in flight on a clear screen
 
 //void player_missile_exploded(int i);
 //void player_missile_exploded(PLAYER_MISSILE *playerMissile); //method overload
 
-void player_destroy(void); // destroy the player to end game
+void player_destroy(GAME_WORLD* world); // destroy the player to end game
 
 #endif //PLAYER_PUBLIC_H
\ No newline at end of file
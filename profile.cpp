@@ -0,0 +1,96 @@
+// ============================================
+// The file implement the profile module
+// Fall 2016 Gatech ECE 2035
+//=============================================
+
+#include "profile_private.h"
+
+#if PROFILE_ENABLE
+
+const char* profile_names[PROFILE_ZONES] = {
+    "missile_gen", "collisions", "city_collide", "draw_cities",
+    "lcd cls", "lcd line", "lcd circle", "lcd triangle", "lcd rectangle",
+    "lcd pixel", "lcd locate", "lcd char", "lcd string", "lcd other",
+};
+
+ZONE_STATS profile_zones[PROFILE_ZONES];
+uint32_t profile_window;        // cycle count the zones were last cleared at
+Serial* profile_out = NULL;
+char profile_text[PROFILE_REPORT_SIZE];
+int profile_length = 0;
+int profile_sent = 0;
+
+void profile_init(Serial* out)
+{
+    profile_out = out;
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    memset(profile_zones, 0, sizeof(profile_zones));
+    profile_window = DWT->CYCCNT;
+}
+
+void profile_add(PROFILE_ZONE zone, uint32_t cycles)
+{
+    ZONE_STATS* stats = &profile_zones[zone];
+    if(stats->runs == 0 || cycles < stats->min)
+        stats->min = cycles;
+    if(cycles > stats->max)
+        stats->max = cycles;
+    stats->total += cycles;
+    stats->runs++;
+}
+
+PROFILE_ZONE profile_lcd_zone(char command)
+{
+    switch(command) {
+        case CLS: return PROFILE_LCD_CLS;
+        case LINE: return PROFILE_LCD_LINE;
+        case CIRCLE: case FCIRCLE: return PROFILE_LCD_CIRCLE;
+        case TRIANGLE: return PROFILE_LCD_TRIANGLE;
+        case RECTANGLE: case FRECTANGLE: return PROFILE_LCD_RECTANGLE;
+        case PIXEL: return PROFILE_LCD_PIXEL;
+        case MOVECURSOR: return PROFILE_LCD_LOCATE;
+        case TEXTCHAR: return PROFILE_LCD_CHAR;
+        case TEXTSTRING: return PROFILE_LCD_STRING;
+        default: return PROFILE_LCD_OTHER;
+    }
+}
+
+void profile_report(void)
+{
+    uint32_t now = DWT->CYCCNT;
+    unsigned int per_us = SystemCoreClock / 1000000;
+    int n;
+    
+    // the counter wraps every 44 s at 96 MHz, so report more often than that
+    n = snprintf(profile_text, PROFILE_REPORT_SIZE, "Profile, %u ms (cycles):\n",
+                 (unsigned int)((now - profile_window) / (per_us * 1000)));
+    for(int i = 0; i < PROFILE_ZONES && n < PROFILE_REPORT_SIZE; i++) {
+        ZONE_STATS* stats = &profile_zones[i];
+        if(stats->runs == 0)
+            continue;
+        n += snprintf(profile_text + n, PROFILE_REPORT_SIZE - n, "%-13s %6u runs %8u min %8u avg %9u max %6u us\n",
+                      profile_names[i], (unsigned int)stats->runs, (unsigned int)stats->min,
+                      (unsigned int)(stats->total / stats->runs), (unsigned int)stats->max,
+                      (unsigned int)(stats->max / per_us));
+    }
+    profile_length = n < PROFILE_REPORT_SIZE ? n : PROFILE_REPORT_SIZE - 1;
+    profile_sent = 0;
+    memset(profile_zones, 0, sizeof(profile_zones));
+    profile_window = now;
+}
+
+void profile_service(void)
+{
+    while(profile_sent < profile_length && profile_out != NULL && profile_out->writeable())
+        profile_out->putc(profile_text[profile_sent++]);
+}
+
+void profile_flush(void)
+{
+    while(profile_sent < profile_length && profile_out != NULL)
+        profile_out->putc(profile_text[profile_sent++]);
+}
+
+#endif //PROFILE_ENABLE
@@ -0,0 +1,23 @@
+// ============================================
+// The header file is for module "profile"
+// Fall 2016 Gatech ECE 2035
+//=============================================
+#ifndef PROFILE_PRIVATE_H
+#define PROFILE_PRIVATE_H
+
+#include "mbed.h"
+#include "globals.h"
+#include "profile_public.h"
+
+//==== [private settings] ====
+#define PROFILE_REPORT_SIZE 1024
+
+//==== [private type] ====
+typedef struct {
+    uint32_t runs;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+} ZONE_STATS;
+
+#endif //PROFILE_PRIVATE_H
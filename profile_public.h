@@ -0,0 +1,73 @@
+// ============================================
+// The header file is for module "profile"
+// Cycle counts of zones of code, from the Cortex-M3's DWT cycle counter,
+// with each zone's min/avg/max reported over a serial port.  Build with
+// PROFILE_ENABLE set to 0 to strip it all out.
+// Fall 2016 Gatech ECE 2035
+//=============================================
+/** @file profile_public.h */
+#ifndef PROFILE_PUBLIC_H
+#define PROFILE_PUBLIC_H
+
+#include "mbed.h"
+
+#ifndef PROFILE_ENABLE
+#define PROFILE_ENABLE 1
+#endif
+
+/// The zones measured
+typedef enum {
+    PROFILE_MISSILE_GENERATOR,
+    PROFILE_CHECK_COLLISIONS,
+    PROFILE_CHECK_CITY_COLLISIONS,
+    PROFILE_DRAW_CITIES,
+    // one for each kind of uLCD_4DGL command, ack included
+    PROFILE_LCD_CLS,
+    PROFILE_LCD_LINE,
+    PROFILE_LCD_CIRCLE,         ///< circle() and filled_circle()
+    PROFILE_LCD_TRIANGLE,
+    PROFILE_LCD_RECTANGLE,      ///< rectangle() and filled_rectangle()
+    PROFILE_LCD_PIXEL,
+    PROFILE_LCD_LOCATE,
+    PROFILE_LCD_CHAR,           ///< putc(), and so printf()
+    PROFILE_LCD_STRING,
+    PROFILE_LCD_OTHER,
+    PROFILE_ZONES
+} PROFILE_ZONE;
+
+#if PROFILE_ENABLE
+/** Start timing a zone: declares start, the cycle count now */
+#define PROFILE_BEGIN(start) uint32_t start = DWT->CYCCNT
+/** Add the cycles since PROFILE_BEGIN(start) to a zone */
+#define PROFILE_END(start, zone) profile_add((zone), DWT->CYCCNT - (start))
+#else
+#define PROFILE_BEGIN(start)
+#define PROFILE_END(start, zone)
+#endif
+
+/** Start the cycle counter and clear the zones
+    @param out Where reports are written
+*/
+void profile_init(Serial* out);
+
+/** Count one run of a zone; zones are timed with PROFILE_BEGIN/END */
+void profile_add(PROFILE_ZONE zone, uint32_t cycles);
+
+/** The zone of a uLCD_4DGL command, from its command byte */
+PROFILE_ZONE profile_lcd_zone(char command);
+
+/** Queue a report of each zone's runs and min/avg/max cycles since the
+    last one, and start the zones again. Nothing is written here; a
+    report not yet written out is replaced.
+*/
+void profile_report(void);
+
+/** Write as much of the report as the port takes without waiting; call
+    it often
+*/
+void profile_service(void);
+
+/** Write the rest of the report, waiting for the port */
+void profile_flush(void);
+
+#endif //PROFILE_PUBLIC_H
@@ -0,0 +1,98 @@
+// ============================================
+// The file implement the replay module
+// Fall 2016 Gatech ECE 2035
+//=============================================
+
+#include "replay_private.h"
+
+FILE* replay_file = NULL;
+REPLAY_HEADER replay_header;
+GAME_INPUT replay_block[REPLAY_BLOCK];
+unsigned int replay_used = 0;   // inputs in replay_block
+unsigned int replay_next = 0;   // next one to read back
+int replay_error = 0;
+
+int replay_record(const char* path, uint32_t seed, int level)
+{
+    replay_file = fopen(path, "wb");
+    if(replay_file == NULL)
+        return -1;
+    replay_header.magic = REPLAY_MAGIC;
+    replay_header.version = REPLAY_VERSION;
+    replay_header.seed = seed;
+    replay_header.level = level;
+    replay_header.frames = 0;
+    replay_header.score = 0;
+    replay_used = 0;
+    replay_error = fwrite(&replay_header, sizeof(replay_header), 1, replay_file) != 1;
+    return replay_error ? -1 : 0;
+}
+
+void replay_flush(void)
+{
+    if(replay_used && !replay_error)
+        replay_error = fwrite(replay_block, sizeof(GAME_INPUT), replay_used, replay_file) != replay_used;
+    replay_used = 0;
+}
+
+void replay_write(const GAME_INPUT* input)
+{
+    if(replay_file == NULL)
+        return;
+    replay_block[replay_used++] = *input;
+    if(replay_used == REPLAY_BLOCK)
+        replay_flush();
+}
+
+int replay_finish(uint32_t frames, int score)
+{
+    if(replay_file == NULL)
+        return -1;
+    replay_flush();
+    replay_header.frames = frames;
+    replay_header.score = score;
+    if(fseek(replay_file, 0, SEEK_SET) ||
+       fwrite(&replay_header, sizeof(replay_header), 1, replay_file) != 1)
+        replay_error = 1;
+    if(fclose(replay_file))
+        replay_error = 1;
+    replay_file = NULL;
+    return replay_error ? -1 : 0;
+}
+
+int replay_open(const char* path, REPLAY_HEADER* header)
+{
+    replay_file = fopen(path, "rb");
+    if(replay_file == NULL)
+        return -1;
+    if(fread(&replay_header, sizeof(replay_header), 1, replay_file) != 1 ||
+       replay_header.magic != REPLAY_MAGIC || replay_header.version != REPLAY_VERSION) {
+        replay_close();
+        return -1;
+    }
+    *header = replay_header;
+    replay_used = 0;
+    replay_next = 0;
+    return 0;
+}
+
+int replay_read(GAME_INPUT* input)
+{
+    if(replay_file == NULL)
+        return 0;
+    if(replay_next == replay_used) {
+        replay_used = fread(replay_block, sizeof(GAME_INPUT), REPLAY_BLOCK, replay_file);
+        replay_next = 0;
+        if(replay_used == 0)
+            return 0;
+    }
+    *input = replay_block[replay_next++];
+    return 1;
+}
+
+void replay_close(void)
+{
+    if(replay_file != NULL)
+        fclose(replay_file);
+    replay_file = NULL;
+}
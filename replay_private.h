@@ -0,0 +1,18 @@
+// ============================================
+// The header file is for module "replay"
+// Fall 2016 Gatech ECE 2035
+//=============================================
+#ifndef REPLAY_PRIVATE_H
+#define REPLAY_PRIVATE_H
+
+#include <stdio.h>
+#include "replay_public.h"
+
+//==== [private settings] ====
+// inputs per file access: a 512 byte sector
+#define REPLAY_BLOCK (512/sizeof(GAME_INPUT))
+
+//==== [private function] ====
+void replay_flush(void);
+
+#endif //REPLAY_PRIVATE_H
@@ -0,0 +1,57 @@
+// ============================================
+// The header file is for module "replay"
+// Records the input a game was given, so it can be played again exactly
+// Fall 2016 Gatech ECE 2035
+//=============================================
+/** @file replay_public.h */
+#ifndef REPLAY_PUBLIC_H
+#define REPLAY_PUBLIC_H
+
+#include <stdint.h>
+#include "game_public.h"
+
+/// The start of a replay file.  frames and score are filled in when the
+/// recording is finished, so a replay can check it ended the same way.
+typedef struct {
+    uint32_t magic;     ///< REPLAY_MAGIC
+    uint32_t version;   ///< REPLAY_VERSION
+    uint32_t seed;      ///< The game's random seed
+    int32_t level;      ///< The level it started on
+    uint32_t frames;    ///< Frames played
+    int32_t score;      ///< Final score
+} REPLAY_HEADER;
+
+#define REPLAY_MAGIC 0x5052434D   // "MCRP"
+#define REPLAY_VERSION 3   // 2: the player is hit where it is, not where it started
+                           // 3: every interceptor can hit every missile; pools of 16
+
+/** Start recording to a file, replacing it
+    @return 0 on success
+*/
+int replay_record(const char* path, uint32_t seed, int level);
+
+/** Add one input, a run of the input task, to the recording. Inputs are kept in RAM and written a
+    sector at a time.
+*/
+void replay_write(const GAME_INPUT* input);
+
+/** Write what is left, fill in the header and close the file
+    @return 0 if the whole recording was written
+*/
+int replay_finish(uint32_t frames, int score);
+
+/** Open a recording to play it back
+    @param header Where to store its header
+    @return 0 on success
+*/
+int replay_open(const char* path, REPLAY_HEADER* header);
+
+/** Take the next input of the recording
+    @return 1 if there was one, 0 at the end
+*/
+int replay_read(GAME_INPUT* input);
+
+/** Close the recording being played back */
+void replay_close(void);
+
+#endif //REPLAY_PUBLIC_H
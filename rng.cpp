@@ -0,0 +1,29 @@
+// ============================================
+// The file implement the rng module
+// Fall 2016 Gatech ECE 2035
+//=============================================
+
+#include "rng_private.h"
+
+void rng_seed(RNG* rng, uint32_t seed)
+{
+    rng->state = seed ? seed : RNG_ZERO_SEED;
+}
+
+// Marsaglia's 13/17/5 xorshift: three shifts and xors, period 2^32-1
+uint32_t rng_next(RNG* rng)
+{
+    uint32_t x = rng->state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    rng->state = x;
+    return x;
+}
+
+int rng_range(RNG* rng, int n)
+{
+    // the top bits scaled to n: a multiply instead of a divide, and no
+    // bias from xorshift's weaker low bits
+    return (int)(((uint64_t)rng_next(rng) * (uint32_t)n) >> 32);
+}
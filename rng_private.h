@@ -0,0 +1,14 @@
+// ============================================
+// The header file is for module "rng"
+// Fall 2016 Gatech ECE 2035
+//=============================================
+#ifndef RNG_PRIVATE_H
+#define RNG_PRIVATE_H
+
+#include "rng_public.h"
+
+//==== [private settings] ====
+// xorshift gets stuck on 0, so that seed is swapped for this one
+#define RNG_ZERO_SEED 0x9E3779B9
+
+#endif //RNG_PRIVATE_H
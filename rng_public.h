@@ -0,0 +1,31 @@
+// ============================================
+// The header file is for module "rng"
+// A small, fast random number generator with its state in the open, so a
+// game can be reseeded and played again exactly
+// Fall 2016 Gatech ECE 2035
+//=============================================
+/** @file rng_public.h */
+#ifndef RNG_PUBLIC_H
+#define RNG_PUBLIC_H
+
+#include <stdint.h>
+
+/// The generator's whole state (xorshift32)
+typedef struct {
+    uint32_t state;
+} RNG;
+
+/** Start a generator; the same seed always gives the same numbers
+    @param seed Any value, 0 included
+*/
+void rng_seed(RNG* rng, uint32_t seed);
+
+/** The next number, all 32 bits */
+uint32_t rng_next(RNG* rng);
+
+/** The next number in 0 to n-1
+    @param n Number of values, at least 1
+*/
+int rng_range(RNG* rng, int n);
+
+#endif //RNG_PUBLIC_H
@@ -0,0 +1,119 @@
+// ============================================
+// The file implement the scheduler module
+// Fall 2016 Gatech ECE 2035
+//=============================================
+
+#include "scheduler_private.h"
+
+TASK sched_tasks[SCHED_MAX_TASKS];
+int sched_count = 0;
+unsigned int sched_run_us = 0;
+unsigned int sched_idle_us = 0;
+
+Timeout sched_timer;
+volatile int sched_woken = 0;
+
+void sched_reset(void)
+{
+    sched_count = 0;
+    sched_run_us = 0;
+    sched_idle_us = 0;
+}
+
+int sched_add(const char* name, void (*run)(void), int priority, int period_ms, int deadline_ms)
+{
+    if(sched_count >= SCHED_MAX_TASKS)
+        return -1;
+    TASK* task = &sched_tasks[sched_count];
+    task->name = name;
+    task->run = run;
+    task->priority = priority;
+    task->period_us = period_ms * 1000;
+    task->deadline_us = deadline_ms * 1000;
+    memset(&task->stats, 0, sizeof(task->stats));
+    return sched_count++;
+}
+
+void sched_wakeup(void)
+{
+    sched_woken = 1;
+}
+
+// sleep until the us ticker reaches until, or any interrupt
+void sched_idle(unsigned int until)
+{
+    unsigned int start = us_ticker_read();
+    int wait = (int)(until - start);
+    if(wait <= 0)
+        return;
+    sched_woken = 0;
+    sched_timer.attach_us(&sched_wakeup, wait);
+    __disable_irq();
+    if(!sched_woken)
+        sleep();
+    __enable_irq();
+    sched_timer.detach();
+    sched_idle_us += us_ticker_read() - start;
+}
+
+void sched_run(volatile int* stop)
+{
+    unsigned int start = us_ticker_read();
+    for(int i = 0; i < sched_count; i++)
+        sched_tasks[i].release = start;
+
+    while(!*stop) {
+        // the most urgent task that is due, and the time the next one is
+        unsigned int now = us_ticker_read();
+        TASK* next = NULL;
+        unsigned int soonest = now + 1000000;
+        for(int i = 0; i < sched_count; i++) {
+            TASK* task = &sched_tasks[i];
+            if((int)(task->release - now) <= 0) {
+                if(next == NULL || task->priority < next->priority)
+                    next = task;
+            }
+            else if((int)(task->release - soonest) < 0)
+                soonest = task->release;
+        }
+        if(next == NULL) {
+            sched_idle(soonest);
+            continue;
+        }
+
+        unsigned int begin = us_ticker_read();
+        next->run();
+        unsigned int end = us_ticker_read();
+        unsigned int us = end - begin;
+        next->stats.runs++;
+        next->stats.cpu_us += us;
+        if(us > next->stats.max_us)
+            next->stats.max_us = us;
+        if(end - next->release > next->deadline_us)
+            next->stats.missed++;
+        // a task a whole period behind drops the releases it missed
+        next->release += next->period_us;
+        while((int)(end - next->release) >= (int)next->period_us) {
+            next->release += next->period_us;
+            next->stats.skipped++;
+        }
+    }
+    sched_run_us += us_ticker_read() - start;
+}
+
+void sched_get_stats(int id, TASK_STATS* stats)
+{
+    *stats = sched_tasks[id].stats;
+}
+
+void sched_report(void)
+{
+    unsigned int total = sched_run_us ? sched_run_us : 1;
+    for(int i = 0; i < sched_count; i++) {
+        TASK_STATS* s = &sched_tasks[i].stats;
+        printf("%-8s %6u runs, cpu %3u%%, %5u us mean, %6u us max, %u missed, %u skipped\n",
+               sched_tasks[i].name, s->runs, (unsigned int)((unsigned long long)s->cpu_us * 100 / total),
+               s->runs ? s->cpu_us / s->runs : 0, s->max_us, s->missed, s->skipped);
+    }
+    printf("idle     %u of %u ms asleep\n", sched_idle_us / 1000, sched_run_us / 1000);
+}
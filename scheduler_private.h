@@ -0,0 +1,30 @@
+// ============================================
+// The header file is for module "scheduler"
+// Fall 2016 Gatech ECE 2035
+//=============================================
+#ifndef SCHEDULER_PRIVATE_H
+#define SCHEDULER_PRIVATE_H
+
+#include "mbed.h"
+#include "sleep_api.h"
+#include "scheduler_public.h"
+
+//==== [private settings] ====
+#define SCHED_MAX_TASKS 8
+
+//==== [private type] ====
+typedef struct {
+    const char* name;
+    void (*run)(void);
+    int priority;
+    unsigned int period_us;
+    unsigned int deadline_us;
+    unsigned int release;     // us ticker time it is next due
+    TASK_STATS stats;
+} TASK;
+
+//==== [private function] ====
+void sched_wakeup(void);
+void sched_idle(unsigned int until);
+
+#endif //SCHEDULER_PRIVATE_H
@@ -0,0 +1,48 @@
+// ============================================
+// The header file is for module "scheduler"
+// Periodic tasks run to completion in priority order
+// Fall 2016 Gatech ECE 2035
+//=============================================
+/** @file scheduler_public.h */
+#ifndef SCHEDULER_PUBLIC_H
+#define SCHEDULER_PUBLIC_H
+
+/// What a task has cost so far
+typedef struct {
+    unsigned int runs;      ///< Times it has run
+    unsigned int cpu_us;    ///< Total time spent in it
+    unsigned int max_us;    ///< Its longest run
+    unsigned int missed;    ///< Runs that finished after their deadline
+    unsigned int skipped;   ///< Releases dropped because it was a whole period behind
+} TASK_STATS;
+
+/** Remove all tasks and clear the statistics */
+void sched_reset(void);
+
+/** Add a periodic task
+    Tasks are cooperative: each run returns before the next task starts.
+    When more than one is due, the one with the lowest priority number
+    runs first. A task is first due when sched_run() starts.
+    @param name Name for sched_report()
+    @param run The work, done once per period
+    @param priority 0 is the most urgent
+    @param period_ms Time between releases
+    @param deadline_ms A run must finish within this of its release, or it counts as missed
+    @return The task's id, or -1 if the table is full
+*/
+int sched_add(const char* name, void (*run)(void), int priority, int period_ms, int deadline_ms);
+
+/** Run the tasks until *stop is set by one of them
+    Between tasks the CPU sleeps until the next release or an interrupt.
+*/
+void sched_run(volatile int* stop);
+
+/** Get the statistics of a task */
+void sched_get_stats(int id, TASK_STATS* stats);
+
+/** Print each task's CPU time, longest run and missed deadlines, and the
+    time spent asleep
+*/
+void sched_report(void);
+
+#endif //SCHEDULER_PUBLIC_H
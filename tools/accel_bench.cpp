@@ -0,0 +1,288 @@
+//-----------------------------------------------------------------------------
+// accel_bench -- host benchmark for MMA8452 background sampling against a
+// blocking read per frame.  The accelerometer model in tools/host samples a
+// slow tilt with some noise at the data rate while the game loop runs at its
+// own frame rate, two ways:
+//   polled      readXYZMilliG() every frame, as play() does without INT1
+//   background  startSampling() on INT1, and readFilteredMilliG() every frame;
+//               every INPUT_PERIOD_MS the ring is emptied with readSample(),
+//               as a consumer of every sample would, so its overruns are
+//               samples such a consumer would miss
+// each at 100 kHz and at 400 kHz (fast mode), and reports the I2C time the
+// game loop waits per frame, the bus time per sample, and how far the
+// readings are from the true tilt.  A read of the three axes is 9 bytes on
+// the bus with 12 bit samples: two addresses, the register and six of data.
+//
+// A table follows of the bus time of a background read, and the share of
+// the bus it takes, for each bit depth and data rate at both clocks; 8 bit
+// samples use fast read mode (MMA8452::setLowLatency), 3 bytes of data.
+//
+// On the host the background read runs inside the pin interrupt handler;
+// on the LPC1768 it runs from the I2C interrupt, so its bus time is spent
+// in neither the game loop nor the pin handler.  There, the time per sample
+// including interrupt overhead is in MMA8452::SamplingStats, which the game
+// prints at game over.
+//
+// The checks include a read NACKed by the part: it is tried again at once,
+// and once MMA8452_READ_RETRIES run out the next reader starts it again, as
+// INT1 stays low with no edge to come.
+//
+// Build on the host:
+//   g++ -O2 -I tools/host -I MMA8452 -o accel_bench tools/accel_bench.cpp
+//     MMA8452/MMA8452.cpp tools/host/mbed_host.cpp tools/host/mma8452_sim.cpp
+//
+// Usage:
+//   accel_bench [frames] [frame_hz] [smoothing]
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "MMA8452.h"
+#include "mma8452_sim.h"
+
+Serial pc(USBTX,USBRX);
+static mma8452_sim sensor(p29);
+static MMA8452 accel(p28,p27,100000);
+static int bad;
+
+// the game's input task period, in main.cpp
+#define INPUT_PERIOD_MS 20
+
+typedef struct {
+  double wait,worst;      // game loop bus time, total and slowest frame
+  double bus;             // all bus time while running
+  double error;           // RMS of reading minus true tilt, in G
+  unsigned samples;
+  unsigned taken;         // samples taken from the ring
+} RESULT;
+
+static double tilt(double t)
+{
+  return 0.5*sin(2*M_PI*0.2*t);
+}
+
+static double noise()
+{
+  return ((rand() % 2001)-1000)*0.00006;   // +-0.06G
+}
+
+// empty the ring
+static unsigned take()
+{
+  MMA8452::Sample s;
+  unsigned n=0;
+  while (!accel.readSample(&s))
+    n++;
+  return n;
+}
+
+// run the frames with the sensor sampling at its data rate in between; read()
+// is what the game loop does each frame, and with drain set the ring is
+// emptied every INPUT_PERIOD_MS
+static RESULT run(unsigned frames, double frame_hz, int (*read)(double *, double *, double *), int drain)
+{
+  RESULT r={0,0,0,0,0,0};
+  double hz=sensor.rate(),sum2=0;
+  double bus0=i2c_host_stats.seconds;
+  unsigned samples0=sensor.stats.samples,k=0,d=0;
+
+  srand(5);
+  for (unsigned f=0;f<frames;f++) {
+    double now=f/frame_hz;
+    for (;k/hz <= now;k++) {
+      for (;drain && d*INPUT_PERIOD_MS/1000.0 <= k/hz;d++)
+        r.taken+=take();
+      sensor.sample(tilt(k/hz)+noise(),noise(),1+noise());
+    }
+    double x=0,y=0,z=0,t0=i2c_host_stats.seconds;
+    if (read(&x,&y,&z) && f > 0)
+      bad++;
+    double wait=i2c_host_stats.seconds-t0;
+    r.wait+=wait;
+    if (wait > r.worst)
+      r.worst=wait;
+    sum2+=(x-tilt(now))*(x-tilt(now));
+  }
+  r.bus=i2c_host_stats.seconds-bus0;
+  r.error=sqrt(sum2/frames);
+  r.samples=sensor.stats.samples-samples0;
+  return r;
+}
+
+// milli-G readings, in G for the error
+static int polled(double *x, double *y, double *z)
+{
+  int mx,my,mz;
+  if (accel.readXYZMilliG(&mx,&my,&mz))
+    return 1;
+  *x=mx/1000.0;
+  *y=my/1000.0;
+  *z=mz/1000.0;
+  return 0;
+}
+
+static int filtered(double *x, double *y, double *z)
+{
+  int mx,my,mz;
+  double gx,gy,gz;
+  if (accel.readFilteredMilliG(&mx,&my,&mz) || accel.readFilteredGravity(&gx,&gy,&gz))
+    return 1;
+  // the two agree to the milli-G
+  if (fabs(gx*1000-mx) > 1 || fabs(gy*1000-my) > 1 || fabs(gz*1000-mz) > 1)
+    bad++;
+  *x=mx/1000.0;
+  *y=my/1000.0;
+  *z=mz/1000.0;
+  return 0;
+}
+
+// bus time per background read at each data rate, bit depth and clock
+static void depth_table(int smoothing)
+{
+  static const char *rates[8]={"800","400","200","100","50","12.5","6.25","1.563"};
+  static const double rate_hz[8]={800,400,200,100,50,12.5,6.25,1.563};
+  static const int bus_hz[2]={100000,400000};
+  MMA8452::SamplingStats stats;
+
+  printf("background read: bus us (share of the bus at the data rate)\n");
+  printf("  ODR Hz |   12 bit 100k  |   12 bit 400k  |   8 bit 100k   |   8 bit 400k   |\n");
+  for (int r=0;r<8;r++) {
+    MMA8452::DataRateHz rate=(MMA8452::DataRateHz)r;
+    printf("  %6s |",rates[r]);
+    for (int depth=0;depth<2;depth++)
+      for (int i=0;i<2;i++) {
+        accel.setFrequency(bus_hz[i]);
+        if (depth)
+          accel.setLowLatency(rate);
+        else
+          accel.setBitDepth(MMA8452::BIT_DEPTH_12);
+        if (accel.startSampling(p29,rate,smoothing)) {
+          bad++;
+          return;
+        }
+        double bus0=i2c_host_stats.seconds;
+        for (int k=0;k<64;k++)
+          sensor.sample(0.3,-0.2,1);
+        double per_read=(i2c_host_stats.seconds-bus0)/64;
+        int x,y,z;
+        accel.getSamplingStats(&stats);
+        // a sample left from before may be read first; the average is
+        // within a count of the tilt, 1000/64 milli-G at 8 bits
+        if (stats.samples < 64 || accel.readFilteredMilliG(&x,&y,&z) ||
+            abs(x-300) > (depth ? 16 : 1) || abs(y+200) > (depth ? 16 : 1) || abs(z-1000) > (depth ? 16 : 1))
+          bad++;
+        printf(" %6.1f (%4.1f%%) |",per_read*1e6,per_read*rate_hz[r]*100);
+        accel.stopSampling();
+      }
+    printf("\n");
+  }
+}
+
+static void row(const char *name, RESULT r, unsigned frames)
+{
+  printf("  %-15s | %8.1f %8.1f | %6u %8.1f | %6.4f\n",name,r.wait/frames*1e6,r.worst*1e6,
+         r.samples,r.samples ? r.bus/r.samples*1e6 : 0,r.error);
+}
+
+int main(int argc, char **argv)
+{
+  unsigned frames=argc > 1 ? atoi(argv[1]) : 3000;
+  double frame_hz=argc > 2 ? atof(argv[2]) : 60;
+  int smoothing=argc > 3 ? atoi(argv[3]) : 2;
+  MMA8452::SamplingStats stats;
+  unsigned taken=0;
+  char id=0;
+
+  if (accel.getDeviceID(&id) || id != 0x2A) {
+    printf("no MMA8452 on the bus\n");
+    return 1;
+  }
+  accel.setDataRate(MMA8452::RATE_100);
+  printf("%u frames at %.0f Hz, sensor at %.0f Hz\n",frames,frame_hz,sensor.rate());
+  printf("                  |  loop wait us/frame | sensor samples    | RMS error\n");
+  printf("                  |     mean    worst   |  taken  bus us/ea |  G\n");
+  static const int bus_hz[2]={100000,400000};
+  char name[32];
+  for (int i=0;i<2;i++) {
+    accel.setFrequency(bus_hz[i]);
+    sprintf(name,"polled %dk",bus_hz[i]/1000);
+    row(name,run(frames,frame_hz,polled,0),frames);
+  }
+  for (int i=0;i<2;i++) {
+    accel.setFrequency(bus_hz[i]);
+    if (accel.startSampling(p29,MMA8452::RATE_100,smoothing)) {
+      printf("startSampling failed\n");
+      return 1;
+    }
+    sprintf(name,"background %dk",bus_hz[i]/1000);
+    RESULT r=run(frames,frame_hz,filtered,1);
+    row(name,r,frames);
+    accel.getSamplingStats(&stats);
+    taken=r.taken;
+    // emptied every INPUT_PERIOD_MS, the ring misses nothing at 100 Hz
+    if (stats.errors || stats.overruns || sensor.stats.ignored_writes)
+      bad++;
+  }
+  printf("background: %u samples read, %u taken from the ring every %d ms, %u overruns, %u errors;\n"
+         "  sensor overwrote %u, ignored %u writes\n",stats.samples,taken,INPUT_PERIOD_MS,stats.overruns,
+         stats.errors,sensor.stats.overwritten,sensor.stats.ignored_writes);
+
+  // the ring gives back the newest samples, exactly, when nothing takes them
+  MMA8452::Sample s,last;
+  int n=0;
+  for (int i=0;i<MMA8452_RING_SIZE+2;i++)
+    sensor.sample(0.1*i,0,1);
+  while (!accel.readSample(&s)) {
+    last=s;
+    n++;
+  }
+  int expect=(int8_t)sensor.regs[1] << 4 | sensor.regs[2] >> 4;
+  if (n != MMA8452_RING_SIZE-1 || last.x != expect)
+    bad++;
+
+  // register access pauses sampling; a sample taken meanwhile is not lost
+  accel.getSamplingStats(&stats);
+  unsigned before=stats.samples;
+  if (accel.getDataRate() != MMA8452::RATE_100)
+    bad++;
+  sensor.sample(0.25,0,1);
+  accel.getSamplingStats(&stats);
+  if (stats.samples != before+1)
+    bad++;
+
+  // NACKed reads: retried in the handler, then restarted by a reader
+  MMA8452::SamplingStats nacked;
+  int mx,my,mz;
+  sensor.nack=2;
+  sensor.sample(0.1,0,1);
+  accel.getSamplingStats(&nacked);
+  if (nacked.errors != stats.errors+2 || nacked.samples != stats.samples+1)
+    bad++;
+  sensor.nack=MMA8452_READ_RETRIES+1;
+  sensor.sample(0.2,0,1);
+  accel.getSamplingStats(&nacked);
+  int stalled=nacked.samples == stats.samples+1 && sensor.regs[0] != 0;
+  accel.readFilteredMilliG(&mx,&my,&mz);
+  for (int i=0;i<10;i++)
+    sensor.sample(0.2,0,1);
+  accel.getSamplingStats(&nacked);
+  int restarted=nacked.restarts == 1 && nacked.samples == stats.samples+12 && sensor.regs[0] == 0;
+  if (!stalled || !restarted || nacked.errors != stats.errors+2+MMA8452_READ_RETRIES+1)
+    bad++;
+  printf("NACKed reads: %u errors, %u restarted by a reader; sampling %s\n",nacked.errors-stats.errors,
+         nacked.restarts,restarted ? "restarted" : "stopped");
+
+  accel.stopSampling();
+  sensor.sample(0,0,1);
+  if (!InterruptIn(p29).read())
+    bad++;
+
+  depth_table(smoothing);
+
+  if (bad) {
+    printf("%d checks failed\n",bad);
+    return 1;
+  }
+  return 0;
+}
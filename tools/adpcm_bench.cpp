@@ -0,0 +1,90 @@
+//-----------------------------------------------------------------------------
+// adpcm_bench -- host throughput benchmark for the IMA-ADPCM decoder used by
+// wave_player.  Encodes a synthetic clip, then decodes it repeatedly and
+// reports decode speed, reconstruction SNR and the SD read bandwidth each
+// format needs at the clip's sample rate.
+//
+// Build on the host:
+//   g++ -O2 -I wave_player -o adpcm_bench tools/adpcm_bench.cpp wave_player/ima_adpcm.cpp
+//
+// Usage:
+//   adpcm_bench [sample_rate] [seconds] [block_align]
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <vector>
+#include "ima_adpcm.h"
+
+static double now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec+ts.tv_nsec*1e-9;
+}
+
+int main(int argc, char **argv)
+{
+  int rate=argc > 1 ? atoi(argv[1]) : 22050;
+  int seconds=argc > 2 ? atoi(argv[2]) : 10;
+  int block_align=argc > 3 ? atoi(argv[3]) : 256;
+  int spb=ima_adpcm_samples_per_block(block_align,1);
+  if (rate <= 0 || seconds <= 0 || spb == 0) {
+    fprintf(stderr,"usage: adpcm_bench [sample_rate] [seconds] [block_align]\n");
+    return 1;
+  }
+
+// a chirp plus some noise, roughly like the game's sound effects
+  int num_blocks=(rate*seconds+spb-1)/spb;
+  std::vector<short> pcm((size_t)num_blocks*spb);
+  srand(1);
+  for (size_t i=0;i<pcm.size();i++) {
+    double t=(double)i/rate;
+    double v=0.6*sin(2*M_PI*(200+400*t)*t)+0.1*((rand()%2001)-1000)/1000.0;
+    pcm[i]=(short)(v*32767);
+  }
+
+  std::vector<unsigned char> adpcm((size_t)num_blocks*block_align);
+  IMA_ADPCM_STATE state;
+  memset(&state,0,sizeof(state));
+  double t0=now();
+  for (int b=0;b<num_blocks;b++)
+    ima_adpcm_encode_block(&pcm[(size_t)b*spb],1,block_align,&state,&adpcm[(size_t)b*block_align]);
+  double enc=now()-t0;
+
+  std::vector<short> out(spb);
+  double err=0,sig=0;
+  for (int b=0;b<num_blocks;b++) {
+    ima_adpcm_decode_block(&adpcm[(size_t)b*block_align],block_align,1,&out[0]);
+    for (int i=0;i<spb;i++) {
+      double d=out[i]-pcm[(size_t)b*spb+i];
+      err+=d*d;
+      sig+=(double)pcm[(size_t)b*spb+i]*pcm[(size_t)b*spb+i];
+    }
+  }
+
+  int reps=0;
+  unsigned sink=0;
+  t0=now();
+  double dec;
+  do {
+    for (int b=0;b<num_blocks;b++) {
+      ima_adpcm_decode_block(&adpcm[(size_t)b*block_align],block_align,1,&out[0]);
+      sink+=out[spb-1];
+    }
+    reps++;
+    dec=now()-t0;
+  } while (dec < 1.0);
+
+  double samples=(double)num_blocks*spb;
+  printf("clip: %d Hz mono, %.1f s, block_align %d (%d samples/block)\n",rate,samples/rate,block_align,spb);
+  printf("encode: %.1f Msamples/s\n",samples/enc/1e6);
+  printf("decode: %.1f Msamples/s (%.0fx real time), checksum %u\n",samples*reps/dec/1e6,samples*reps/dec/rate,sink);
+  printf("SNR: %.1f dB\n",10*log10(sig/err));
+  printf("SD bandwidth: PCM16 %d B/s, ADPCM %.0f B/s (%.2fx less)\n",
+         rate*2,(double)rate*block_align/spb,2.0*spb/block_align);
+  return 0;
+}
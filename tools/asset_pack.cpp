@@ -0,0 +1,291 @@
+//-----------------------------------------------------------------------------
+// asset_pack -- build an asset pack for AssetPack (AssetPack/AssetPack.h)
+// from loose files, converting them to the formats the device uses:
+//   .wav  PCM is mixed down to mono and linearly resampled to the DAC rate,
+//         keeping its 8 or 16 bits, so wave_player neither mixes nor
+//         resamples; IMA-ADPCM and other formats are stored as they are
+//   .ppm  binary (P6) images become big endian RGB565 sprites, the pixel
+//         format of the uLCD's BLIT command
+//   other files are stored as they are.
+// Assets are named after the file, without its directory, and each starts
+// on a 512 byte boundary.  The index is sorted for AssetPack::find().
+//
+// Build on the host:
+//   g++ -O2 -I AssetPack -o asset_pack tools/asset_pack.cpp
+//
+// Usage:
+//   asset_pack [-r rate] [-n] out.pak file...
+//     -r  DAC rate to resample waves to (default 16000, WAVE_OUTPUT_RATE)
+//     -n  store every file as it is
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <vector>
+#include <algorithm>
+#include "AssetPackFormat.h"
+
+struct asset {
+  ASSET_ENTRY entry;
+  std::vector<unsigned char> data;
+};
+
+static unsigned get_le(const unsigned char *p, int n)
+{
+  unsigned v=0;
+  for (int i=n-1;i>=0;i--)
+    v=(v<<8) | p[i];
+  return v;
+}
+
+static void put_le(std::vector<unsigned char> &out, unsigned v, int n)
+{
+  for (int i=0;i<n;i++) {
+    out.push_back(v & 0xff);
+    v>>=8;
+  }
+}
+
+static int load(const char *path, std::vector<unsigned char> &data)
+{
+  FILE *fp=fopen(path,"rb");
+  if (!fp)
+    return 1;
+  fseek(fp,0,SEEK_END);
+  data.resize(ftell(fp));
+  fseek(fp,0,SEEK_SET);
+  size_t got=data.empty() ? 0 : fread(&data[0],1,data.size(),fp);
+  fclose(fp);
+  return got != data.size();
+}
+
+static int ends_with(const char *s, const char *ext)
+{
+  size_t n=strlen(s),e=strlen(ext);
+  return n >= e && !strcasecmp(s+n-e,ext);
+}
+
+// mono PCM at rate, same sample width; 0 if the file isn't PCM
+static int convert_wave(asset &a, unsigned rate)
+{
+  const std::vector<unsigned char> &in=a.data;
+  unsigned format=0,channels=0,in_rate=0,bits=0;
+  const unsigned char *pcm=0;
+  unsigned pcm_size=0;
+
+  if (in.size() < 12 || memcmp(&in[0],"RIFF",4) || memcmp(&in[8],"WAVE",4))
+    return 0;
+  for (size_t p=12;p+8 <= in.size();) {
+    unsigned size=get_le(&in[p+4],4);
+    if (p+8+size > in.size())
+      size=in.size()-p-8;
+    if (!memcmp(&in[p],"fmt ",4) && size >= 16) {
+      format=get_le(&in[p+8],2);
+      channels=get_le(&in[p+10],2);
+      in_rate=get_le(&in[p+12],4);
+      bits=get_le(&in[p+22],2);
+    }
+    else if (!memcmp(&in[p],"data",4)) {
+      pcm=&in[p+8];
+      pcm_size=size;
+      break;
+    }
+    p+=8+size+(size&1);
+  }
+  a.entry.info=in_rate;
+  if (format != 1 || !pcm || channels < 1 || (bits != 8 && bits != 16))
+    return 0;
+
+// mix down to mono floats, 8 bit data is unsigned
+  unsigned bytes=bits/8,frames=pcm_size/(bytes*channels);
+  std::vector<float> mono(frames);
+  for (unsigned f=0;f<frames;f++) {
+    float sum=0;
+    for (unsigned c=0;c<channels;c++) {
+      const unsigned char *s=pcm+(f*channels+c)*bytes;
+      sum+=bits == 8 ? (s[0]-128)*256.0f : (float)(short)get_le(s,2);
+    }
+    mono[f]=sum/channels;
+  }
+
+// linear resampling, as the player would do it
+  unsigned out_frames=in_rate == rate ? frames : (unsigned)((unsigned long long)frames*rate/in_rate);
+  std::vector<unsigned char> out;
+  unsigned data_size=out_frames*bytes;
+  out.insert(out.end(),(const unsigned char *)"RIFF",(const unsigned char *)"RIFF"+4);
+  put_le(out,4+(8+16)+(8+data_size+(data_size&1)),4);
+  out.insert(out.end(),(const unsigned char *)"WAVEfmt ",(const unsigned char *)"WAVEfmt "+8);
+  put_le(out,16,4);
+  put_le(out,1,2);
+  put_le(out,1,2);
+  put_le(out,rate,4);
+  put_le(out,rate*bytes,4);
+  put_le(out,bytes,2);
+  put_le(out,bits,2);
+  out.insert(out.end(),(const unsigned char *)"data",(const unsigned char *)"data"+4);
+  put_le(out,data_size,4);
+  for (unsigned f=0;f<out_frames;f++) {
+    double pos=(double)f*in_rate/rate;
+    unsigned i=(unsigned)pos;
+    float frac=(float)(pos-i);
+    float v=i+1 < frames ? mono[i]+(mono[i+1]-mono[i])*frac : mono[frames-1];
+    int s=(int)(v < 0 ? v-0.5f : v+0.5f);
+    if (s > 32767) s=32767;
+    if (s < -32768) s=-32768;
+    if (bits == 8)
+      out.push_back((unsigned char)((s >> 8)+128));
+    else
+      put_le(out,(unsigned)s & 0xffff,2);
+  }
+  if (data_size & 1)
+    out.push_back(0);
+  a.data.swap(out);
+  a.entry.info=rate;
+  return 1;
+}
+
+static int next_ppm_token(const std::vector<unsigned char> &in, size_t &p)
+{
+  while (p < in.size()) {
+    if (in[p] == '#')
+      while (p < in.size() && in[p] != '\n')
+        p++;
+    else if (isspace(in[p]))
+      p++;
+    else
+      break;
+  }
+  int v=0;
+  while (p < in.size() && isdigit(in[p]))
+    v=v*10+(in[p++]-'0');
+  return v;
+}
+
+static int convert_ppm(asset &a)
+{
+  const std::vector<unsigned char> &in=a.data;
+  size_t p=2;
+
+  if (in.size() < 2 || in[0] != 'P' || in[1] != '6')
+    return 0;
+  int w=next_ppm_token(in,p),h=next_ppm_token(in,p),max=next_ppm_token(in,p);
+  p++;
+  if (w <= 0 || h <= 0 || w > 0xffff || h > 0xffff || max != 255 || p+(size_t)w*h*3 > in.size())
+    return 0;
+  std::vector<unsigned char> out;
+  for (int i=0;i<w*h;i++,p+=3) {
+    unsigned rgb=((in[p] >> 3) << 11) | ((in[p+1] >> 2) << 5) | (in[p+2] >> 3);
+    out.push_back(rgb >> 8);
+    out.push_back(rgb & 0xff);
+  }
+  a.data.swap(out);
+  a.entry.type=ASSET_SPRITE;
+  a.entry.info=w | h << 16;
+  return 1;
+}
+
+static bool by_name(const asset &a, const asset &b)
+{
+  return strcmp(a.entry.name,b.entry.name) < 0;
+}
+
+static void usage()
+{
+  fprintf(stderr,"usage: asset_pack [-r rate] [-n] out.pak file...\n");
+  exit(1);
+}
+
+int main(int argc, char **argv)
+{
+  unsigned rate=16000;
+  int raw=0,argi=1;
+
+  while (argi < argc && argv[argi][0]=='-') {
+    if (!strcmp(argv[argi],"-r") && argi+1 < argc)
+      rate=atoi(argv[++argi]);
+    else if (!strcmp(argv[argi],"-n"))
+      raw=1;
+    else
+      usage();
+    argi++;
+  }
+  if (argc-argi < 2 || !rate)
+    usage();
+
+  std::vector<asset> assets(argc-argi-1);
+  for (size_t k=0;k<assets.size();k++) {
+    const char *path=argv[argi+1+k];
+    const char *base=strrchr(path,'/') ? strrchr(path,'/')+1 : path;
+    asset &a=assets[k];
+    memset(&a.entry,0,sizeof(a.entry));
+    if (strlen(base) >= ASSET_NAME_LEN) {
+      fprintf(stderr,"%s: name longer than %d characters\n",base,ASSET_NAME_LEN-1);
+      return 1;
+    }
+    strcpy(a.entry.name,base);
+    if (load(path,a.data)) {
+      fprintf(stderr,"cannot read %s\n",path);
+      return 1;
+    }
+    if (!raw && ends_with(base,".wav")) {
+      a.entry.type=ASSET_WAVE;
+      if (!convert_wave(a,rate))
+        fprintf(stderr,"%s: not 8 or 16 bit PCM, stored as it is\n",base);
+    }
+    else if (!raw && ends_with(base,".ppm") && !convert_ppm(a)) {
+      fprintf(stderr,"%s: not a binary 8 bit PPM\n",base);
+      return 1;
+    }
+  }
+  std::sort(assets.begin(),assets.end(),by_name);
+  for (size_t k=1;k<assets.size();k++)
+    if (!strcmp(assets[k-1].entry.name,assets[k].entry.name)) {
+      fprintf(stderr,"%s is given twice\n",assets[k].entry.name);
+      return 1;
+    }
+
+// header and index, then the assets on sector boundaries
+  ASSET_PACK_HEADER header;
+  uint32_t offset=sizeof(header)+assets.size()*sizeof(ASSET_ENTRY);
+  offset=(offset+511) & ~511;
+  header.magic=ASSET_PACK_MAGIC;
+  header.version=ASSET_PACK_VERSION;
+  header.count=assets.size();
+  header.data=offset;
+  for (size_t k=0;k<assets.size();k++) {
+    assets[k].entry.offset=offset;
+    assets[k].entry.size=assets[k].data.size();
+    offset=(offset+assets[k].data.size()+511) & ~511;
+  }
+
+  FILE *out=fopen(argv[argi],"wb");
+  if (!out) {
+    fprintf(stderr,"cannot create %s\n",argv[argi]);
+    return 1;
+  }
+  fwrite(&header,sizeof(header),1,out);
+  for (size_t k=0;k<assets.size();k++)
+    fwrite(&assets[k].entry,sizeof(ASSET_ENTRY),1,out);
+  for (size_t k=0;k<assets.size();k++) {
+    const ASSET_ENTRY &e=assets[k].entry;
+    static const unsigned char zero[512]={0};
+    fwrite(zero,1,e.offset-ftell(out),out);
+    if (!assets[k].data.empty())
+      fwrite(&assets[k].data[0],1,e.size,out);
+    printf("%-31s %8u bytes at %8u  %s",e.name,e.size,e.offset,
+           e.type == ASSET_WAVE ? "wave" : e.type == ASSET_SPRITE ? "sprite" : "raw");
+    if (e.type == ASSET_WAVE)
+      printf(" %u Hz",e.info);
+    else if (e.type == ASSET_SPRITE)
+      printf(" %ux%u",e.info & 0xffff,e.info >> 16);
+    printf("\n");
+  }
+  if (fclose(out)) {
+    fprintf(stderr,"writing %s failed\n",argv[argi]);
+    return 1;
+  }
+  printf("%u assets, %u bytes\n",header.count,offset);
+  return 0;
+}
@@ -0,0 +1,378 @@
+//-----------------------------------------------------------------------------
+// batch_sim -- play many games headless on the host, on every core, to see
+// how hard each level is.  The game module runs unchanged against the
+// drawing-free uLCD in tools/host; each game is seeded with its number, so
+// a result can be reproduced, and played by a random player: it tilts one
+// way or the other for a while and fires now and then, with the input task
+// running twice a frame as on the board.  With -a the autopilot plays
+// instead; with -l 4 and a large -f that makes a soak test of the game
+// code.
+//
+// Each worker is a thread with its own GAME_WORLD.  Games are dealt out
+// to the workers in equal ranges, which doesn't balance: a game lasts from
+// a few hundred frames to thousands.  A worker that runs out steals half
+// of the biggest range left.  A worker's next and end game are packed in
+// one 64 bit word, so that taking and stealing are each a single compare
+// and swap.
+//
+// Reports games/s and frames/s, and per game the frames played, the level
+// reached, the score and how the game ended.  The slowest frame, the most
+// missiles in flight at once, and missiles and shots dropped for want of a
+// free slot are reported as well.  Levels can be changed with
+// -L to try out values for game_levels[] (getLevelInfo()).
+//
+// With -r each game is also rolled back once: the world is saved a few
+// frames in, played on, restored and played on again with the same input,
+// and must come out the same.  The snapshot's size and the time to save
+// and restore one are reported.
+//
+// Build on the host:
+//   g++ -O2 -pthread -I tools/host -I . -I SDFileSystem
+//     -I SDFileSystem/FATFileSystem -I SDFileSystem/FATFileSystem/ChaN
+//     -o batch_sim tools/batch_sim.cpp
+//     game.cpp missile.cpp player.cpp city_landscape.cpp rng.cpp
+//     autopilot.cpp tools/host/mbed_host.cpp
+//
+// Usage:
+//   batch_sim [-j workers] [-n games] [-l level] [-f max_frames] [-a] [-r]
+//             [-L level,speed,interval,tolerance]...
+//     -j  worker threads (default: the number of cores)
+//     -n  games to play (default 10000)
+//     -l  level to start on (default 1)
+//     -f  frames after which a game is stopped (default 20000)
+//     -a  the autopilot plays, not the random player
+//     -r  check that every game rolls back and plays on the same
+//     -L  set a level's missile speed, interval and hit tolerance
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <time.h>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include "globals.h"
+#include "game_public.h"
+#include "input_public.h"
+#include "autopilot_public.h"
+
+#define MAX_WORKERS 256
+#define INPUTS_PER_FRAME 2     // input task at 20 ms, simulation at 40 ms
+#define ROLLBACK_AT 50         // frame at which -r saves the world
+#define ROLLBACK_FRAMES 200    // and frames it plays on before restoring it
+#define TIMING_ROUNDS 1000000
+
+uLCD_4DGL uLCD(p9,p10,p11);
+
+typedef struct {
+  unsigned frames;
+  int level,score,cities,lives;
+  int diverged;                    // -r: the rolled back game came out different
+  unsigned slowest_ns;             // longest frame, input included
+  unsigned most_missiles;          // most missiles in flight at once
+  unsigned dropped,shots_dropped;  // launches and shots with every slot taken
+} RESULT;
+
+// the random player: its own random numbers and the way it tilts
+typedef struct {
+  RNG rng;
+  int tilt;
+} BOT;
+
+typedef struct {
+  std::atomic<uint64_t> range;     // next game in the low half, end in the high
+  unsigned played,steals;
+  unsigned long long frames;
+  char pad[64];                    // keep workers off each other's cache lines
+} WORKER;
+
+static WORKER pool[MAX_WORKERS];
+static std::vector<RESULT> results;
+static int workers;
+static int rollback;
+static int autopilot;
+
+static uint64_t pack(unsigned next, unsigned end) { return (uint64_t)end << 32 | next; }
+static unsigned next_of(uint64_t r) { return (unsigned)r; }
+static unsigned end_of(uint64_t r) { return (unsigned)(r >> 32); }
+
+// the next game from w's own range, -1 if it is empty
+static int take(int w)
+{
+  uint64_t r=pool[w].range.load();
+  while (next_of(r) < end_of(r))
+    if (pool[w].range.compare_exchange_weak(r,pack(next_of(r)+1,end_of(r))))
+      return next_of(r);
+  return -1;
+}
+
+// move the back half of the biggest range left to w's; 0 if all are empty
+static int steal(int w)
+{
+  for (;;) {
+    int victim=-1;
+    unsigned most=0;
+    for (int v=0;v<workers;v++) {
+      uint64_t r=pool[v].range.load();
+      if (v != w && end_of(r)-next_of(r) > most && next_of(r) < end_of(r)) {
+        most=end_of(r)-next_of(r);
+        victim=v;
+      }
+    }
+    if (victim < 0)
+      return 0;
+    uint64_t r=pool[victim].range.load();
+    unsigned next=next_of(r),end=end_of(r);
+    if (next >= end)
+      continue;
+    unsigned mid=next+(end-next)/2;
+    if (pool[victim].range.compare_exchange_strong(r,pack(next,mid))) {
+      pool[w].range.store(pack(mid,end));
+      pool[w].steals++;
+      return 1;
+    }
+  }
+}
+
+static void play_frame(GAME_WORLD *world, BOT *bot)
+{
+  GAME_INPUT input;
+
+  memset(&input,0,sizeof(input));
+  for (int i=0;i<INPUTS_PER_FRAME;i++) {
+    if (autopilot) {
+      autopilot_input(world,&input);
+      game_input(world,&input);
+      continue;
+    }
+    // hold a direction for a while, fire one input in eight
+    if (rng_range(&bot->rng,16) == 0)
+      bot->tilt=(rng_range(&bot->rng,3)-1)*1000;
+    input.frame=world->frame;
+    input.tilt=bot->tilt;
+    input.fires=rng_range(&bot->rng,8) == 0;
+    game_input(world,&input);
+  }
+  game_step(world);
+}
+
+// play on from here, then go back and play the same frames again; 1 if
+// the two don't end the same
+static int rollback_check(GAME_WORLD *world, BOT *bot)
+{
+  GAME_SNAPSHOT snapshot;
+  GAME_WORLD ahead;
+  BOT saved=*bot,bot_ahead;
+
+  game_save(world,&snapshot);
+  for (int i=0;i<ROLLBACK_FRAMES && !world->isGameOver;i++)
+    play_frame(world,bot);
+  ahead=*world;
+  bot_ahead=*bot;
+  if (game_restore(world,&snapshot))
+    return 1;
+  *bot=saved;
+  for (int i=0;i<ROLLBACK_FRAMES && !world->isGameOver;i++)
+    play_frame(world,bot);
+  return memcmp(world,&ahead,sizeof(ahead)) != 0 || memcmp(bot,&bot_ahead,sizeof(BOT)) != 0;
+}
+
+static RESULT play_game(GAME_WORLD *world, unsigned seed, int start_level, unsigned max_frames)
+{
+  BOT bot;
+  RESULT res;
+
+  rng_seed(&bot.rng,seed*2654435761u+1);
+  bot.tilt=0;
+  game_start(world,start_level,seed);
+  res.diverged=0;
+  res.slowest_ns=0;
+  res.most_missiles=0;
+  while (!world->isGameOver && world->frame < max_frames) {
+    if (rollback && world->frame == ROLLBACK_AT)
+      res.diverged=rollback_check(world,&bot);
+    struct timespec t0,t1;
+    clock_gettime(CLOCK_MONOTONIC,&t0);
+    play_frame(world,&bot);
+    clock_gettime(CLOCK_MONOTONIC,&t1);
+    unsigned ns=(t1.tv_sec-t0.tv_sec)*1000000000u+t1.tv_nsec-t0.tv_nsec;
+    unsigned missiles=0;
+    for (int i=0;i<MAX_MISSILES;i++)
+      missiles+=world->missiles.missile[i].status == MISSILE_ACTIVE;
+    res.slowest_ns=std::max(res.slowest_ns,ns);
+    res.most_missiles=std::max(res.most_missiles,missiles);
+  }
+  res.dropped=world->missiles.dropped;
+  res.shots_dropped=world->player.dropped;
+  res.frames=world->frame;
+  res.level=world->level;
+  res.score=world->isGameOver ? world->score : world->level*10+world->numMissilesDestroyed;
+  res.cities=world->numCities;
+  res.lives=world->numLives;
+  return res;
+}
+
+static void worker(int w, int start_level, unsigned max_frames)
+{
+  GAME_WORLD *world=(GAME_WORLD *)calloc(1,sizeof(GAME_WORLD));
+  int game;
+
+  for (;;) {
+    while ((game=take(w)) >= 0) {
+      results[game]=play_game(world,game,start_level,max_frames);
+      pool[w].played++;
+      pool[w].frames+=results[game].frames;
+    }
+    if (!steal(w))
+      break;
+  }
+  free(world);
+}
+
+static double now()
+{
+  struct timeval tv;
+  gettimeofday(&tv,0);
+  return tv.tv_sec+tv.tv_usec/1e6;
+}
+
+static void usage()
+{
+  fprintf(stderr,"usage: batch_sim [-j workers] [-n games] [-l level] [-f max_frames] [-a] [-r] [-L level,speed,interval,tolerance]...\n");
+  exit(1);
+}
+
+int main(int argc, char **argv)
+{
+  unsigned games=10000,max_frames=20000;
+  int start_level=1;
+
+  workers=sysconf(_SC_NPROCESSORS_ONLN);
+  for (int i=1;i<argc;i++) {
+    if (!strcmp(argv[i],"-j") && i+1 < argc)
+      workers=atoi(argv[++i]);
+    else if (!strcmp(argv[i],"-n") && i+1 < argc)
+      games=atoi(argv[++i]);
+    else if (!strcmp(argv[i],"-l") && i+1 < argc)
+      start_level=atoi(argv[++i]);
+    else if (!strcmp(argv[i],"-f") && i+1 < argc)
+      max_frames=atoi(argv[++i]);
+    else if (!strcmp(argv[i],"-a"))
+      autopilot=1;
+    else if (!strcmp(argv[i],"-r"))
+      rollback=1;
+    else if (!strcmp(argv[i],"-L") && i+1 < argc) {
+      int l,speed,interval,tolerance;
+      if (sscanf(argv[++i],"%d,%d,%d,%d",&l,&speed,&interval,&tolerance) != 4 || l < 1 || l > GAME_LEVELS ||
+          speed < 1 || speed > 8 || interval < 1 || interval > 100)
+        usage();
+      game_levels[l-1].missile_speed=speed;
+      game_levels[l-1].missile_interval=interval;
+      game_levels[l-1].missile_tolerance=tolerance;
+    }
+    else
+      usage();
+  }
+  if (workers < 1 || workers > MAX_WORKERS || games < 1 || start_level < 1 || start_level > GAME_LEVELS)
+    usage();
+
+  results.resize(games);
+  for (int w=0;w<workers;w++)
+    pool[w].range=pack((unsigned long long)games*w/workers,(unsigned long long)games*(w+1)/workers);
+
+  printf("%u games from level %d on %d workers, at most %u frames each, %s playing\n",games,start_level,workers,
+         max_frames,autopilot ? "the autopilot" : "a random player");
+  for (int l=0;l<GAME_LEVELS;l++)
+    printf("  level %d: speed %d, interval %d, tolerance %d\n",l+1,game_levels[l].missile_speed,
+           game_levels[l].missile_interval,game_levels[l].missile_tolerance);
+
+  double t0=now();
+  std::vector<std::thread> threads;
+  for (int w=0;w<workers;w++)
+    threads.push_back(std::thread(worker,w,start_level,max_frames));
+  for (int w=0;w<workers;w++)
+    threads[w].join();
+  double seconds=now()-t0;
+
+  unsigned long long frames=0;
+  unsigned played=0,steals=0,least=games,most=0;
+  for (int w=0;w<workers;w++) {
+    frames+=pool[w].frames;
+    played+=pool[w].played;
+    steals+=pool[w].steals;
+    least=std::min(least,pool[w].played);
+    most=std::max(most,pool[w].played);
+  }
+  if (played != games) {
+    printf("%u of %u games played\n",played,games);
+    return 1;
+  }
+  printf("%.2f s: %.0f games/s, %.0f frames/s; %u steals, %u to %u games a worker\n",
+         seconds,games/seconds,frames/seconds,steals,least,most);
+
+  std::vector<unsigned> length(games);
+  unsigned reached[GAME_LEVELS+1]={0},by_cities=0,by_player=0,stopped=0;
+  unsigned slowest_ns=0,most_missiles=0,dropped=0,shots_dropped=0;
+  double score=0;
+  for (unsigned g=0;g<games;g++) {
+    const RESULT &r=results[g];
+    length[g]=r.frames;
+    reached[r.level >= 1 && r.level <= GAME_LEVELS ? r.level : 0]++;
+    score+=r.score;
+    slowest_ns=std::max(slowest_ns,r.slowest_ns);
+    most_missiles=std::max(most_missiles,r.most_missiles);
+    dropped+=r.dropped;
+    shots_dropped+=r.shots_dropped;
+    if (r.frames >= max_frames)
+      stopped++;
+    else if (r.cities <= 0)
+      by_cities++;
+    else
+      by_player++;
+  }
+  std::sort(length.begin(),length.end());
+  printf("frames: mean %.0f, 10%% %u, median %u, 90%% %u\n",(double)frames/games,
+         length[games/10],length[games/2],length[games*9/10]);
+  printf("score: mean %.1f\n",score/games);
+  printf("ended: %u cities lost, %u player hit, %u stopped\n",by_cities,by_player,stopped);
+  for (int l=1;l <= GAME_LEVELS;l++)
+    printf("  reached level %d: %5.1f%%\n",l,reached[l]*100.0/games);
+  printf("slowest frame %.1f us; at most %u of %d missiles in flight; dropped %u missiles, %u shots\n",
+         slowest_ns/1000.0,most_missiles,MAX_MISSILES,dropped,shots_dropped);
+  if (!rollback)
+    return 0;
+
+  // a snapshot of a game in play, saved and restored over and over
+  GAME_WORLD *world=(GAME_WORLD *)calloc(1,sizeof(GAME_WORLD));
+  GAME_SNAPSHOT *snapshot=(GAME_SNAPSHOT *)malloc(sizeof(GAME_SNAPSHOT));
+  BOT bot={{1},0};
+  game_start(world,start_level,1);
+  for (int i=0;i<ROLLBACK_AT;i++)
+    play_frame(world,&bot);
+  t0=now();
+  for (int i=0;i<TIMING_ROUNDS;i++) {
+    game_save(world,snapshot);
+    __asm__ volatile("" ::: "memory");
+  }
+  double save=now()-t0;
+  t0=now();
+  for (int i=0;i<TIMING_ROUNDS;i++) {
+    game_restore(world,snapshot);
+    __asm__ volatile("" ::: "memory");
+  }
+  double restore=now()-t0;
+  free(snapshot);
+  free(world);
+
+  unsigned diverged=0;
+  for (unsigned g=0;g<games;g++)
+    diverged+=results[g].diverged;
+  printf("snapshot: %u bytes (budget %u), save %.0f ns, restore %.0f ns\n",(unsigned)sizeof(GAME_SNAPSHOT),
+         GAME_SNAPSHOT_BUDGET,save*1e9/TIMING_ROUNDS,restore*1e9/TIMING_ROUNDS);
+  printf("rollback: %u of %u games diverged\n",diverged,games);
+  return diverged != 0;
+}
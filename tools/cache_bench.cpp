@@ -0,0 +1,250 @@
+//-----------------------------------------------------------------------------
+// cache_bench -- host benchmark for FATSectorCache under FatFs.
+// Runs the game's SD access patterns against the SD card model in
+// tools/host, with no cache and with a FATSectorCache attached:
+//   open    open a wave file by path, read its header, close it (playSound)
+//   stream  read a file in 512 byte chunks (background music)
+//   log     append 64 byte records with an f_sync() every 16 (high scores,
+//           telemetry)
+// and reports card sectors, commands and SPI bus time for each.  A fuzz
+// pass then checks the cache against a mirror of the disk with random
+// reads, writes and syncs, and every file read back is checked.
+//
+// Build on the host:
+//   g++ -O2 -I tools/host -I SDFileSystem -I SDFileSystem/FATFileSystem
+//     -I SDFileSystem/FATFileSystem/ChaN -o cache_bench tools/cache_bench.cpp
+//     tools/host/mbed_host.cpp tools/host/sd_card_sim.cpp
+//     SDFileSystem/SDFileSystem.cpp SDFileSystem/FATFileSystem/*.cpp
+//     SDFileSystem/FATFileSystem/ChaN/*.cpp
+//
+// Usage:
+//   cache_bench [sectors] [read_ahead]
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "SDFileSystem.h"
+#include "FATSectorCache.h"
+#include "sd_card_sim.h"
+#include "ff.h"
+
+#define CARD_BLOCKS 65536        // 32MB
+#define WAV_FILES 12
+#define WAV_BYTES (20*1024)
+#define MUSIC_BYTES (256*1024)
+#define LOG_RECORDS 512
+
+static sd_card_sim card(CARD_BLOCKS);
+static SDFileSystem sd(p5,p6,p7,p8,"sd");
+static int bad;
+
+typedef struct {
+  unsigned read,written,commands;
+  double seconds;
+} COST;
+
+static COST cost_now()
+{
+  COST c={card.stats.blocks_read,card.stats.blocks_written,card.stats.commands,spi_host_stats.seconds};
+  return c;
+}
+
+static COST cost_since(COST c0)
+{
+  COST c=cost_now();
+  c.read-=c0.read;
+  c.written-=c0.written;
+  c.commands-=c0.commands;
+  c.seconds-=c0.seconds;
+  return c;
+}
+
+static inline uint8_t file_byte(unsigned file, unsigned offset)
+{
+  return (uint8_t)(offset*7+file*31+(offset >> 9));
+}
+
+static int write_file(const char *name, unsigned file, unsigned size)
+{
+  std::vector<uint8_t> buf(size);
+  FIL f;
+  UINT n;
+
+  for (unsigned i=0;i<size;i++)
+    buf[i]=file_byte(file,i);
+  if (f_open(&f,name,FA_WRITE | FA_CREATE_ALWAYS) || f_write(&f,&buf[0],size,&n) || n != size)
+    return 1;
+  return f_close(&f) != FR_OK;
+}
+
+static void check(const uint8_t *buf, unsigned file, unsigned offset, unsigned len)
+{
+  for (unsigned i=0;i<len;i++)
+    if (buf[i] != file_byte(file,offset+i)) {
+      bad++;
+      return;
+    }
+}
+
+static COST open_test()
+{
+  COST c0=cost_now();
+  char name[32];
+  uint8_t header[44];
+  FIL f;
+  UINT n;
+
+  for (int round=0;round<4;round++)
+    for (unsigned k=0;k<WAV_FILES;k++) {
+      sprintf(name,"0:/wavfiles/fx%02u.wav",k);
+      if (f_open(&f,name,FA_READ) || f_read(&f,header,sizeof(header),&n) || n != sizeof(header)) {
+        bad++;
+        continue;
+      }
+      check(header,k,0,sizeof(header));
+      f_close(&f);
+    }
+  return cost_since(c0);
+}
+
+static COST stream_test()
+{
+  COST c0=cost_now();
+  uint8_t buf[512];
+  FIL f;
+  UINT n;
+
+  if (f_open(&f,"0:/wavfiles/music.wav",FA_READ)) {
+    bad++;
+    return cost_since(c0);
+  }
+  for (unsigned off=0;off < MUSIC_BYTES;off+=n) {
+    if (f_read(&f,buf,sizeof(buf),&n) || !n) {
+      bad++;
+      break;
+    }
+    check(buf,100,off,n);
+  }
+  f_close(&f);
+  return cost_since(c0);
+}
+
+static COST log_test()
+{
+  COST c0=cost_now();
+  uint8_t rec[64];
+  FIL f;
+  UINT n;
+
+  if (f_open(&f,"0:/log.bin",FA_WRITE | FA_OPEN_ALWAYS) || f_lseek(&f,f.fsize)) {
+    bad++;
+    return cost_since(c0);
+  }
+  for (unsigned i=0;i<LOG_RECORDS;i++) {
+    for (unsigned j=0;j<sizeof(rec);j++)
+      rec[j]=(uint8_t)(i+j);
+    if (f_write(&f,rec,sizeof(rec),&n) || n != sizeof(rec))
+      bad++;
+    if (i % 16 == 15)
+      f_sync(&f);
+  }
+  f_close(&f);
+  return cost_since(c0);
+}
+
+static void row(const char *name, COST off, COST on)
+{
+  printf("  %-6s | %6u %6u %6u %8.1f | %6u %6u %6u %8.1f | %5.2fx\n",name,
+         off.read,off.written,off.commands,off.seconds*1e3,
+         on.read,on.written,on.commands,on.seconds*1e3,off.seconds/on.seconds);
+}
+
+// random sector reads and writes within a small range through the cache,
+// checked against a mirror; the card must match the mirror after sync()
+static void fuzz(int sectors, int read_ahead)
+{
+  const uint32_t base=CARD_BLOCKS-256,range=64;
+  std::vector<uint8_t> mirror(range*512),buf(16*512);
+  FATSectorCache *cache;
+  unsigned i,k;
+
+  sd.disk_read_blocks(&mirror[0],base,range);
+  cache=new FATSectorCache(&sd,sectors,read_ahead);
+  srand(7);
+  for (k=0;k<20000;k++) {
+    uint32_t s=rand() % range;
+    uint32_t count=1+(rand() % 4 ? 0 : rand() % 8);
+    if (s+count > range)
+      count=range-s;
+    switch (rand() % 8) {
+    case 0: case 1:
+      for (i=0;i<count*512;i++)
+        buf[i]=(uint8_t)rand();
+      if (cache->write(&buf[0],base+s,count))
+        bad++;
+      memcpy(&mirror[s*512],&buf[0],count*512);
+      break;
+    case 2:
+      if (cache->sync())
+        bad++;
+      break;
+    default:
+      if (cache->read(&buf[0],base+s,count) || memcmp(&buf[0],&mirror[s*512],count*512))
+        bad++;
+      break;
+    }
+    if (k == 10000)
+      cache->write_through(1);
+  }
+  delete cache;
+  if (memcmp(&card.image[base*512],&mirror[0],mirror.size()))
+    bad++;
+}
+
+int main(int argc, char **argv)
+{
+  int sectors=argc > 1 ? atoi(argv[1]) : 8;
+  int read_ahead=argc > 2 ? atoi(argv[2]) : 4;
+  COST off[3],on[3];
+  FAT_CACHE_STATS stats;
+  char name[32];
+
+  if (f_mkfs(0,0,4096) || f_mkdir("0:/wavfiles") || f_mkdir("0:/tests")) {
+    printf("formatting the card failed\n");
+    return 1;
+  }
+  for (unsigned k=0;k<WAV_FILES;k++) {
+    sprintf(name,"0:/wavfiles/fx%02u.wav",k);
+    if (write_file(name,k,WAV_BYTES))
+      bad++;
+  }
+  if (write_file("0:/wavfiles/music.wav",100,MUSIC_BYTES))
+    bad++;
+
+  off[0]=open_test();
+  off[1]=stream_test();
+  off[2]=log_test();
+
+  FATSectorCache *cache=new FATSectorCache(&sd,sectors,read_ahead);
+  on[0]=open_test();
+  on[1]=stream_test();
+  on[2]=log_test();
+  cache->get_stats(&stats);
+  delete cache;
+
+  printf("%d sector cache, %d sectors of read ahead\n",sectors,read_ahead);
+  printf("         | no cache: read  wrote  cmds  bus ms | cache:  read  wrote  cmds  bus ms |\n");
+  row("open",off[0],on[0]);
+  row("stream",off[1],on[1]);
+  row("log",off[2],on[2]);
+  printf("hits %u, misses %u, read ahead hits %u in %u fills, write backs %u\n",
+         stats.hits,stats.misses,stats.read_ahead_hits,stats.read_ahead_fills,stats.write_backs);
+
+  fuzz(sectors,read_ahead);
+  if (bad) {
+    printf("%d checks failed\n",bad);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,121 @@
+//-----------------------------------------------------------------------------
+// dac_dma_sim -- host test of wave_player's ping-pong DMA refill logic.
+// Runs dac_dma.cpp against tools/host/dac_dma_host.cpp, which drains the
+// halves in real time, while a producer fills them and stalls now and then
+// the way the player does while the SD card is busy.  Every drained sample
+// is checked against the sequence that was produced.
+//
+// Build on the host:
+//   g++ -O2 -pthread -I wave_player -I tools/host -o dac_dma_sim
+//     tools/dac_dma_sim.cpp tools/host/dac_dma_host.cpp wave_player/dac_dma.cpp
+//
+// Usage:
+//   dac_dma_sim [rate] [seconds] [stall_ms] [stall_every]
+//     stall_ms is how long the producer stops every stall_every half
+//     buffers.  Stalls shorter than one half (DAC_DMA_HALF/rate) should
+//     play out without underruns; longer ones replay the old half.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include <unistd.h>
+#include "dac_dma.h"
+#include "dac_dma_host.h"
+
+static unsigned next_expected;
+static unsigned drained,replayed,bad;
+
+static double now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec+ts.tv_nsec*1e-9;
+}
+
+// the producer writes a ramp, so each DACR value is predictable
+static inline unsigned short ramp(unsigned n)
+{
+  return (unsigned short)(n << 6);
+}
+
+// sort each drained half: a continuation of the ramp (possibly ending in
+// idle padding), an old half played again, or something out of sequence
+static void check_half(const uint32_t *half, int n)
+{
+  static uint32_t last[2][DAC_DMA_HALF];
+  static unsigned count;
+  uint32_t *prev=last[count++ & 1];
+  int i;
+
+  drained+=n;
+  if (half[0] == dac_dma::to_dacr(ramp(next_expected))) {
+    for (i=0;i<n && half[i] == dac_dma::to_dacr(ramp(next_expected));i++)
+      next_expected++;
+    for (;i<n;i++)
+      if (half[i] != dac_dma::to_dacr(32768))
+        bad++;
+  }
+  else if (!memcmp(half,prev,n*sizeof(*half)))
+    replayed++;
+  else {
+    for (i=0;i<n;i++)
+      if (half[i] != dac_dma::to_dacr(32768)) {
+        bad++;
+        break;
+      }
+  }
+  memcpy(prev,half,n*sizeof(*half));
+}
+
+int main(int argc, char **argv)
+{
+  unsigned rate=argc > 1 ? atoi(argv[1]) : 16000;
+  double seconds=argc > 2 ? atof(argv[2]) : 2.0;
+  unsigned stall_ms=argc > 3 ? atoi(argv[3]) : 10;
+  unsigned stall_every=argc > 4 ? atoi(argv[4]) : 8;
+  unsigned total=(unsigned)(rate*seconds);
+  double half_ms=1000.0*DAC_DMA_HALF/rate;
+  dac_dma dma;
+  double busy=0,t0,t;
+
+  printf("%u Hz, %d samples per half (%.1f ms), stall %u ms every %u halves\n",
+         rate,DAC_DMA_HALF,half_ms,stall_ms,stall_every);
+
+  dac_dma_host_sink=check_half;
+  t0=now();
+  uint32_t *cur=dma.begin(rate);
+  int used=0;
+  unsigned halves=0;
+  for (unsigned n=0;n<total;n++) {
+    cur[used++]=dac_dma::to_dacr(ramp(n));
+    if (used == DAC_DMA_HALF) {
+      if (stall_every && ++halves % stall_every == 0)
+        usleep(stall_ms*1000);
+      t=now();
+      cur=dma.swap();
+      busy+=now()-t;
+      used=0;
+    }
+  }
+  dma.finish(cur,used,32768);
+  t=now()-t0;
+
+  printf("interrupts  %u (%.0f/s, a Ticker would take %u/s)\n",
+         dma.get_interrupts(),dma.get_interrupts()/t,rate);
+  printf("underruns   %u\n",dma.get_underruns());
+  printf("samples     %u of %u played in order, %u drained\n",next_expected,total,drained);
+  printf("halves      %u replayed, %u out of sequence\n",replayed,bad);
+  printf("producer    %.1f%% of %.2f s waiting for the DMA\n",100*busy/t,t);
+  if (stall_ms < half_ms && dma.get_underruns())
+    printf("(underruns with stalls under one half come from host scheduling)\n");
+
+// an underrun replays a half and drops whatever was refilled too late, so
+// only a clean run has to reproduce the stream exactly
+  if (!dma.get_underruns() && (bad || replayed || next_expected != total)) {
+    printf("FAIL\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,2 @@
+// Host stand-in; the classes live in FileSystemLike.h
+#include "FileSystemLike.h"
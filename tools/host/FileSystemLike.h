@@ -0,0 +1,68 @@
+//-----------------------------------------------------------------------------
+// Host stand-ins for mbed's FileSystemLike, FileHandle and DirHandle, with
+// the same virtual interface, so FATFileSystem builds on the host.  Each
+// file system is listed by name for mbed_host_fopen() in mbed.h.
+//-----------------------------------------------------------------------------
+#ifndef MBED_FILESYSTEMLIKE_H
+#define MBED_FILESYSTEMLIKE_H
+
+#include <stdio.h>
+#include <limits.h>
+#include <sys/types.h>
+#include <fcntl.h>
+
+struct dirent {
+  char d_name[NAME_MAX+1];
+};
+
+namespace mbed {
+
+class FileHandle {
+public:
+  virtual ssize_t write(const void *buffer, size_t length)=0;
+  virtual int close()=0;
+  virtual ssize_t read(void *buffer, size_t length)=0;
+  virtual int isatty()=0;
+  virtual off_t lseek(off_t offset, int whence)=0;
+  virtual int fsync()=0;
+  virtual off_t flen() {
+    off_t pos=lseek(0,SEEK_CUR);
+    if (pos == -1) return -1;
+    off_t res=lseek(0,SEEK_END);
+    lseek(pos,SEEK_SET);
+    return res;
+  }
+  virtual ~FileHandle() {}
+};
+
+class DirHandle {
+public:
+  virtual int closedir()=0;
+  virtual struct dirent *readdir()=0;
+  virtual void rewinddir()=0;
+  virtual off_t telldir() { return -1; }
+  virtual void seekdir(off_t /*location*/) {}
+  virtual ~DirHandle() {}
+};
+
+class FileSystemLike {
+public:
+  FileSystemLike(const char *name);
+  virtual ~FileSystemLike();
+  /// the file system mounted as name[0..len), or NULL
+  static FileSystemLike *lookup(const char *name, size_t len);
+  virtual FileHandle *open(const char *filename, int flags)=0;
+  virtual int remove(const char * /*filename*/) { return -1; }
+  virtual int rename(const char * /*oldname*/, const char * /*newname*/) { return -1; }
+  virtual DirHandle *opendir(const char * /*name*/) { return NULL; }
+  virtual int mkdir(const char * /*name*/, mode_t /*mode*/) { return -1; }
+
+protected:
+  const char *_name;
+  FileSystemLike *_next;
+  static FileSystemLike *_head;
+};
+
+} // namespace mbed
+
+#endif
@@ -0,0 +1,99 @@
+//-----------------------------------------------------------------------------
+// FATFileSystem on a FAT image file.  See ImageFileSystem.h.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "mbed.h"
+#include "ImageFileSystem.h"
+
+ImageFileSystem::ImageFileSystem(const char *image, const char *name, uint64_t create_sectors)
+  : FATFileSystem(name), _image(0), _sectors(0)
+{
+  struct stat st;
+  int fd;
+
+  latency.read_access_us=300;
+  latency.write_access_us=800;
+  latency.sector_us=200;
+  latency.realtime=0;
+  memset(&_stats,0,sizeof(_stats));
+
+  fd=::open(image,O_RDWR | (create_sectors ? O_CREAT : 0),0644);
+  if (fd < 0 || (create_sectors && ftruncate(fd,create_sectors*512)) || fstat(fd,&st)) {
+    perror(image);
+    exit(1);
+  }
+  _sectors=st.st_size/512;
+  if (_sectors) {
+    void *map=mmap(0,_sectors*512,PROT_READ | PROT_WRITE,MAP_SHARED,fd,0);
+    if (map == MAP_FAILED) {
+      perror(image);
+      exit(1);
+    }
+    _image=(uint8_t *)map;
+  }
+  ::close(fd);
+}
+
+ImageFileSystem::~ImageFileSystem()
+{
+  if (_image) {
+    msync(_image,_sectors*512,MS_SYNC);
+    munmap(_image,_sectors*512);
+  }
+}
+
+void ImageFileSystem::charge(unsigned access_us, uint32_t count)
+{
+  unsigned us=access_us+count*latency.sector_us;
+  _stats.seconds+=us*1e-6;
+  if (latency.realtime)
+    usleep(us);
+}
+
+int ImageFileSystem::disk_initialize() { return _image ? 0 : 1; }
+int ImageFileSystem::disk_status() { return _image ? 0 : 1; }
+
+int ImageFileSystem::disk_read(uint8_t *buffer, uint64_t sector)
+{
+  return disk_read_blocks(buffer,sector,1);
+}
+
+int ImageFileSystem::disk_write(const uint8_t *buffer, uint64_t sector)
+{
+  return disk_write_blocks(buffer,sector,1);
+}
+
+int ImageFileSystem::disk_read_blocks(uint8_t *buffer, uint64_t sector, uint32_t count)
+{
+  if (sector+count > _sectors)
+    return 1;
+  memcpy(buffer,_image+sector*512,count*512);
+  _stats.reads++;
+  _stats.sectors_read+=count;
+  charge(latency.read_access_us,count);
+  return 0;
+}
+
+int ImageFileSystem::disk_write_blocks(const uint8_t *buffer, uint64_t sector, uint32_t count)
+{
+  if (sector+count > _sectors)
+    return 1;
+  memcpy(_image+sector*512,buffer,count*512);
+  _stats.writes++;
+  _stats.sectors_written+=count;
+  charge(latency.write_access_us,count);
+  return 0;
+}
+
+int ImageFileSystem::disk_sync()
+{
+  return msync(_image,_sectors*512,MS_ASYNC) != 0;
+}
+
+uint64_t ImageFileSystem::disk_sectors() { return _sectors; }
@@ -0,0 +1,68 @@
+//-----------------------------------------------------------------------------
+// FATFileSystem on a FAT image file, for running the game's file code on
+// the host in place of SDFileSystem and the SD card.  The image is mapped
+// with mmap(), so writes land in the file and survive the process.
+//
+// Each disk_ call is charged to a latency model: an access time per
+// command plus a transfer time per sector, with multiple sector requests
+// paying the access time once, as SDFileSystem's CMD18/CMD25 do.  The
+// defaults are close to tools/host/sd_card_sim at 25MHz.  The modelled
+// time is tallied in get_stats(); with realtime set it is also slept, so
+// code that races the card (wave_player streaming) sees its timing.
+//
+//   ImageFileSystem sd("sd.img","sd");          // existing image
+//   ImageFileSystem sd("sd.img","sd",65536);    // new 32MB image
+//   sd.format();
+//   FILE *f=fopen("/sd/wavfiles/music.wav","r");
+//-----------------------------------------------------------------------------
+#ifndef IMAGE_FILE_SYSTEM_H
+#define IMAGE_FILE_SYSTEM_H
+
+#include "FATFileSystem.h"
+
+typedef struct {
+  unsigned read_access_us;     ///< per read command
+  unsigned write_access_us;    ///< per write command, programming included
+  unsigned sector_us;          ///< per 512 byte sector moved
+  int realtime;                ///< sleep for the modelled time too
+} IMAGE_LATENCY;
+
+typedef struct {
+  unsigned reads,writes;                   ///< commands
+  unsigned sectors_read,sectors_written;
+  double seconds;                          ///< modelled disk time
+} IMAGE_STATS;
+
+class ImageFileSystem : public FATFileSystem {
+public:
+  /** Map an image file.
+   *
+   * @param image path of the image file
+   * @param name mount name, as for SDFileSystem
+   * @param create_sectors if not 0, create or resize the image to this many
+   *   sectors; it needs format() before use
+   */
+  ImageFileSystem(const char *image, const char *name, uint64_t create_sectors=0);
+  virtual ~ImageFileSystem();
+
+  virtual int disk_initialize();
+  virtual int disk_status();
+  virtual int disk_read(uint8_t *buffer, uint64_t sector);
+  virtual int disk_write(const uint8_t *buffer, uint64_t sector);
+  virtual int disk_read_blocks(uint8_t *buffer, uint64_t sector, uint32_t count);
+  virtual int disk_write_blocks(const uint8_t *buffer, uint64_t sector, uint32_t count);
+  virtual int disk_sync();
+  virtual uint64_t disk_sectors();
+
+  IMAGE_LATENCY latency;
+  void get_stats(IMAGE_STATS *stats) { *stats=_stats; }
+
+protected:
+  void charge(unsigned access_us, uint32_t count);
+
+  uint8_t *_image;
+  uint64_t _sectors;
+  IMAGE_STATS _stats;
+};
+
+#endif
@@ -0,0 +1,52 @@
+//-----------------------------------------------------------------------------
+// Host stand-in for dac_dma_lpc17xx.cpp.  See dac_dma_host.h.
+//-----------------------------------------------------------------------------
+
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <string.h>
+#include "dac_dma.h"
+#include "dac_dma_host.h"
+
+void (*dac_dma_host_sink)(const uint32_t *half, int n)=0;
+
+static std::thread drain;
+static std::atomic<bool> stop_drain;
+
+void dac_dma::hw_start(void)
+{
+  dac_dma *self=this;
+  uint32_t (*halves)[DAC_DMA_HALF]=buf;
+  std::chrono::nanoseconds period((long long)DAC_DMA_HALF*1000000000LL/rate);
+
+  stop_drain=false;
+  drain=std::thread([self,halves,period] {
+    uint32_t playing[DAC_DMA_HALF];
+    std::chrono::steady_clock::time_point next=std::chrono::steady_clock::now();
+    while (!stop_drain) {
+// like the DMA, latch the half when it starts, so a refill that arrives
+// while it plays is not heard
+      memcpy(playing,halves[self->get_interrupts() & 1],sizeof(playing));
+      next+=period;
+      std::this_thread::sleep_until(next);
+      if (stop_drain)
+        break;
+      if (dac_dma_host_sink)
+        dac_dma_host_sink(playing,DAC_DMA_HALF);
+      self->half_done();
+    }
+  });
+}
+
+void dac_dma::hw_stop(void)
+{
+  stop_drain=true;
+  if (std::this_thread::get_id() != drain.get_id() && drain.joinable())
+    drain.join();
+}
+
+void dac_dma::hw_wait(void)
+{
+  std::this_thread::yield();
+}
@@ -0,0 +1,17 @@
+//-----------------------------------------------------------------------------
+// Host stand-in for the LPC1768 DAC DMA.  Link dac_dma_host.cpp instead of
+// wave_player/dac_dma_lpc17xx.cpp; a thread drains one half buffer every
+// DAC_DMA_HALF/rate seconds and raises half_done(), like the GPDMA
+// terminal count interrupt would.
+//-----------------------------------------------------------------------------
+#ifndef DAC_DMA_HOST_H
+#define DAC_DMA_HOST_H
+
+#include <stdint.h>
+
+/** Called by the drain thread with each half buffer as it is "played".
+ *  The values are in DACR format (sample & 0xffc0).
+ */
+extern void (*dac_dma_host_sink)(const uint32_t *half, int n);
+
+#endif
@@ -0,0 +1,286 @@
+//-----------------------------------------------------------------------------
+// Host stand-in for the parts of the mbed library used by the code the host
+// tools build (SDFileSystem, FATFileSystem, wave_player helpers).  Put
+// tools/host first on the include path instead of mbed/.
+//
+// SPI and DigitalOut talk to a single simulated device, spi_host_device, so
+// a driver can be run against e.g. the SD card model in sd_card_sim.h.  The
+// bus keeps a tally of bytes moved and the time they take at the programmed
+// clock, which is what the benchmarks report.  I2C does the same with
+// i2c_host_device, e.g. the accelerometer model in mma8452_sim.h, and a
+// model drives its interrupt line with InterruptIn::host_drive().
+//
+// fopen() is routed through the FileSystemLike objects, like mbed's
+// retarget layer, so the game's file code runs unchanged against e.g.
+// ImageFileSystem.
+//
+// TARGET_LPC176X is defined so drivers take their LPC1768 paths.  The only
+// registers modelled are the SSP's DR and SR, behind SPI's spi_t, which is
+// enough for FIFO transfers.  There are no interrupts: __disable_irq() does
+// nothing and InterruptIn handlers run inside host_drive().
+//-----------------------------------------------------------------------------
+#ifndef MBED_H
+#define MBED_H
+
+#ifndef TARGET_LPC176X
+#define TARGET_LPC176X
+#endif
+
+// there is no DWT cycle counter to profile with (profile_public.h)
+#ifndef PROFILE_ENABLE
+#define PROFILE_ENABLE 0
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <fcntl.h>
+#include "FileSystemLike.h"
+
+typedef enum {
+  p5=5, p6, p7, p8, p9, p10, p11, p12, p13, p14, p15, p16, p17, p18, p19,
+  p20, p21, p22, p23, p24, p25, p26, p27, p28, p29, p30,
+  LED1, LED2, LED3, LED4, USBTX, USBRX,
+  NC=-1
+} PinName;
+
+typedef enum {
+  PullUp, PullDown, PullNone, OpenDrain
+} PinMode;
+
+void wait(float s);
+void wait_ms(int ms);
+void wait_us(int us);
+unsigned us_ticker_read(void);
+void error(const char *format, ...);
+
+/** A device on the host SPI bus. */
+class SPIHostDevice {
+public:
+  virtual ~SPIHostDevice() {}
+  /// clock one byte each way
+  virtual int exchange(int out)=0;
+  /// chip select pin level
+  virtual void select(int level)=0;
+  /// bus clock in Hz, set by SPI::frequency()
+  virtual void clock(int /*hz*/) {}
+};
+
+extern SPIHostDevice *spi_host_device;
+
+/** Bus tally kept by the host SPI class. */
+typedef struct {
+  unsigned long long bytes;   ///< bytes clocked
+  double seconds;             ///< time they take at the programmed clock
+  unsigned long long calls;   ///< SPI::write() calls made by the driver
+} SPI_HOST_STATS;
+
+extern SPI_HOST_STATS spi_host_stats;
+
+/** CPU time between the frames of back to back SPI::write() calls, in
+ * seconds: the mbed driver waits for each frame to come back before the
+ * next goes out.  The default is an estimate for the LPC1768 at 96MHz.
+ */
+extern double spi_host_write_gap;
+
+// SSP status register bits
+#define SSP_SR_TFE  (1 << 0)
+#define SSP_SR_TNF  (1 << 1)
+#define SSP_SR_RNE  (1 << 2)
+#define SSP_SR_BSY  (1 << 4)
+
+/** SSP data register: a write clocks a frame, a read pops the RX FIFO. */
+class ssp_host_dr {
+public:
+  ssp_host_dr &operator=(uint32_t value);
+  operator uint32_t();
+};
+
+/** SSP status register: the TX FIFO empties at once, so only RNE varies. */
+class ssp_host_sr {
+public:
+  operator uint32_t();
+};
+
+typedef struct {
+  ssp_host_dr DR;
+  ssp_host_sr SR;
+} LPC_SSP_TypeDef;
+
+struct spi_s {
+  LPC_SSP_TypeDef *spi;
+};
+typedef struct spi_s spi_t;
+
+class SPI {
+public:
+  SPI(PinName mosi, PinName miso, PinName sclk);
+  void format(int /*bits*/, int /*mode*/=0) {}
+  void frequency(int hz);
+  virtual int write(int value);
+  virtual ~SPI() {}
+
+protected:
+  spi_t _spi;
+};
+
+class DigitalOut {
+public:
+  DigitalOut(PinName pin) : _pin(pin), _value(0) {}
+  void write(int value);
+  int read() { return _value; }
+  DigitalOut &operator=(int value) { write(value); return *this; }
+  operator int() { return _value; }
+
+protected:
+  PinName _pin;
+  int _value;
+};
+
+/** A device on the host I2C bus, driven a condition or byte at a time. */
+class I2CHostDevice {
+public:
+  virtual ~I2CHostDevice() {}
+  /// start or repeated start
+  virtual void start()=0;
+  virtual void stop()=0;
+  /// a byte from the master, address or data; returns 1 to ack it
+  virtual int write(int data)=0;
+  /// a byte for the master, which acks it if ack is set
+  virtual int read(int ack)=0;
+};
+
+extern I2CHostDevice *i2c_host_device;
+
+/** Bus tally kept by the host I2C class. */
+typedef struct {
+  unsigned long long bytes;   ///< bytes clocked, addresses included
+  double seconds;             ///< time they take at the programmed clock
+  unsigned long long starts;  ///< start conditions, repeated ones included
+} I2C_HOST_STATS;
+
+extern I2C_HOST_STATS i2c_host_stats;
+
+/** The mbed I2C master API on i2c_host_device.  A byte costs nine clocks and
+ * a start or stop one.
+ */
+class I2C {
+public:
+  I2C(PinName /*sda*/, PinName /*scl*/) {}
+  void frequency(int hz);
+  int read(int address, char *data, int length, bool repeated=false);
+  int read(int ack);
+  int write(int address, const char *data, int length, bool repeated=false);
+  int write(int data);
+  void start();
+  void stop();
+};
+
+/** A handler for InterruptIn: a function, or a member function of an object. */
+class host_callback {
+public:
+  virtual ~host_callback() {}
+  virtual void call()=0;
+};
+
+class host_function_callback : public host_callback {
+public:
+  host_function_callback(void (*fn)(void)) : _fn(fn) {}
+  virtual void call() { _fn(); }
+private:
+  void (*_fn)(void);
+};
+
+template<typename T> class host_method_callback : public host_callback {
+public:
+  host_method_callback(T *object, void (T::*method)(void)) : _object(object), _method(method) {}
+  virtual void call() { (_object->*_method)(); }
+private:
+  T *_object;
+  void (T::*_method)(void);
+};
+
+/** InterruptIn on a pin level kept by the host.  Pins idle high.  Like the
+ *  LPC1768's GPIO interrupts, an edge while disabled is kept pending and its
+ *  handler runs on enable_irq().
+ */
+class InterruptIn {
+public:
+  InterruptIn(PinName pin);
+  ~InterruptIn();
+  int read();
+  operator int() { return read(); }
+  void mode(PinMode /*pull*/) {}
+  void rise(void (*fn)(void)) { set(&_rise,fn ? new host_function_callback(fn) : 0); }
+  void fall(void (*fn)(void)) { set(&_fall,fn ? new host_function_callback(fn) : 0); }
+  template<typename T> void rise(T *object, void (T::*method)(void)) { set(&_rise,new host_method_callback<T>(object,method)); }
+  template<typename T> void fall(T *object, void (T::*method)(void)) { set(&_fall,new host_method_callback<T>(object,method)); }
+  void enable_irq();
+  void disable_irq();
+
+  /** Set a pin's level, as a simulated device does, running the handlers
+   *  of an InterruptIn on it for the edge.
+   */
+  static void host_drive(PinName pin, int level);
+
+protected:
+  void set(host_callback **slot, host_callback *cb);
+  void edge(int level);
+
+  PinName _pin;
+  host_callback *_rise;
+  host_callback *_fall;
+  int _enabled;
+  int _pending_rise, _pending_fall;
+};
+
+/** Serial for debug output, which goes to stderr. */
+class Serial {
+public:
+  Serial(PinName /*tx*/, PinName /*rx*/) {}
+  void baud(int /*rate*/) {}
+  int printf(const char *format, ...);
+  int putc(int c) { return fputc(c,stderr); }
+};
+
+static inline void __disable_irq(void) {}
+static inline void __enable_irq(void) {}
+
+/** AnalogOut that keeps the last value written. */
+class AnalogOut {
+public:
+  AnalogOut(PinName /*pin*/) : _value(0) {}
+  void write_u16(unsigned short value) { _value=value; }
+  unsigned short read_u16() { return _value; }
+
+protected:
+  unsigned short _value;
+};
+
+/** Ticker that never fires.  wave_player takes its DMA path on the host
+ *  (tools/host/dac_dma_host.cpp), which needs no Ticker.
+ */
+class Ticker {
+public:
+  template<typename T> void attach_us(T * /*object*/, void (T::* /*method*/)(void), unsigned /*us*/) {}
+  template<typename T> void attach(T *object, void (T::*method)(void), float s) {}
+  void attach(void (* /*fn*/)(void), float /*s*/) {}
+  void detach() {}
+};
+
+// the ARM C library's heap walker, used by testbench.cpp; there is none on
+// the host, so the heap always looks empty
+typedef int (*__heapprt)(void *param, char const *format, ...);
+static inline int __heapvalid(__heapprt /*dprint*/, void * /*param*/, int /*verbose*/) { return 1; }
+
+/** fopen() for the code under test, as mbed's retarget does it: a path
+ *  "/<name>/..." opens a file on the FileSystemLike of that name (say an
+ *  ImageFileSystem) through glibc's fopencookie(); anything else goes to
+ *  the C library.
+ */
+FILE *mbed_host_fopen(const char *path, const char *mode);
+#define fopen mbed_host_fopen
+
+#endif
@@ -0,0 +1,26 @@
+//-----------------------------------------------------------------------------
+// Host stand-in for mbed_debug.h.  Messages go to stderr.
+//-----------------------------------------------------------------------------
+#ifndef MBED_DEBUG_H
+#define MBED_DEBUG_H
+
+#include <stdio.h>
+#include <stdarg.h>
+
+static inline void debug(const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  vfprintf(stderr, format, args);
+  va_end(args);
+}
+
+static inline void debug_if(int condition, const char *format, ...) {
+  if (condition == 1) {
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+  }
+}
+
+#endif
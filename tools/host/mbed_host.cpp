@@ -0,0 +1,320 @@
+//-----------------------------------------------------------------------------
+// Host implementations for mbed.h.  See the comment there.
+//-----------------------------------------------------------------------------
+
+#include <stdarg.h>
+#include "mbed.h"
+#undef fopen
+
+using namespace mbed;
+
+#include <deque>
+
+SPIHostDevice *spi_host_device=0;
+SPI_HOST_STATS spi_host_stats;
+double spi_host_write_gap=0.5e-6;
+
+static LPC_SSP_TypeDef ssp;
+static std::deque<uint8_t> ssp_rx;
+static int ssp_hz=1000000;
+
+// nothing on the host needs real delays; the SD card model counts its busy
+// time in bus bytes
+void wait(float /*s*/) {}
+void wait_ms(int /*ms*/) {}
+void wait_us(int /*us*/) {}
+
+unsigned us_ticker_read(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return (unsigned)(ts.tv_sec*1000000ULL+ts.tv_nsec/1000);
+}
+
+void error(const char *format, ...)
+{
+  va_list args;
+  va_start(args,format);
+  vfprintf(stderr,format,args);
+  va_end(args);
+  exit(1);
+}
+
+SPI::SPI(PinName /*mosi*/, PinName /*miso*/, PinName /*sclk*/)
+{
+  _spi.spi=&ssp;
+}
+
+void SPI::frequency(int hz)
+{
+  ssp_hz=hz;
+  if (spi_host_device)
+    spi_host_device->clock(hz);
+}
+
+int SPI::write(int value)
+{
+  spi_host_stats.bytes++;
+  spi_host_stats.calls++;
+  spi_host_stats.seconds+=8.0/ssp_hz+spi_host_write_gap;
+  return spi_host_device ? spi_host_device->exchange(value & 0xff) : 0xff;
+}
+
+ssp_host_dr &ssp_host_dr::operator=(uint32_t value)
+{
+  spi_host_stats.bytes++;
+  spi_host_stats.seconds+=8.0/ssp_hz;
+  ssp_rx.push_back(spi_host_device ? spi_host_device->exchange(value & 0xff) : 0xff);
+  if (ssp_rx.size() > 8)
+    error("SSP receive FIFO overrun\n");
+  return *this;
+}
+
+ssp_host_dr::operator uint32_t()
+{
+  uint32_t value=0;
+  if (!ssp_rx.empty()) {
+    value=ssp_rx.front();
+    ssp_rx.pop_front();
+  }
+  return value;
+}
+
+ssp_host_sr::operator uint32_t()
+{
+  return SSP_SR_TFE | SSP_SR_TNF | (ssp_rx.empty() ? 0 : SSP_SR_RNE);
+}
+
+void DigitalOut::write(int value)
+{
+  _value=value;
+  if (spi_host_device)
+    spi_host_device->select(value);
+}
+
+I2CHostDevice *i2c_host_device=0;
+I2C_HOST_STATS i2c_host_stats;
+static int i2c_hz=100000;
+
+void I2C::frequency(int hz)
+{
+  i2c_hz=hz;
+}
+
+void I2C::start()
+{
+  i2c_host_stats.starts++;
+  i2c_host_stats.seconds+=1.0/i2c_hz;
+  if (i2c_host_device)
+    i2c_host_device->start();
+}
+
+void I2C::stop()
+{
+  i2c_host_stats.seconds+=1.0/i2c_hz;
+  if (i2c_host_device)
+    i2c_host_device->stop();
+}
+
+// 1 for ack, as mbed's byte write returns
+int I2C::write(int data)
+{
+  i2c_host_stats.bytes++;
+  i2c_host_stats.seconds+=9.0/i2c_hz;
+  return i2c_host_device ? i2c_host_device->write(data & 0xff) : 0;
+}
+
+int I2C::read(int ack)
+{
+  i2c_host_stats.bytes++;
+  i2c_host_stats.seconds+=9.0/i2c_hz;
+  return i2c_host_device ? i2c_host_device->read(ack) & 0xff : 0xff;
+}
+
+// 0 on success, as mbed's transfers return
+int I2C::write(int address, const char *data, int length, bool repeated)
+{
+  int ok;
+
+  start();
+  ok=write(address & ~1);
+  for (int i=0;ok && i<length;i++)
+    ok=write(data[i]);
+  if (!ok || !repeated)
+    stop();
+  return !ok;
+}
+
+int I2C::read(int address, char *data, int length, bool repeated)
+{
+  start();
+  if (!write(address | 1)) {
+    stop();
+    return 1;
+  }
+  for (int i=0;i<length;i++)
+    data[i]=read(i < length-1);
+  if (!repeated)
+    stop();
+  return 0;
+}
+
+// one InterruptIn per pin, and which pins are driven low; pins idle high
+static InterruptIn *pin_irq[64];
+static char pin_low[64];
+
+static int pin_index(PinName pin)
+{
+  return pin & 63;
+}
+
+InterruptIn::InterruptIn(PinName pin) : _pin(pin), _rise(0), _fall(0), _enabled(1), _pending_rise(0), _pending_fall(0)
+{
+  pin_irq[pin_index(pin)]=this;
+}
+
+InterruptIn::~InterruptIn()
+{
+  if (pin_irq[pin_index(_pin)] == this)
+    pin_irq[pin_index(_pin)]=0;
+  delete _rise;
+  delete _fall;
+}
+
+int InterruptIn::read()
+{
+  return !pin_low[pin_index(_pin)];
+}
+
+void InterruptIn::set(host_callback **slot, host_callback *cb)
+{
+  delete *slot;
+  *slot=cb;
+}
+
+void InterruptIn::edge(int level)
+{
+  if (!_enabled) {
+    if (level)
+      _pending_rise=1;
+    else
+      _pending_fall=1;
+  }
+  else if (level && _rise)
+    _rise->call();
+  else if (!level && _fall)
+    _fall->call();
+}
+
+void InterruptIn::enable_irq()
+{
+  _enabled=1;
+  if (_pending_rise && _rise)
+    _rise->call();
+  if (_pending_fall && _fall)
+    _fall->call();
+  _pending_rise=_pending_fall=0;
+}
+
+void InterruptIn::disable_irq()
+{
+  _enabled=0;
+}
+
+void InterruptIn::host_drive(PinName pin, int level)
+{
+  int i=pin_index(pin);
+  if (pin_low[i] == !level)
+    return;
+  pin_low[i]=!level;
+  if (pin_irq[i])
+    pin_irq[i]->edge(!!level);
+}
+
+int Serial::printf(const char *format, ...)
+{
+  va_list args;
+  va_start(args,format);
+  int n=vfprintf(stderr,format,args);
+  va_end(args);
+  return n;
+}
+
+FileSystemLike *FileSystemLike::_head=0;
+
+FileSystemLike::FileSystemLike(const char *name) : _name(name), _next(_head)
+{
+  _head=this;
+}
+
+FileSystemLike::~FileSystemLike()
+{
+  for (FileSystemLike **p=&_head;*p;p=&(*p)->_next)
+    if (*p == this) {
+      *p=_next;
+      break;
+    }
+}
+
+FileSystemLike *FileSystemLike::lookup(const char *name, size_t len)
+{
+  for (FileSystemLike *fs=_head;fs;fs=fs->_next)
+    if (strlen(fs->_name) == len && !strncmp(fs->_name,name,len))
+      return fs;
+  return 0;
+}
+
+static ssize_t cookie_read(void *cookie, char *buf, size_t size)
+{
+  ssize_t n=((FileHandle *)cookie)->read(buf,size);
+  return n < 0 ? -1 : n;
+}
+
+// a short count is how a cookie write reports an error
+static ssize_t cookie_write(void *cookie, const char *buf, size_t size)
+{
+  ssize_t n=((FileHandle *)cookie)->write(buf,size);
+  return n < 0 ? 0 : n;
+}
+
+static int cookie_seek(void *cookie, off64_t *offset, int whence)
+{
+  off_t pos=((FileHandle *)cookie)->lseek(*offset,whence);
+  if (pos < 0)
+    return -1;
+  *offset=pos;
+  return 0;
+}
+
+static int cookie_close(void *cookie)
+{
+  return ((FileHandle *)cookie)->close();
+}
+
+FILE *mbed_host_fopen(const char *path, const char *mode)
+{
+  const char *slash;
+  FileSystemLike *fs;
+
+  if (path[0] != '/' || !(slash=strchr(path+1,'/')) ||
+      !(fs=FileSystemLike::lookup(path+1,slash-(path+1))))
+    return fopen(path,mode);
+
+// the same mapping as mbed's retarget
+  int flags=O_RDONLY;
+  if (mode[0] == 'w')
+    flags=O_WRONLY | O_CREAT | O_TRUNC;
+  else if (mode[0] == 'a')
+    flags=O_WRONLY | O_CREAT | O_APPEND;
+  if (strchr(mode,'+'))
+    flags=(flags & ~O_WRONLY) | O_RDWR;
+
+  FileHandle *fh=fs->open(slash+1,flags);
+  if (!fh)
+    return 0;
+  cookie_io_functions_t io={cookie_read,cookie_write,cookie_seek,cookie_close};
+  FILE *f=fopencookie(fh,mode,io);
+  if (!f)
+    fh->close();
+  return f;
+}
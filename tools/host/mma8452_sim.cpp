@@ -0,0 +1,147 @@
+//-----------------------------------------------------------------------------
+// MMA8452Q model.  See mma8452_sim.h.
+//-----------------------------------------------------------------------------
+
+#include <math.h>
+#include "mma8452_sim.h"
+
+#define SIM_ADDRESS 0x3A
+#define REG_STATUS 0x00
+#define REG_OUT_X_MSB 0x01
+#define REG_OUT_Z_MSB 0x05
+#define REG_OUT_Z_LSB 0x06
+#define REG_INT_SOURCE 0x0C
+#define REG_WHO_AM_I 0x0D
+#define REG_XYZ_DATA_CFG 0x0E
+#define REG_CTRL_REG_1 0x2A
+#define REG_CTRL_REG_3 0x2C
+#define REG_CTRL_REG_4 0x2D
+#define REG_CTRL_REG_5 0x2E
+
+#define CTRL1_ACTIVE 0x01
+#define CTRL1_F_READ 0x02
+
+mma8452_sim::mma8452_sim(PinName int1) : nack(0), _int1(int1), _state(IDLE), _reg(0)
+{
+  memset(regs,0,sizeof(regs));
+  memset(&stats,0,sizeof(stats));
+  regs[REG_WHO_AM_I]=0x2A;
+  i2c_host_device=this;
+  InterruptIn::host_drive(_int1,1);
+}
+
+mma8452_sim::~mma8452_sim()
+{
+  if (i2c_host_device == this)
+    i2c_host_device=0;
+}
+
+void mma8452_sim::start()
+{
+  _state=ADDRESS;
+}
+
+void mma8452_sim::stop()
+{
+  _state=IDLE;
+}
+
+int mma8452_sim::write(int data)
+{
+  switch (_state) {
+  case ADDRESS:
+    if (nack) {
+      nack--;
+      _state=IDLE;
+      return 0;
+    }
+    if ((data & 0xFE) != SIM_ADDRESS) {
+      _state=IDLE;
+      return 0;
+    }
+    _state=data & 1 ? READ_DATA : REGISTER;
+    return 1;
+  case REGISTER:
+    _reg=data;
+    _state=WRITE_DATA;
+    return 1;
+  case WRITE_DATA:
+    if (_reg >= (int)sizeof(regs))
+      return 0;
+    if ((regs[REG_CTRL_REG_1] & CTRL1_ACTIVE) && _reg != REG_CTRL_REG_1)
+      stats.ignored_writes++;
+    else if (_reg != REG_STATUS && _reg != REG_WHO_AM_I && (_reg < REG_OUT_X_MSB || _reg > REG_OUT_Z_LSB))
+      regs[_reg]=data;
+    _reg=next_register(_reg);
+    update_int1();
+    return 1;
+  }
+  return 0;
+}
+
+int mma8452_sim::read(int /*ack*/)
+{
+  if (_state != READ_DATA || _reg >= (int)sizeof(regs))
+    return 0xff;
+  int value=regs[_reg];
+  int last=regs[REG_CTRL_REG_1] & CTRL1_F_READ ? REG_OUT_Z_MSB : REG_OUT_Z_LSB;
+  if (_reg == last) {
+    // the whole sample has been read
+    regs[REG_STATUS]=0;
+    regs[REG_INT_SOURCE]&=~0x01;
+    stats.reads++;
+    update_int1();
+  }
+  _reg=next_register(_reg);
+  return value;
+}
+
+// the output block wraps back to STATUS; fast read skips the LSBs
+int mma8452_sim::next_register(int reg)
+{
+  if (reg > REG_OUT_Z_LSB)
+    return reg+1;
+  if (regs[REG_CTRL_REG_1] & CTRL1_F_READ)
+    return reg == REG_STATUS ? REG_OUT_X_MSB : reg == REG_OUT_Z_MSB ? REG_STATUS : reg+2;
+  return reg == REG_OUT_Z_LSB ? REG_STATUS : reg+1;
+}
+
+// data ready on INT1 when enabled and routed there; IPOL in CTRL_REG_3 sets
+// the active level
+void mma8452_sim::update_int1()
+{
+  int asserted=(regs[REG_INT_SOURCE] & 0x01) && (regs[REG_CTRL_REG_4] & 0x01) && (regs[REG_CTRL_REG_5] & 0x01);
+  int active_high=(regs[REG_CTRL_REG_3] & 0x02) != 0;
+  InterruptIn::host_drive(_int1,asserted ? active_high : !active_high);
+}
+
+void mma8452_sim::sample(double x, double y, double z)
+{
+  double g[3]={x,y,z};
+
+  if (!(regs[REG_CTRL_REG_1] & CTRL1_ACTIVE))
+    return;
+  stats.samples++;
+  // 12 bit counts, left aligned; 1024 per G at 2G, halved per range step
+  int per_g=1024 >> (regs[REG_XYZ_DATA_CFG] & 0x03);
+  for (int i=0;i<3;i++) {
+    long v=lround(g[i]*per_g);
+    if (v > 2047) v=2047;
+    if (v < -2048) v=-2048;
+    regs[REG_OUT_X_MSB+2*i]=(v >> 4) & 0xff;
+    regs[REG_OUT_X_MSB+2*i+1]=(v << 4) & 0xf0;
+  }
+  if (regs[REG_STATUS] & 0x08) {
+    stats.overwritten++;
+    regs[REG_STATUS]|=0xF0;
+  }
+  regs[REG_STATUS]|=0x0F;
+  regs[REG_INT_SOURCE]|=0x01;
+  update_int1();
+}
+
+double mma8452_sim::rate()
+{
+  static const double hz[8]={800,400,200,100,50,12.5,6.25,1.563};
+  return hz[(regs[REG_CTRL_REG_1] >> 3) & 7];
+}
@@ -0,0 +1,58 @@
+//-----------------------------------------------------------------------------
+// MMA8452Q accelerometer model for the host I2C bus (see mbed.h in this
+// directory).
+//
+// Registers 0x00-0x31 with auto-increment, the fast read (F_READ) order that
+// skips the LSBs, and the data ready interrupt on INT1, active low.  The
+// model samples when told to by sample(), at whatever rate the caller keeps;
+// rate() says what CTRL_REG_1 asks for.  Reading the last output byte clears
+// data ready and releases INT1.  Writes to registers other than CTRL_REG_1
+// while active are ignored, as the part ignores them, and counted.  Setting
+// nack makes the part NACK that many of the next addresses, as on a bad bus.
+//-----------------------------------------------------------------------------
+#ifndef MMA8452_SIM_H
+#define MMA8452_SIM_H
+
+#include "mbed.h"
+
+typedef struct {
+  unsigned samples;          ///< sample() calls while active
+  unsigned overwritten;      ///< samples taken before the last was read
+  unsigned reads;            ///< complete reads of the output registers
+  unsigned ignored_writes;   ///< register writes made while active
+} MMA8452_SIM_STATS;
+
+class mma8452_sim : public I2CHostDevice {
+public:
+  /** Create the part at address 0x3A (SA0 high), with INT1 wired to the
+   * given pin, and attach it to the host I2C bus.
+   */
+  mma8452_sim(PinName int1);
+  virtual ~mma8452_sim();
+
+  virtual void start();
+  virtual void stop();
+  virtual int write(int data);
+  virtual int read(int ack);
+
+  /** Take a sample of the given accelerations in G, if active. */
+  void sample(double x, double y, double z);
+  /// output data rate set in CTRL_REG_1, in Hz
+  double rate();
+
+  uint8_t regs[0x32];
+  MMA8452_SIM_STATS stats;
+  unsigned nack;             ///< addresses still to NACK
+
+private:
+  enum { IDLE, ADDRESS, REGISTER, WRITE_DATA, READ_DATA };
+
+  int next_register(int reg);
+  void update_int1();
+
+  PinName _int1;
+  int _state;
+  int _reg;
+};
+
+#endif
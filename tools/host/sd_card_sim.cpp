@@ -0,0 +1,243 @@
+//-----------------------------------------------------------------------------
+// SD card model for the host SPI bus.  See sd_card_sim.h.
+//
+// Bytes the card sends are queued in _out.  Each exchange() returns the
+// next queued byte (0xFF when there is none) while the byte from the host
+// drives the command and write state machine.  A wait in the queue holds
+// the line at one level until the bus clock has moved on far enough.
+//-----------------------------------------------------------------------------
+
+#include "sd_card_sim.h"
+
+#define R1_IDLE_STATE       0x01
+#define R1_ILLEGAL_COMMAND  0x04
+#define R1_ADDRESS_ERROR    0x20
+#define R1_PARAMETER_ERROR  0x40
+
+#define WAIT_MARK           (1LL << 40)
+
+sd_card_sim::sd_card_sim(unsigned blocks) : image((size_t)blocks*512)
+{
+  timing.read_access_us=300;
+  timing.read_next_us=20;
+  timing.write_single_us=800;
+  timing.write_multi_us=250;
+  timing.write_stop_us=800;
+  timing.tran_speed=0x32;
+  memset(&stats,0,sizeof(stats));
+  _cmd_len=0;
+  _state=IDLE;
+  _selected=0;
+  _hz=100000;
+  _idle=1;
+  _app=0;
+  _multi=0;
+  _block=0;
+  _data_len=0;
+  _wait_until=0;
+  _wait_level=0xff;
+  spi_host_device=this;
+}
+
+sd_card_sim::~sd_card_sim()
+{
+  if (spi_host_device == this)
+    spi_host_device=0;
+}
+
+void sd_card_sim::select(int level)
+{
+  _selected=!level;
+}
+
+int sd_card_sim::exchange(int in)
+{
+  int reply=0xff;
+
+  if (!_selected)
+    return 0xff;
+// a multiple block read keeps streaming blocks until CMD12 arrives
+  if (_out.empty() && _state == READ_MULTI && (size_t)_block*512 < image.size()) {
+    queue_wait(timing.read_next_us,0xff);
+    queue_block(_block++);
+  }
+  if (spi_host_stats.seconds < _wait_until)
+    reply=_wait_level;
+  else if (!_out.empty() && (_out.front() & WAIT_MARK)) {
+    _wait_until=spi_host_stats.seconds+(_out.front() & 0xffffffff)*1e-6;
+    _wait_level=(_out.front() >> 32) & 0xff;
+    reply=_wait_level;
+    _out.pop_front();
+  }
+  else if (!_out.empty()) {
+    reply=(int)_out.front();
+    _out.pop_front();
+  }
+
+  switch (_state) {
+    case IDLE:
+    case READ_MULTI:
+      if ((in & 0xc0) == 0x40 && (_state == IDLE || in == (0x40 | 12))) {
+        _cmd[0]=in;
+        _cmd_len=1;
+        _state=COMMAND;
+      }
+      break;
+    case COMMAND:
+      _cmd[_cmd_len++]=in;
+      if (_cmd_len == 6)
+        command();
+      break;
+    case WRITE_TOKEN:
+      if (in == (_multi ? 0xfc : 0xfe)) {
+        _state=WRITE_DATA;
+        _data_len=0;
+      }
+      else if (in == 0xfd && _multi) {
+// stop tran: one byte, then busy while the last blocks are programmed
+        _out.push_back(0xff);
+        queue_wait(timing.write_stop_us,0x00);
+        _multi=0;
+        _state=IDLE;
+      }
+      break;
+    case WRITE_DATA:
+      _data[_data_len++]=in;
+      if (_data_len == sizeof(_data)) {
+        if ((size_t)(_block+1)*512 <= image.size()) {
+          memcpy(&image[(size_t)_block*512],_data,512);
+          stats.blocks_written++;
+          _out.push_back(0xe5);       // data accepted
+          queue_wait(_multi ? timing.write_multi_us : timing.write_single_us,0x00);
+        }
+        else
+          _out.push_back(0xed);       // write error
+        _block++;
+        _state=_multi ? WRITE_TOKEN : IDLE;
+      }
+      break;
+  }
+  return reply;
+}
+
+void sd_card_sim::command(void)
+{
+  int cmd=_cmd[0] & 0x3f;
+  unsigned arg=(unsigned)_cmd[1] << 24 | _cmd[2] << 16 | _cmd[3] << 8 | _cmd[4];
+  int app=_app;
+  unsigned blocks=image.size()/512;
+  uint8_t csd[16];
+
+  stats.commands++;
+  _state=IDLE;
+  _app=0;
+  switch (cmd) {
+    case 0:
+      _idle=1;
+      _multi=0;
+      _out.clear();
+      _wait_until=0;
+      respond(R1_IDLE_STATE);
+      break;
+    case 8:
+      respond(_idle);
+      _out.push_back(0x00);
+      _out.push_back(0x00);
+      _out.push_back(_cmd[3]);
+      _out.push_back(_cmd[4]);
+      break;
+    case 9:
+// CSD version 2.0: TRAN_SPEED in byte 3, READ_BL_LEN 9, C_SIZE in bits 69:48
+      memset(csd,0,sizeof(csd));
+      csd[0]=0x40;
+      csd[3]=timing.tran_speed;
+      csd[5]=0x09;
+      csd[7]=((blocks/1024-1) >> 16) & 0x3f;
+      csd[8]=((blocks/1024-1) >> 8) & 0xff;
+      csd[9]=(blocks/1024-1) & 0xff;
+      respond(_idle);
+      queue_wait(timing.read_access_us,0xff);
+      _out.push_back(0xfe);
+      _out.insert(_out.end(),csd,csd+sizeof(csd));
+      _out.push_back(0x00);
+      _out.push_back(0x00);
+      break;
+    case 12:
+// the card drops the block it was sending
+      _out.clear();
+      _wait_until=0;
+      _out.push_back(0xff);
+      respond(0);
+      _out.push_back(0x00);
+      break;
+    case 16:
+      respond(arg == 512 ? _idle : R1_PARAMETER_ERROR);
+      break;
+    case 17:
+    case 18:
+      if (arg >= blocks) {
+        respond(R1_ADDRESS_ERROR);
+        break;
+      }
+      respond(0);
+      queue_wait(timing.read_access_us,0xff);
+      queue_block(arg);
+      if (cmd == 18) {
+        _block=arg+1;
+        _state=READ_MULTI;
+      }
+      break;
+    case 24:
+    case 25:
+      if (arg >= blocks) {
+        respond(R1_ADDRESS_ERROR);
+        break;
+      }
+      respond(0);
+      _block=arg;
+      _multi=cmd == 25;
+      _state=WRITE_TOKEN;
+      break;
+    case 41:
+      if (app)
+        _idle=0;
+      respond(app ? _idle : (R1_ILLEGAL_COMMAND | _idle));
+      break;
+    case 55:
+      _app=1;
+      respond(_idle);
+      break;
+    case 58:
+// OCR with the card capacity status bit set: block addressing
+      respond(_idle);
+      _out.push_back(0xc0);
+      _out.push_back(0xff);
+      _out.push_back(0x80);
+      _out.push_back(0x00);
+      break;
+    default:
+      respond(R1_ILLEGAL_COMMAND | _idle);
+      break;
+  }
+}
+
+// one byte of NCR before every response
+void sd_card_sim::respond(uint8_t r1)
+{
+  _out.push_back(0xff);
+  _out.push_back(r1);
+}
+
+void sd_card_sim::queue_wait(unsigned us, uint8_t level)
+{
+  _out.push_back(WAIT_MARK | (int64_t)level << 32 | us);
+}
+
+void sd_card_sim::queue_block(unsigned block)
+{
+  _out.push_back(0xfe);
+  _out.insert(_out.end(),image.begin()+(size_t)block*512,image.begin()+(size_t)block*512+512);
+  _out.push_back(0x00);
+  _out.push_back(0x00);
+  stats.blocks_read++;
+}
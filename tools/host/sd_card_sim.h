@@ -0,0 +1,81 @@
+//-----------------------------------------------------------------------------
+// SD card model for the host SPI bus (see mbed.h in this directory).
+//
+// Speaks enough of the SPI mode protocol for SDFileSystem: CMD0, CMD8,
+// CMD9, CMD12, CMD16, CMD17, CMD18, CMD24, CMD25, CMD55, CMD58 and ACMD41.
+// It presents itself as a v2 high capacity card (block addressing) backed
+// by a RAM image.
+//
+// The card's own delays are modelled the way the host sees them: for the
+// given time, measured on the spi_host_stats.seconds clock, the card
+// answers 0xFF (no data token yet) or 0x00 (busy).  However the driver
+// polls, the wait costs the same bus time.  The default latencies are in
+// the range of an ordinary class 4 card; they are assumptions, not
+// measurements, and can be changed through the timing member.
+//-----------------------------------------------------------------------------
+#ifndef SD_CARD_SIM_H
+#define SD_CARD_SIM_H
+
+#include <deque>
+#include <vector>
+#include "mbed.h"
+
+typedef struct {
+  unsigned read_access_us;    ///< command to first data token
+  unsigned read_next_us;      ///< between blocks of a CMD18 read
+  unsigned write_single_us;   ///< programming after a CMD24 block
+  unsigned write_multi_us;    ///< programming after each CMD25 block
+  unsigned write_stop_us;     ///< busy after the CMD25 stop token
+  unsigned tran_speed;        ///< CSD TRAN_SPEED byte, 0x32 is 25MHz
+} SD_CARD_TIMING;
+
+/** Command and block counts, for checking what a driver did. */
+typedef struct {
+  unsigned commands;
+  unsigned blocks_read;
+  unsigned blocks_written;
+} SD_CARD_STATS;
+
+class sd_card_sim : public SPIHostDevice {
+public:
+  /** Create a card of the given number of 512 byte blocks and attach it
+   * to the host SPI bus.
+   */
+  sd_card_sim(unsigned blocks);
+  virtual ~sd_card_sim();
+
+  virtual int exchange(int out);
+  virtual void select(int level);
+  virtual void clock(int hz) { _hz=hz; }
+  /// the bus clock last programmed, for reports
+  int clock(void) { return _hz; }
+
+  std::vector<uint8_t> image;
+  SD_CARD_TIMING timing;
+  SD_CARD_STATS stats;
+
+private:
+  enum { IDLE, COMMAND, READ_MULTI, WRITE_TOKEN, WRITE_DATA };
+
+  void command(void);
+  void queue_wait(unsigned us, uint8_t level);
+  void queue_block(unsigned block);
+  void respond(uint8_t r1);
+
+  std::deque<int64_t> _out;   // bytes, and waits as WAIT_MARK | level << 32 | us
+  double _wait_until;
+  uint8_t _wait_level;
+  uint8_t _cmd[6];
+  int _cmd_len;
+  int _state;
+  int _selected;
+  int _hz;
+  int _idle;
+  int _app;
+  int _multi;               // CMD25 in progress
+  unsigned _block;          // next block of a multi block transfer
+  unsigned _data_len;
+  uint8_t _data[514];
+};
+
+#endif
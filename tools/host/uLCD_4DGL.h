@@ -0,0 +1,32 @@
+//-----------------------------------------------------------------------------
+// Host stand-in for the 4D Systems uLCD driver: the calls made by code the
+// host tools build compile and draw nothing.  Put tools/host first on the
+// include path so this shadows 4DGL-uLCD-SE/uLCD_4DGL.h.
+//-----------------------------------------------------------------------------
+#ifndef ULCD_4DGL_H
+#define ULCD_4DGL_H
+
+#include "mbed.h"
+
+#define SIZE_X 128
+#define SIZE_Y 128
+
+class uLCD_4DGL {
+public:
+  uLCD_4DGL(PinName /*tx*/, PinName /*rx*/, PinName /*rst*/) : tx_bytes(0) {}
+  void cls() {}
+  void locate(int /*col*/, int /*row*/) {}
+  void color(int /*color*/) {}
+  void BLIT565(int /*x*/, int /*y*/, int /*w*/, int /*h*/, const char * /*pixels*/) {}
+  int printf(const char * /*format*/, ...) { return 0; }
+  void circle(int /*x*/, int /*y*/, int /*radius*/, int /*color*/) {}
+  void filled_circle(int /*x*/, int /*y*/, int /*radius*/, int /*color*/) {}
+  void triangle(int /*x1*/, int /*y1*/, int /*x2*/, int /*y2*/, int /*x3*/, int /*y3*/, int /*color*/) {}
+  void line(int /*x1*/, int /*y1*/, int /*x2*/, int /*y2*/, int /*color*/) {}
+  void rectangle(int /*x1*/, int /*y1*/, int /*x2*/, int /*y2*/, int /*color*/) {}
+  void filled_rectangle(int /*x1*/, int /*y1*/, int /*x2*/, int /*y2*/, int /*color*/) {}
+
+  unsigned int tx_bytes;
+};
+
+#endif
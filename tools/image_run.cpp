@@ -0,0 +1,225 @@
+//-----------------------------------------------------------------------------
+// image_run -- run the game's file code on the host against a FAT image.
+// Mounts tools/host/ImageFileSystem as "sd", so the unchanged wave_player,
+// testbench and stdio code open "/sd/..." paths just as on the board, then
+// carries out the commands given, in order.  Meant for CI: build an image,
+// put the assets in, play them, run traces and check the files written.
+//
+// Build on the host:
+//   g++ -O2 -fpermissive -I tools/host -I . -I wave_player -I AssetPack
+//     -I SDFileSystem -I SDFileSystem/FATFileSystem
+//     -I SDFileSystem/FATFileSystem/ChaN -c testbench.cpp
+//   g++ -O2 -pthread -I tools/host -I . -I wave_player
+//     -I AssetPack -I SDFileSystem -I SDFileSystem/FATFileSystem
+//     -I SDFileSystem/FATFileSystem/ChaN -o image_run tools/image_run.cpp
+//     AssetPack/AssetPack.cpp tools/host/ImageFileSystem.cpp
+//     tools/host/mbed_host.cpp tools/host/dac_dma_host.cpp
+//     wave_player/wave_player.cpp
+//     wave_player/dac_dma.cpp wave_player/ima_adpcm.cpp testbench.o
+//     doubly_linked_list.cpp SDFileSystem/FATFileSystem/*.cpp
+//     SDFileSystem/FATFileSystem/ChaN/*.cpp
+// (-fpermissive, for testbench.cpp alone: it casts pointers to int, which is
+// fine on the LPC1768 and on the small values in trace files; g++ still
+// warns about the one in parse_trace)
+//
+// Usage:
+//   image_run IMAGE COMMAND...
+//     mkfs SECTORS        create IMAGE with this many sectors and format it
+//     mkdir PATH          make a directory
+//     put HOSTFILE PATH   copy a host file into the image
+//     get PATH HOSTFILE   copy a file out of the image
+//     cat PATH            print a file
+//     append PATH TEXT    append a line, as a score table or log would
+//     log PATH            print the committed part of a FATLogFile
+//     pack PATH           load an asset pack, mounted as /pak
+//     play PATH           wave_player::play(), in real time
+//     stream PATH         wave_player::start()/service() until the end
+//     trace TRACE OUT     testbench's test_dlinkedlist()
+//     realtime 0|1        sleep for the modelled card latency
+//   e.g. image_run sd.img mkfs 65536 mkdir /sd/wavfiles
+//          put fx.wav /sd/wavfiles/fx.wav play /sd/wavfiles/fx.wav
+//
+// The disk's modelled time and traffic are printed at the end; the exit
+// status is 1 if any command failed.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mbed.h"
+#include "ImageFileSystem.h"
+#include "FATLogFile.h"
+#include "AssetPack.h"
+#include "wave_player.h"
+#include "dac_dma_host.h"
+#include "testbench.h"
+
+static AnalogOut DACout(p18);
+static AssetPack pak("pak");
+static wave_player waver(&DACout);
+static unsigned long long played;
+
+static void count_samples(const uint32_t * /*half*/, int n)
+{
+  played+=n;
+}
+
+static int copy(const char *from, const char *to)
+{
+  FILE *in=fopen(from,"rb"),*out;
+  char buf[4096];
+  size_t n;
+  int err=0;
+
+  if (!in)
+    return 1;
+  out=fopen(to,"wb");
+  if (!out) {
+    fclose(in);
+    return 1;
+  }
+  while ((n=fread(buf,1,sizeof(buf),in)) > 0)
+    if (fwrite(buf,1,n,out) != n)
+      err=1;
+  fclose(in);
+  return fclose(out) || err;
+}
+
+static int print_log(ImageFileSystem *sd, const char *path)
+{
+  FATLogFile log(sd,2);
+  FILE *f=fopen(path,"r");
+  char buf[512];
+  uint32_t off;
+  int n;
+
+// open() would create a missing file
+  if (!f)
+    return 1;
+  fclose(f);
+  if (strncmp(path,"/sd/",4) || log.open(path+4,0))
+    return 1;
+  for (off=0;(n=log.read(buf,off,sizeof(buf))) > 0;off+=n)
+    fwrite(buf,1,n,stdout);
+  return n < 0;
+}
+
+static int play(const char *path)
+{
+  FILE *f=fopen(path,"r");
+  if (!f)
+    return 1;
+  played=0;
+  waver.play(f);
+  fclose(f);
+  printf("played %llu samples\n",played);
+  return played == 0;
+}
+
+static int stream(const char *path)
+{
+  WAVE_STREAM_STATS stats;
+  FILE *f=fopen(path,"r");
+  if (!f)
+    return 1;
+  played=0;
+  if (!waver.start(f,0)) {
+    fclose(f);
+    return 1;
+  }
+  while (waver.service(2))
+    wait_us(1000);
+  waver.get_stream_stats(&stats);
+  fclose(f);
+  printf("streamed %llu samples: %u reads, longest %u us, %u underruns, low water %u\n",
+         played,stats.reads,stats.max_read_us,stats.underruns,stats.low_water);
+  return played == 0;
+}
+
+int main(int argc, char **argv)
+{
+  ImageFileSystem *sd;
+  IMAGE_STATS stats;
+  int failed=0,i=2,r;
+
+  if (argc < 2) {
+    printf("usage: image_run IMAGE COMMAND...\n");
+    return 1;
+  }
+  if (argc > 3 && !strcmp(argv[2],"mkfs")) {
+    sd=new ImageFileSystem(argv[1],"sd",strtoull(argv[3],0,0));
+    if (sd->format()) {
+      printf("format failed\n");
+      return 1;
+    }
+    i=4;
+  }
+  else
+    sd=new ImageFileSystem(argv[1],"sd");
+  dac_dma_host_sink=count_samples;
+
+  for (;i < argc;i++) {
+    const char *cmd=argv[i];
+    r=0;
+    if (!strcmp(cmd,"mkdir") && i+1 < argc) {
+      const char *path=argv[++i];
+      r=strncmp(path,"/sd/",4) || sd->mkdir(path+4,0777);
+    }
+    else if (!strcmp(cmd,"put") && i+2 < argc) {
+      r=copy(argv[i+1],argv[i+2]);
+      i+=2;
+    }
+    else if (!strcmp(cmd,"get") && i+2 < argc) {
+      r=copy(argv[i+1],argv[i+2]);
+      i+=2;
+    }
+    else if (!strcmp(cmd,"cat") && i+1 < argc) {
+      FILE *f=fopen(argv[++i],"r");
+      int c;
+      if (!f)
+        r=1;
+      else {
+        while ((c=fgetc(f)) != EOF)
+          putchar(c);
+        fclose(f);
+      }
+    }
+    else if (!strcmp(cmd,"append") && i+2 < argc) {
+      FILE *f=fopen(argv[i+1],"a");
+      r=!f || fprintf(f,"%s\n",argv[i+2]) < 0 || fclose(f);
+      i+=2;
+    }
+    else if (!strcmp(cmd,"log") && i+1 < argc)
+      r=print_log(sd,argv[++i]);
+    else if (!strcmp(cmd,"pack") && i+1 < argc) {
+      const char *path=argv[++i];
+      r=strncmp(path,"/sd/",4) || pak.load(sd,path+4);
+      if (!r)
+        printf("%d assets\n",pak.count());
+    }
+    else if (!strcmp(cmd,"play") && i+1 < argc)
+      r=play(argv[++i]);
+    else if (!strcmp(cmd,"stream") && i+1 < argc)
+      r=stream(argv[++i]);
+    else if (!strcmp(cmd,"trace") && i+2 < argc) {
+      test_dlinkedlist(argv[i+1],argv[i+2]);
+      i+=2;
+    }
+    else if (!strcmp(cmd,"realtime") && i+1 < argc)
+      sd->latency.realtime=atoi(argv[++i]);
+    else {
+      printf("bad command %s\n",cmd);
+      return 1;
+    }
+    if (r) {
+      printf("%s failed\n",cmd);
+      failed=1;
+    }
+  }
+
+  sd->get_stats(&stats);
+  printf("disk: %u reads (%u sectors), %u writes (%u sectors), %.1f ms modelled\n",
+         stats.reads,stats.sectors_read,stats.writes,stats.sectors_written,stats.seconds*1e3);
+  delete sd;
+  return failed;
+}
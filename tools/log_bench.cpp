@@ -0,0 +1,257 @@
+//-----------------------------------------------------------------------------
+// log_bench -- host benchmark for FATLogFile against appending with stdio.
+// Logs a telemetry line per frame to the SD card model in tools/host, with a
+// commit every few frames, two ways:
+//   file   FATFileHandle write() per line and fsync() per commit, which is
+//          what fprintf() and fflush() on "/sd/..." come down to
+//   log    FATLogFile printf() and commit()
+// each with and without a FATSectorCache, and reports the card sectors
+// written per sector of log (write amplification), commands, and the bus
+// time of the slowest frame, which is the stall the game would see.
+//
+// A crash pass then copies the card at random points while logging, mounts
+// each copy, and checks the log reopens at its last commit with the right
+// contents, also with the newest commit record torn.
+//
+// Build on the host:
+//   g++ -O2 -I tools/host -I SDFileSystem -I SDFileSystem/FATFileSystem
+//     -I SDFileSystem/FATFileSystem/ChaN -o log_bench tools/log_bench.cpp
+//     tools/host/mbed_host.cpp tools/host/sd_card_sim.cpp
+//     SDFileSystem/SDFileSystem.cpp SDFileSystem/FATFileSystem/*.cpp
+//     SDFileSystem/FATFileSystem/ChaN/*.cpp
+//
+// Usage:
+//   log_bench [frames] [frames_per_commit] [buffer_sectors]
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include "SDFileSystem.h"
+#include "FATSectorCache.h"
+#include "FATLogFile.h"
+#include "sd_card_sim.h"
+#include "ff.h"
+
+#define CARD_BLOCKS 65536        // 32MB
+#define LOG_CAPACITY (512*1024)
+
+static sd_card_sim card(CARD_BLOCKS);
+static SDFileSystem sd(p5,p6,p7,p8,"sd");
+static int bad;
+
+typedef struct {
+  unsigned written,commands,bytes;
+  double seconds,worst;
+} COST;
+
+static int frame_line(char *line, unsigned frame)
+{
+  return sprintf(line,"%u %d %d %d %d %+.2f\n",frame,1+frame/900,(frame*7) % 11,
+                 4-(frame/2000) % 5,3-(frame/1500) % 4,(int)(frame*37 % 200-100)/100.0);
+}
+
+static FileHandle *file;
+static FATLogFile *fast;
+
+static int file_out(const char *line, int n) { return (int)file->write(line,n); }
+static int file_commit() { return file->fsync(); }
+static int log_out(const char *line, int n) { return fast->write(line,n); }
+static int log_commit() { return fast->commit(); }
+
+// run the frames through out(), committing with commit(); every frame's bus
+// time is measured
+static COST run(unsigned frames, unsigned per_commit, int (*out)(const char *, int), int (*commit)())
+{
+  COST c={0,0,0,0,0};
+  unsigned w0=card.stats.blocks_written,c0=card.stats.commands;
+  double t0=spi_host_stats.seconds;
+  char line[64];
+
+  for (unsigned f=0;f<frames;f++) {
+    double start=spi_host_stats.seconds;
+    int n=frame_line(line,f);
+    if (out(line,n) != n)
+      bad++;
+    c.bytes+=n;
+    if (f % per_commit == per_commit-1 && commit())
+      bad++;
+    if (spi_host_stats.seconds-start > c.worst)
+      c.worst=spi_host_stats.seconds-start;
+  }
+  c.written=card.stats.blocks_written-w0;
+  c.commands=card.stats.commands-c0;
+  c.seconds=spi_host_stats.seconds-t0;
+  return c;
+}
+
+static COST file_test(unsigned frames, unsigned per_commit)
+{
+  COST c;
+
+  sd.remove("0:/file.log");
+  file=sd.open("file.log",O_WRONLY | O_CREAT | O_APPEND);
+  if (!file) {
+    bad++;
+    return COST();
+  }
+  c=run(frames,per_commit,file_out,file_commit);
+  file->close();
+  return c;
+}
+
+static COST log_test(unsigned frames, unsigned per_commit, int buffer_sectors)
+{
+  FATLogFile log(&sd,buffer_sectors);
+  std::vector<char> back;
+  std::string expect;
+  char line[64];
+  COST c;
+
+  sd.remove("0:/fast.log");
+  if (log.open("fast.log",LOG_CAPACITY)) {
+    bad++;
+    return COST();
+  }
+  fast=&log;
+  c=run(frames,per_commit,log_out,log_commit);
+  for (unsigned f=0;f<frames;f++) {
+    frame_line(line,f);
+    expect+=line;
+  }
+  back.resize(log.length());
+  if (log.read(&back[0],0,back.size()) != (int)back.size() || std::string(back.begin(),back.end()) != expect)
+    bad++;
+  return c;
+}
+
+static void row(const char *name, COST c)
+{
+  printf("  %-12s | %6u %6u %6.2fx | %8.1f %7.2f\n",name,c.written,c.commands,
+         c.written*512.0/c.bytes,c.seconds*1e3,c.worst*1e3);
+}
+
+// the card as a reset would leave it: a copy of the image, mounted afresh
+static uint32_t reopen(std::vector<uint8_t> &copy, std::string &expect, int tear)
+{
+  std::vector<uint8_t> live;
+  uint32_t length;
+  FIL f;
+
+  live.swap(card.image);
+  card.image.swap(copy);
+  f_mount(0,&sd._fs);
+  if (tear) {
+    // scribble over the newest record: sector (sequence % 2) of the file
+    if (f_open(&f,"0:/crash.log",FA_READ))
+      bad++;
+    DWORD lba=sd._fs.database+(f.sclust-2)*sd._fs.csize;
+    f_close(&f);
+    uint32_t seq0,seq1;
+    memcpy(&seq0,&card.image[lba*512+4],4);
+    memcpy(&seq1,&card.image[(lba+1)*512+4],4);
+    card.image[(lba+(seq1 > seq0))*512+8]^=0x5A;
+  }
+  {
+    FATLogFile log(&sd,2);
+    std::vector<char> back;
+    if (log.open("crash.log",LOG_CAPACITY)) {
+      bad++;
+      length=0;
+    }
+    else {
+      length=log.length();
+      back.resize(length+1);
+      if (log.read(&back[0],0,length) != (int)length || std::string(back.begin(),back.begin()+length) != expect.substr(0,length))
+        bad++;
+    }
+  }
+  card.image.swap(copy);
+  card.image.swap(live);
+  f_mount(0,&sd._fs);
+  return length;
+}
+
+static void crash_test(unsigned frames, unsigned per_commit, int buffer_sectors)
+{
+  FATLogFile log(&sd,buffer_sectors);
+  std::string expect;
+  uint32_t committed=0,previous=0;
+  unsigned copies=0,torn=0;
+  char line[64];
+
+  if (log.open("crash.log",LOG_CAPACITY)) {
+    bad++;
+    return;
+  }
+  srand(11);
+  for (unsigned f=0;f<frames;f++) {
+    int n=frame_line(line,f);
+    log.write(line,n);
+    expect+=line;
+    if (f % per_commit == per_commit-1) {
+      previous=committed;
+      log.commit();
+      committed=log.length();
+    }
+    if (rand() % 50 == 0) {
+      std::vector<uint8_t> copy(card.image);
+      if (reopen(copy,expect,0) != committed)
+        bad++;
+      copies++;
+      if (committed) {
+        std::vector<uint8_t> copy2(card.image);
+        if (reopen(copy2,expect,1) != previous)
+          bad++;
+        torn++;
+      }
+    }
+  }
+  printf("crash: %u copies reopened at their last commit, %u with the newest record torn\n",copies,torn);
+}
+
+int main(int argc, char **argv)
+{
+  unsigned frames=argc > 1 ? atoi(argv[1]) : 3000;
+  unsigned per_commit=argc > 2 ? atoi(argv[2]) : 30;
+  int buffer_sectors=argc > 3 ? atoi(argv[3]) : 4;
+  FAT_LOG_STATS stats;
+
+  if (f_mkfs(0,0,4096)) {
+    printf("formatting the card failed\n");
+    return 1;
+  }
+  printf("%u frames, commit every %u, %d sector staging buffer\n",frames,per_commit,buffer_sectors);
+  printf("               | wrote   cmds  ampl.  |  bus ms  worst frame ms\n");
+  row("file",file_test(frames,per_commit));
+  row("log",log_test(frames,per_commit,buffer_sectors));
+  {
+    FATSectorCache cache(&sd,8,4);
+    row("file+cache",file_test(frames,per_commit));
+    row("log+cache",log_test(frames,per_commit,buffer_sectors));
+  }
+
+  {
+    FATLogFile log(&sd,buffer_sectors);
+    char line[64];
+    sd.remove("0:/fast.log");
+    log.open("fast.log",LOG_CAPACITY);
+    for (unsigned f=0;f<frames;f++) {
+      int n=frame_line(line,f);
+      log.write(line,n);
+      if (f % per_commit == per_commit-1)
+        log.commit();
+    }
+    log.get_stats(&stats);
+    printf("log: %u bytes, %u sectors, %u flushes, %u commits, %u fragments\n",
+           stats.bytes,stats.sectors,stats.flushes,stats.commits,stats.fragments);
+  }
+
+  crash_test(frames,per_commit,buffer_sectors);
+  if (bad) {
+    printf("%d checks failed\n",bad);
+    return 1;
+  }
+  return 0;
+}
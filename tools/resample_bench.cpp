@@ -0,0 +1,69 @@
+//-----------------------------------------------------------------------------
+// resample_bench -- host benchmark for wave_player's linear resampler.
+// Reports the resampler's cost per output sample and, for the usual asset
+// rates, the DAC interrupt rate with and without a fixed output rate.
+//
+// Build on the host:
+//   g++ -O2 -I wave_player -o resample_bench tools/resample_bench.cpp
+//
+// Usage:
+//   resample_bench [output_rate] [isr_cycles]
+//     isr_cycles is the cost of one Ticker interrupt on the LPC1768 (entry,
+//     the mbed ticker event list and dac_out()).  Measure it on the board
+//     with wave_player::get_isr_stats(); the default is a rough guess.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <vector>
+#include "resampler.h"
+
+#define LPC1768_HZ 96000000
+
+static double now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec+ts.tv_nsec*1e-9;
+}
+
+int main(int argc, char **argv)
+{
+  unsigned out_rate=argc > 1 ? atoi(argv[1]) : 16000;
+  unsigned isr_cycles=argc > 2 ? atoi(argv[2]) : 400;
+  static const unsigned rates[]={8000,11025,16000,22050,32000,44100,48000};
+
+  printf("output rate %u Hz, %u cycles per DAC interrupt\n\n",out_rate,isr_cycles);
+  printf(" file Hz | ISR/s before  CPU    | ISR/s after  CPU    | host ns/out\n");
+  for (unsigned k=0;k<sizeof(rates)/sizeof(rates[0]);k++) {
+    unsigned in_rate=rates[k];
+    std::vector<unsigned short> in(in_rate);     // one second of input
+    for (unsigned i=0;i<in.size();i++)
+      in[i]=(unsigned short)(32768+20000*sin(2*M_PI*440*i/in_rate));
+
+    RESAMPLER r;
+    unsigned long long produced=0,sum=0;
+    int reps=0,out;
+    double t0=now(),dt;
+    do {
+      resampler_init(&r,in_rate,out_rate,32768);
+      for (unsigned i=0;i<in.size();i++) {
+        resampler_push(&r,in[i]);
+        while (resampler_pop(&r,&out)) {
+          sum+=out;
+          produced++;
+        }
+      }
+      reps++;
+      dt=now()-t0;
+    } while (dt < 0.2);
+
+    printf("   %5u | %6u      %5.1f%% | %6u      %5.1f%% | %5.2f  (%llu)\n",in_rate,
+           in_rate,100.0*in_rate*isr_cycles/LPC1768_HZ,
+           out_rate,100.0*out_rate*isr_cycles/LPC1768_HZ,
+           dt*1e9/produced,sum % 1000);
+  }
+  return 0;
+}
@@ -0,0 +1,237 @@
+//-----------------------------------------------------------------------------
+// sd_bench -- host benchmark for SDFileSystem's sector transfers.
+// Runs the real driver against the SD card model in tools/host and reports
+// the SPI bus time per sector, card latencies included, for single block
+// commands (CMD17/CMD24 per sector) and multiple block commands
+// (CMD18/CMD25), then sequential read throughput in MB/s for byte at a
+// time SPI::write() transfers and for the SSP FIFO path, and how long a
+// read_start()/read_poll() background read holds the bus per poll.  Every
+// transfer is checked against the card image.
+//
+// Build on the host:
+//   g++ -O2 -I tools/host -I SDFileSystem -I SDFileSystem/FATFileSystem
+//     -I SDFileSystem/FATFileSystem/ChaN -o sd_bench tools/sd_bench.cpp
+//     tools/host/mbed_host.cpp tools/host/sd_card_sim.cpp
+//     SDFileSystem/SDFileSystem.cpp SDFileSystem/FATFileSystem/*.cpp
+//     SDFileSystem/FATFileSystem/ChaN/*.cpp
+//
+// Usage:
+//   sd_bench [spi_hz]
+//     spi_hz overrides the data clock SDFileSystem picks from the card's
+//     CSD after disk_initialize().
+//
+// The gap between SPI::write() calls is spi_host_write_gap in
+// tools/host/mbed_host.cpp, an estimate for the LPC1768.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "SDFileSystem.h"
+#include "sd_card_sim.h"
+#include "ff.h"
+
+#define CARD_BLOCKS 65536        // 32MB
+#define RUN_SECTORS 1024
+
+// can override the bus clock, fall back to one command per sector and turn
+// the FIFO path off
+class bench_sd : public SDFileSystem {
+public:
+  bench_sd() : SDFileSystem(p5,p6,p7,p8,"sd"), multi(1), hz(0) {}
+  virtual int disk_initialize() {
+    int r=SDFileSystem::disk_initialize();
+    if (hz)
+      _spi.frequency(hz);
+    return r;
+  }
+  virtual int disk_read_blocks(uint8_t *buffer, uint64_t sector, uint32_t count) {
+    if (multi)
+      return SDFileSystem::disk_read_blocks(buffer,sector,count);
+    return FATFileSystem::disk_read_blocks(buffer,sector,count);
+  }
+  virtual int disk_write_blocks(const uint8_t *buffer, uint64_t sector, uint32_t count) {
+    if (multi)
+      return SDFileSystem::disk_write_blocks(buffer,sector,count);
+    return FATFileSystem::disk_write_blocks(buffer,sector,count);
+  }
+  void fifo(int on) { _fifo=on; }
+  int multi;
+  int hz;
+};
+
+static sd_card_sim card(CARD_BLOCKS);
+static bench_sd sd;
+
+// bus seconds and card commands for RUN_SECTORS sectors in runs of count
+static double run(int write, unsigned count, unsigned *commands, int *bad)
+{
+  std::vector<uint8_t> buf(count*512);
+  double t0=spi_host_stats.seconds;
+  unsigned c0=card.stats.commands;
+  unsigned s,i;
+
+  for (s=0;s<RUN_SECTORS;s+=count) {
+    if (write) {
+      for (i=0;i<buf.size();i++)
+        buf[i]=(uint8_t)rand();
+      if (sd.disk_write_blocks(&buf[0],s,count) || memcmp(&buf[0],&card.image[s*512],buf.size()))
+        (*bad)++;
+    }
+    else {
+      if (sd.disk_read_blocks(&buf[0],s,count) || memcmp(&buf[0],&card.image[s*512],buf.size()))
+        (*bad)++;
+    }
+  }
+  *commands=card.stats.commands-c0;
+  return spi_host_stats.seconds-t0;
+}
+
+// sequential file write and read through FatFs, in chunk byte requests
+static void file_test(unsigned chunk)
+{
+  static const unsigned size=256*1024;
+  std::vector<uint8_t> buf(chunk);
+  FIL f;
+  UINT n;
+  double t0,tw,tr;
+  unsigned i;
+
+  for (i=0;i<chunk;i++)
+    buf[i]=(uint8_t)i;
+  t0=spi_host_stats.seconds;
+  f_open(&f,"0:/bench.bin",FA_WRITE | FA_CREATE_ALWAYS);
+  for (i=0;i<size;i+=chunk)
+    f_write(&f,&buf[0],chunk,&n);
+  f_close(&f);
+  tw=spi_host_stats.seconds-t0;
+
+  t0=spi_host_stats.seconds;
+  f_open(&f,"0:/bench.bin",FA_READ);
+  for (i=0;i<size;i+=chunk)
+    f_read(&f,&buf[0],chunk,&n);
+  f_close(&f);
+  tr=spi_host_stats.seconds-t0;
+
+  printf("  %6u  | %8.1f    %8.1f\n",chunk,size/1024.0/tw,size/1024.0/tr);
+}
+
+// sequential reads of 64 sectors per CMD18 at the given clock
+static void seq_read(int hz)
+{
+  std::vector<uint8_t> buf(64*512);
+  double t0,t[2];
+  int bad=0;
+
+  sd.multi=1;
+  for (int fifo=0;fifo<2;fifo++) {
+    sd.fifo(fifo);
+    sd.hz=hz;
+    sd.disk_initialize();
+    t0=spi_host_stats.seconds;
+    for (unsigned s=0;s<RUN_SECTORS;s+=64)
+      if (sd.disk_read_blocks(&buf[0],s,64) || memcmp(&buf[0],&card.image[s*512],buf.size()))
+        bad++;
+    t[fifo]=spi_host_stats.seconds-t0;
+  }
+  printf("sequential read at %5.2f MHz: byte loop %.2f MB/s, FIFO %.2f MB/s%s\n",hz/1e6,
+         RUN_SECTORS*512/1e6/t[0],RUN_SECTORS*512/1e6/t[1],bad ? " (MISMATCH)" : "");
+}
+
+static void read_done(void *context, int /*result*/)
+{
+  (*(int *)context)++;
+}
+
+// background reads of 8 sectors, polled the way a game loop would; on the
+// host the data blocks go through the FIFO path inside read_poll(), on the
+// LPC1768 the GPDMA moves them between polls
+static void background_read()
+{
+  std::vector<uint8_t> buf(8*512);
+  unsigned long long polls=0;
+  double t0=spi_host_stats.seconds,t,longest=0;
+  int bad=0,done=0;
+
+  for (unsigned s=0;s<RUN_SECTORS;s+=8) {
+    if (sd.read_start(&buf[0],s,8,read_done,&done)) {
+      bad++;
+      continue;
+    }
+    int r;
+    do {
+      t=spi_host_stats.seconds;
+      r=sd.read_poll();
+      polls++;
+      if (spi_host_stats.seconds-t > longest)
+        longest=spi_host_stats.seconds-t;
+    } while (r == 1);
+    if (r || memcmp(&buf[0],&card.image[s*512],buf.size()))
+      bad++;
+  }
+  t=spi_host_stats.seconds-t0;
+  printf("background read: %.2f MB/s, %.1f polls per sector, longest poll %.0f us%s\n",
+         RUN_SECTORS*512/1e6/t,(double)polls/RUN_SECTORS,longest*1e6,
+         bad || done != RUN_SECTORS/8 ? " (MISMATCH)" : "");
+}
+
+int main(int argc, char **argv)
+{
+  static const unsigned counts[]={1,2,4,8,16,32,64};
+  unsigned cs,cm,k,i;
+  int bad=0;
+  double ts,tm;
+
+  for (i=0;i<card.image.size();i++)
+    card.image[i]=(uint8_t)(i*7+(i >> 9));
+  sd.hz=argc > 1 ? atoi(argv[1]) : 0;
+  if (sd.disk_initialize()) {
+    printf("disk_initialize failed\n");
+    return 1;
+  }
+  printf("SD card model: read access %u us, next block %u us, write %u/%u us\n",
+         card.timing.read_access_us,card.timing.read_next_us,
+         card.timing.write_single_us,card.timing.write_multi_us);
+  printf("bus clock %d Hz\n\n",card.clock());
+
+  for (int write=0;write<2;write++) {
+    printf("%s  sectors | CMD%d per sector       | CMD%d            | speedup\n",
+           write ? "write" : "read ",write ? 24 : 17,write ? 25 : 18);
+    printf("  per call | us/sector  KB/s  cmds | us/sector  KB/s  cmds |\n");
+    for (k=0;k<sizeof(counts)/sizeof(counts[0]);k++) {
+      sd.multi=0;
+      ts=run(write,counts[k],&cs,&bad);
+      sd.multi=1;
+      tm=run(write,counts[k],&cm,&bad);
+      printf("  %6u   | %8.0f %6.1f %5u | %8.0f %6.1f %5u | %5.2fx\n",counts[k],
+             ts*1e6/RUN_SECTORS,RUN_SECTORS/2.0/ts,cs,
+             tm*1e6/RUN_SECTORS,RUN_SECTORS/2.0/tm,cm,ts/tm);
+    }
+    printf("\n");
+  }
+
+// FatFs only asks for several sectors at once when a request covers whole
+// sectors of a cluster, so format with the 8KB clusters an SD card would use
+  if (f_mkfs(0,0,8192)) {
+    printf("f_mkfs failed\n");
+    return 1;
+  }
+  for (sd.multi=0;sd.multi<2;sd.multi++) {
+    printf("FatFs 256KB file, %s\n",sd.multi ? "multiple block commands" : "one command per sector");
+    printf("   chunk  | write KB/s  read KB/s\n");
+    file_test(512);
+    file_test(4096);
+    file_test(32768);
+  }
+
+  int hz=card.clock();
+  seq_read(1000000);
+  seq_read(hz);
+  background_read();
+
+  if (bad) {
+    printf("%d transfers did not match the card image\n",bad);
+    return 1;
+  }
+  return 0;
+}
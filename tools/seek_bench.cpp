@@ -0,0 +1,152 @@
+//-----------------------------------------------------------------------------
+// seek_bench -- host benchmark for FatFs fast seek on a large asset file.
+// Formats the SD card model in tools/host, writes a fragmented pack file and
+// then does random seek plus small read lookups through FATFileHandle, the
+// way sprite and audio packs are read, with and without the cluster link map
+// built by FATFileHandle::fast_seek().  Reports SPI bus time, card sectors
+// read and host CPU time per lookup; every read is checked.
+//
+// Build on the host:
+//   g++ -O2 -I tools/host -I SDFileSystem -I SDFileSystem/FATFileSystem
+//     -I SDFileSystem/FATFileSystem/ChaN -o seek_bench tools/seek_bench.cpp
+//     tools/host/mbed_host.cpp tools/host/sd_card_sim.cpp
+//     SDFileSystem/SDFileSystem.cpp SDFileSystem/FATFileSystem/*.cpp
+//     SDFileSystem/FATFileSystem/ChaN/*.cpp
+//
+// Usage:
+//   seek_bench [cluster_bytes] [pack_kb] [lookups]
+//     Small clusters make long chains; a card formatted with 512 byte
+//     clusters is the worst case for the normal seek.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+#include "SDFileSystem.h"
+#include "FATFileHandle.h"
+#include "sd_card_sim.h"
+#include "ff.h"
+
+#define CARD_BLOCKS 65536        // 32MB
+#define LOOKUP_BYTES 16
+
+static sd_card_sim card(CARD_BLOCKS);
+static SDFileSystem sd(p5,p6,p7,p8,"sd");
+static double map_seconds;
+static unsigned map_sectors;
+
+static double now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec+ts.tv_nsec*1e-9;
+}
+
+static inline uint8_t pack_byte(unsigned offset)
+{
+  return (uint8_t)(offset*13+(offset >> 11));
+}
+
+// write the pack a few clusters at a time, with a filler file growing in
+// between, so its chain is fragmented like a card that has seen some use
+static int write_pack(unsigned size, unsigned cluster)
+{
+  std::vector<uint8_t> buf(cluster*4);
+  FIL pack,filler;
+  UINT n;
+  unsigned off=0,i;
+
+  if (f_open(&pack,"0:/pack.bin",FA_WRITE | FA_CREATE_ALWAYS) ||
+      f_open(&filler,"0:/filler.bin",FA_WRITE | FA_CREATE_ALWAYS))
+    return 1;
+  while (off < size) {
+    unsigned len=size-off < buf.size() ? size-off : buf.size();
+    for (i=0;i<len;i++)
+      buf[i]=pack_byte(off+i);
+    if (f_write(&pack,&buf[0],len,&n) || n != len)
+      return 1;
+    off+=len;
+    if (f_write(&filler,&buf[0],cluster,&n) || f_sync(&pack))
+      return 1;
+  }
+  f_close(&filler);
+  return f_close(&pack) != FR_OK;
+}
+
+// random lookups; the same seed for both runs
+static void lookups(int fast, unsigned size, unsigned count, int *bad)
+{
+  FATFileHandle *h=(FATFileHandle *)sd.open("pack.bin",O_RDONLY);
+  uint8_t buf[LOOKUP_BYTES];
+  double t0,bus0,c0;
+  unsigned b0,i,j;
+
+  if (!h) {
+    printf("open failed\n");
+    (*bad)++;
+    return;
+  }
+  if (fast) {
+    b0=card.stats.blocks_read;
+    bus0=spi_host_stats.seconds;
+    if (h->fast_seek()) {
+      printf("fast_seek failed\n");
+      (*bad)++;
+    }
+    map_seconds=spi_host_stats.seconds-bus0;
+    map_sectors=card.stats.blocks_read-b0;
+  }
+
+  srand(1);
+  t0=now();
+  bus0=spi_host_stats.seconds;
+  b0=card.stats.blocks_read;
+  for (i=0;i<count;i++) {
+    unsigned off=(unsigned)(((unsigned long long)rand()*rand()) % (size-LOOKUP_BYTES));
+    if (h->lseek(off,SEEK_SET) != (off_t)off || h->read(buf,LOOKUP_BYTES) != LOOKUP_BYTES) {
+      (*bad)++;
+      continue;
+    }
+    for (j=0;j<LOOKUP_BYTES;j++)
+      if (buf[j] != pack_byte(off+j)) {
+        (*bad)++;
+        break;
+      }
+  }
+  c0=now()-t0;
+  printf("  %-10s | %9.0f  %9.2f  %9.1f\n",fast ? "fast seek" : "normal",
+         (spi_host_stats.seconds-bus0)*1e6/count,
+         (double)(card.stats.blocks_read-b0)/count,c0*1e6/count);
+  h->close();
+}
+
+int main(int argc, char **argv)
+{
+  unsigned cluster=argc > 1 ? atoi(argv[1]) : 512;
+  unsigned size=(argc > 2 ? atoi(argv[2]) : 4096)*1024;
+  unsigned count=argc > 3 ? atoi(argv[3]) : 2000;
+  int bad=0;
+
+  if (f_mkfs(0,0,cluster)) {
+    printf("f_mkfs failed\n");
+    return 1;
+  }
+  if (write_pack(size,cluster)) {
+    printf("writing the pack failed\n");
+    return 1;
+  }
+  printf("%u KB pack, %u byte clusters (%u in the chain), %u lookups of %d bytes\n",
+         size/1024,cluster,(size+cluster-1)/cluster,count,LOOKUP_BYTES);
+  printf("             | bus us     sectors    host CPU us\n");
+  lookups(0,size,count,&bad);
+  lookups(1,size,count,&bad);
+  printf("building the link map took %.1f ms bus time, %u sectors\n",
+         map_seconds*1e3,map_sectors);
+
+  if (bad) {
+    printf("%d lookups did not match the pack\n",bad);
+    return 1;
+  }
+  return 0;
+}
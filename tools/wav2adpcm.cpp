@@ -0,0 +1,157 @@
+//-----------------------------------------------------------------------------
+// wav2adpcm -- offline encoder that turns 16 bit PCM wave files into
+// IMA-ADPCM (compression code 0x11) wave files playable by wave_player.
+//
+// Build on the host:
+//   g++ -O2 -I wave_player -o wav2adpcm tools/wav2adpcm.cpp wave_player/ima_adpcm.cpp
+//
+// Usage:
+//   wav2adpcm [-m] [-b block_align] in.wav out.wav
+//     -m  mix stereo down to mono (wave_player averages channels anyway)
+//     -b  block size in bytes per channel (default 256, multiple of 4)
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "ima_adpcm.h"
+
+static unsigned get_le(const unsigned char *p, int n)
+{
+  unsigned v=0;
+  for (int i=n-1;i>=0;i--)
+    v=(v<<8) | p[i];
+  return v;
+}
+
+static void put_le(FILE *fp, unsigned v, int n)
+{
+  for (int i=0;i<n;i++) {
+    fputc(v & 0xff,fp);
+    v>>=8;
+  }
+}
+
+static void usage()
+{
+  fprintf(stderr,"usage: wav2adpcm [-m] [-b block_align] in.wav out.wav\n");
+  exit(1);
+}
+
+int main(int argc, char **argv)
+{
+  int mono=0;
+  int block_per_channel=256;
+  int argi=1;
+
+  while (argi < argc && argv[argi][0]=='-') {
+    if (!strcmp(argv[argi],"-m"))
+      mono=1;
+    else if (!strcmp(argv[argi],"-b") && argi+1 < argc)
+      block_per_channel=atoi(argv[++argi]);
+    else
+      usage();
+    argi++;
+  }
+  if (argc-argi != 2 || block_per_channel < 8 || block_per_channel % 4)
+    usage();
+
+  FILE *in=fopen(argv[argi],"rb");
+  if (!in) {
+    fprintf(stderr,"cannot open %s\n",argv[argi]);
+    return 1;
+  }
+
+// walk the RIFF chunks looking for fmt and data
+  unsigned char hdr[12],fmt[16];
+  unsigned channels=0,rate=0,bits=0,format=0;
+  std::vector<short> pcm;
+  if (fread(hdr,12,1,in) != 1 || memcmp(hdr,"RIFF",4) || memcmp(hdr+8,"WAVE",4)) {
+    fprintf(stderr,"%s is not a wave file\n",argv[argi]);
+    return 1;
+  }
+  while (fread(hdr,8,1,in) == 1) {
+    unsigned size=get_le(hdr+4,4);
+    if (!memcmp(hdr,"fmt ",4) && size >= 16) {
+      fread(fmt,16,1,in);
+      format=get_le(fmt,2);
+      channels=get_le(fmt+2,2);
+      rate=get_le(fmt+4,4);
+      bits=get_le(fmt+14,2);
+      fseek(in,size-16+(size&1),SEEK_CUR);
+    }
+    else if (!memcmp(hdr,"data",4)) {
+      if (format != WAVE_FORMAT_PCM || bits != 16 || channels < 1 || channels > 2) {
+        fprintf(stderr,"only 16 bit mono or stereo PCM input is supported\n");
+        return 1;
+      }
+      pcm.resize(size/2);
+      pcm.resize(fread(&pcm[0],2,pcm.size(),in));
+      break;
+    }
+    else
+      fseek(in,size+(size&1),SEEK_CUR);
+  }
+  fclose(in);
+  if (pcm.empty()) {
+    fprintf(stderr,"no data chunk found\n");
+    return 1;
+  }
+
+  if (mono && channels == 2) {
+    for (size_t i=0;i<pcm.size()/2;i++)
+      pcm[i]=(short)((pcm[2*i]+pcm[2*i+1])/2);
+    pcm.resize(pcm.size()/2);
+    channels=1;
+  }
+
+  int block_align=block_per_channel*channels;
+  int spb=ima_adpcm_samples_per_block(block_align,channels);
+  unsigned total=pcm.size()/channels;
+  unsigned num_blocks=(total+spb-1)/spb;
+  unsigned data_size=num_blocks*block_align;
+
+// the last block is padded by repeating the final sample
+  pcm.resize((size_t)num_blocks*spb*channels,pcm[pcm.size()-1]);
+
+  FILE *out=fopen(argv[argi+1],"wb");
+  if (!out) {
+    fprintf(stderr,"cannot create %s\n",argv[argi+1]);
+    return 1;
+  }
+  fwrite("RIFF",4,1,out);
+  put_le(out,4+(8+20)+(8+4)+(8+data_size),4);
+  fwrite("WAVE",4,1,out);
+
+  fwrite("fmt ",4,1,out);
+  put_le(out,20,4);
+  put_le(out,WAVE_FORMAT_IMA_ADPCM,2);
+  put_le(out,channels,2);
+  put_le(out,rate,4);
+  put_le(out,(unsigned)((unsigned long long)rate*block_align/spb),4);
+  put_le(out,block_align,2);
+  put_le(out,4,2);                  // bits per sample
+  put_le(out,2,2);                  // cbSize
+  put_le(out,spb,2);
+
+  fwrite("fact",4,1,out);
+  put_le(out,4,4);
+  put_le(out,total,4);
+
+  fwrite("data",4,1,out);
+  put_le(out,data_size,4);
+
+  IMA_ADPCM_STATE state[2];
+  memset(state,0,sizeof(state));
+  std::vector<unsigned char> block(block_align);
+  for (unsigned b=0;b<num_blocks;b++) {
+    ima_adpcm_encode_block(&pcm[(size_t)b*spb*channels],channels,block_align,state,&block[0]);
+    fwrite(&block[0],block_align,1,out);
+  }
+  fclose(out);
+
+  printf("%u samples, %u channel(s), %u Hz: %u PCM bytes -> %u ADPCM bytes (%u blocks of %d)\n",
+         total,channels,rate,total*channels*2,data_size,num_blocks,block_align);
+  return 0;
+}
@@ -0,0 +1,111 @@
+//-----------------------------------------------------------------------------
+// Ping-pong buffer bookkeeping for dac_dma.  See dac_dma.h.
+//
+// filled counts the halves handed to the DMA and done counts the halves it
+// has drained.  Half n lives in buf[n & 1].  The producer may write half
+// 'filled' once filled-done < 2, i.e. once the DMA has moved past it.
+//-----------------------------------------------------------------------------
+
+#include "dac_dma.h"
+
+static uint32_t dma_buf[2][DAC_DMA_HALF] DMA_RAM;
+
+dac_dma::dac_dma()
+{
+  buf=dma_buf;
+  refill=0;
+  context=0;
+  rate=0;
+  filled=0;
+  done=0;
+  underruns=0;
+  running=0;
+  finishing=0;
+}
+
+uint32_t *dac_dma::begin(unsigned r)
+{
+  rate=r;
+  refill=0;
+  filled=0;
+  done=0;
+  underruns=0;
+  running=0;
+  finishing=0;
+  return buf[0];
+}
+
+uint32_t *dac_dma::swap(void)
+{
+  filled++;
+  if (!running && filled==2) {
+    running=1;
+    hw_start();
+  }
+// after an underrun the DMA is already replaying half 'filled'; skip ahead
+// so the producer writes the half after it
+  if ((int)(filled-done) < 1)
+    filled=done+1;
+  while ((int)(filled-done) >= 2)
+    hw_wait();
+  return buf[filled & 1];
+}
+
+void dac_dma::finish(uint32_t *cur, int used, unsigned short idle)
+{
+  int i;
+  for (i=used;i<DAC_DMA_HALF;i++)
+    cur[i]=to_dacr(idle);
+  filled++;
+  if (filled==1) {
+// a stream shorter than one half; let the second half repeat the idle level
+    for (i=0;i<DAC_DMA_HALF;i++)
+      buf[1][i]=to_dacr(idle);
+  }
+  finishing=1;
+  if (!running) {
+    running=1;
+    hw_start();
+  }
+  while ((int)(filled-done) > 0)
+    hw_wait();
+  hw_stop();
+  running=0;
+}
+
+void dac_dma::start(unsigned r, void (*fill)(void *context, uint32_t *half), void *ctx)
+{
+  rate=r;
+  refill=fill;
+  context=ctx;
+  filled=0;
+  done=0;
+  underruns=0;
+  finishing=0;
+  refill(context,buf[0]);
+  refill(context,buf[1]);
+  running=1;
+  hw_start();
+}
+
+void dac_dma::stop(void)
+{
+  if (running)
+    hw_stop();
+  running=0;
+  refill=0;
+}
+
+void dac_dma::half_done(void)
+{
+  done++;
+// the DMA is playing half 'done'; the one it just left is next after that
+  if (refill) {
+    refill(context,buf[(done+1) & 1]);
+    return;
+  }
+// the DMA has moved on to half 'done'; if it was never refilled the old
+// samples are played again
+  if (done >= filled && !finishing)
+    underruns++;
+}
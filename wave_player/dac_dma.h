@@ -0,0 +1,97 @@
+//-----------------------------------------------------------------------------
+// Ping-pong DMA output for the LPC1768 DAC.
+//
+// The DAC's own counter times the samples and requests a GPDMA transfer for
+// each one, so there is no per-sample interrupt.  Two half buffers are
+// chained with linked list items; the DMA interrupt fires only when a half
+// has drained and can be refilled.
+//
+// dac_dma.cpp holds the buffer bookkeeping and has no mbed dependencies.
+// The register level part lives in dac_dma_lpc17xx.cpp; on the host,
+// tools/host/dac_dma_host.cpp stands in for it and drains the halves at the
+// programmed rate, so the refill logic can be exercised off target.
+//-----------------------------------------------------------------------------
+#ifndef DAC_DMA_H
+#define DAC_DMA_H
+
+#include <stdint.h>
+
+// samples per half buffer; 256 is 16ms at 16kHz
+#define DAC_DMA_HALF 256
+
+// the GPDMA cannot reach the CPU's local SRAM, so DMA buffers and linked
+// list items go in the AHB SRAM bank (see LPC1768.sct)
+#if defined(__ARMCC_VERSION)
+#define DMA_RAM __attribute__((section("AHBSRAM0")))
+#else
+#define DMA_RAM
+#endif
+
+class dac_dma {
+
+public:
+dac_dma();
+
+/** Prepare for a new stream.  Nothing is output until two halves are full.
+ *
+ * @param rate output sample rate in Hz
+ * @return the first half buffer to fill
+ */
+uint32_t *begin(unsigned rate);
+
+/** Hand over a full half buffer and get the next one to fill.  Starts the
+ * DMA once both halves hold data, then waits for a half to drain.
+ *
+ * @return the next half buffer to fill
+ */
+uint32_t *swap(void);
+
+/** Pad the partly filled half with idle, play out what is queued and stop.
+ *
+ * @param cur the half buffer returned by the last begin()/swap()
+ * @param used number of samples already written to cur
+ * @param idle DAC value to pad with
+ */
+void finish(uint32_t *cur, int used, unsigned short idle);
+
+/** Run without a producer waiting in swap().  refill is called for both
+ * halves before output starts, then from the DMA interrupt each time a half
+ * has drained; it must fill all DAC_DMA_HALF samples.
+ *
+ * @param rate output sample rate in Hz
+ * @param refill fills one half buffer with DACR values
+ * @param context passed to refill
+ */
+void start(unsigned rate, void (*refill)(void *context, uint32_t *half), void *context);
+
+/** Stop output begun with start(). */
+void stop(void);
+
+/** Called from the DMA interrupt each time a half buffer has drained. */
+void half_done(void);
+
+/** Convert an unsigned 16 bit sample to the DACR register format. */
+static inline uint32_t to_dacr(unsigned short sample) { return sample & 0xffc0; }
+
+/// Number of halves the DMA has replayed because they were not refilled in time
+unsigned get_underruns(void) { return underruns; }
+/// Number of DMA interrupts during the last stream
+unsigned get_interrupts(void) { return done; }
+
+private:
+void hw_start(void);
+void hw_stop(void);
+void hw_wait(void);          // idle until the next interrupt
+
+uint32_t (*buf)[DAC_DMA_HALF];
+void (*refill)(void *context, uint32_t *half);
+void *context;
+unsigned rate;
+volatile unsigned filled;    // halves handed to the DMA
+volatile unsigned done;      // halves the DMA has drained
+volatile unsigned underruns;
+volatile int running;
+volatile int finishing;
+};
+
+#endif
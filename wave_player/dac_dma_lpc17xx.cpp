@@ -0,0 +1,106 @@
+//-----------------------------------------------------------------------------
+// LPC1768 register level part of dac_dma.  See dac_dma.h.
+//
+// The DAC counter (DACCNTVAL, clocked by PCLK_DAC) paces the output and
+// raises a DMA request per sample.  GPDMA channel DAC_DMA_CHANNEL moves one
+// 32 bit word from the current half buffer to DACR per request, following
+// two linked list items that point at each other.  Each item raises the
+// terminal count interrupt when its half is done.
+//-----------------------------------------------------------------------------
+
+#include <mbed.h>
+#include "dac_dma.h"
+
+#define DAC_DMA_CHANNEL     7        // lowest priority channel
+#define DAC_DMA_CH          LPC_GPDMACH7
+#define DMA_PERIPH_DAC      7        // DMA request line of the DAC
+
+// DMACCControl fields
+#define DMA_CTRL_WORD_SRC   (2 << 18)
+#define DMA_CTRL_WORD_DST   (2 << 21)
+#define DMA_CTRL_SRC_INC    (1 << 26)
+#define DMA_CTRL_TC_INT     (1u << 31)
+
+// DMACCConfig fields
+#define DMA_CFG_ENABLE      (1 << 0)
+#define DMA_CFG_M2P         (1 << 11)
+#define DMA_CFG_IE          (1 << 14)
+#define DMA_CFG_ITC         (1 << 15)
+
+// DACCTRL fields
+#define DAC_DBLBUF_ENA      (1 << 1)
+#define DAC_CNT_ENA         (1 << 2)
+#define DAC_DMA_ENA         (1 << 3)
+
+typedef struct {
+  uint32_t src;
+  uint32_t dst;
+  uint32_t next;
+  uint32_t control;
+} DMA_LLI;
+
+static DMA_LLI lli[2] DMA_RAM;
+static dac_dma *active;
+
+static void dac_dma_irq(void)
+{
+  if (LPC_GPDMA->DMACIntErrStat & (1 << DAC_DMA_CHANNEL))
+    LPC_GPDMA->DMACIntErrClr=1 << DAC_DMA_CHANNEL;
+  if (LPC_GPDMA->DMACIntTCStat & (1 << DAC_DMA_CHANNEL)) {
+    LPC_GPDMA->DMACIntTCClear=1 << DAC_DMA_CHANNEL;
+    if (active)
+      active->half_done();
+  }
+}
+
+void dac_dma::hw_start(void)
+{
+  static const int pclk_div[4]={4,1,2,8};
+  uint32_t control;
+  uint32_t pclk;
+
+  active=this;
+  LPC_SC->PCONP|=1 << 29;                  // power up the GPDMA
+  LPC_GPDMA->DMACConfig=1;                 // enable, little endian
+  LPC_GPDMA->DMACIntTCClear=1 << DAC_DMA_CHANNEL;
+  LPC_GPDMA->DMACIntErrClr=1 << DAC_DMA_CHANNEL;
+
+  control=DAC_DMA_HALF | DMA_CTRL_WORD_SRC | DMA_CTRL_WORD_DST | DMA_CTRL_SRC_INC | DMA_CTRL_TC_INT;
+  lli[0].src=(uint32_t)buf[0];
+  lli[0].dst=(uint32_t)&LPC_DAC->DACR;
+  lli[0].next=(uint32_t)&lli[1];
+  lli[0].control=control;
+  lli[1].src=(uint32_t)buf[1];
+  lli[1].dst=(uint32_t)&LPC_DAC->DACR;
+  lli[1].next=(uint32_t)&lli[0];
+  lli[1].control=control;
+
+  DAC_DMA_CH->DMACCSrcAddr=lli[0].src;
+  DAC_DMA_CH->DMACCDestAddr=lli[0].dst;
+  DAC_DMA_CH->DMACCLLI=lli[0].next;
+  DAC_DMA_CH->DMACCControl=lli[0].control;
+
+  NVIC_SetVector(DMA_IRQn,(uint32_t)&dac_dma_irq);
+  NVIC_EnableIRQ(DMA_IRQn);
+
+  DAC_DMA_CH->DMACCConfig=(DMA_PERIPH_DAC << 6) | DMA_CFG_M2P | DMA_CFG_IE | DMA_CFG_ITC | DMA_CFG_ENABLE;
+
+// the DAC counter reloads from DACCNTVAL at PCLK_DAC
+  pclk=SystemCoreClock/pclk_div[(LPC_SC->PCLKSEL0 >> 22) & 3];
+  LPC_DAC->DACCNTVAL=pclk/rate;
+  LPC_DAC->DACCTRL=DAC_DBLBUF_ENA | DAC_CNT_ENA | DAC_DMA_ENA;
+}
+
+void dac_dma::hw_stop(void)
+{
+  LPC_DAC->DACCTRL=0;
+  DAC_DMA_CH->DMACCConfig&=~DMA_CFG_ENABLE;
+  LPC_GPDMA->DMACIntTCClear=1 << DAC_DMA_CHANNEL;
+  active=0;
+}
+
+void dac_dma::hw_wait(void)
+{
+// the DMA interrupt (or any other) wakes the core
+  __WFI();
+}
@@ -0,0 +1,152 @@
+//-----------------------------------------------------------------------------
+// IMA-ADPCM codec.  See ima_adpcm.h.
+//
+// A block starts with one 4 byte header per channel:
+//   int16 first sample, uint8 step index, uint8 reserved
+// followed by groups of 4 bytes (8 samples) per channel, interleaved channel
+// by channel.  Within a byte the low nibble is the earlier sample.
+//-----------------------------------------------------------------------------
+
+#include "ima_adpcm.h"
+
+static const short step_table[89] = {
+      7,     8,     9,    10,    11,    12,    13,    14,    16,    17,
+     19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+     50,    55,    60,    66,    73,    80,    88,    97,   107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+    337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+    876,   963,  1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+   2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+   5894,  6484,  7132,  7845,  8630,  9493, 10442, 11487, 12635, 13899,
+  15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const signed char index_table[16] = {
+  -1, -1, -1, -1, 2, 4, 6, 8,
+  -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+// expand one 4 bit code and advance the channel state
+static inline short decode_nibble(IMA_ADPCM_STATE *s, unsigned char nibble)
+{
+  int step=step_table[s->index];
+  int diff=step>>3;
+  int pred=s->predictor;
+  int index=s->index+index_table[nibble];
+
+  if (nibble & 4) diff+=step;
+  if (nibble & 2) diff+=step>>1;
+  if (nibble & 1) diff+=step>>2;
+  if (nibble & 8)
+    pred-=diff;
+  else
+    pred+=diff;
+
+  if (pred > 32767) pred=32767;
+  else if (pred < -32768) pred=-32768;
+  if (index < 0) index=0;
+  else if (index > 88) index=88;
+
+  s->predictor=(short)pred;
+  s->index=(unsigned char)index;
+  return s->predictor;
+}
+
+// quantise one sample, then run the decoder so both sides stay in step
+static inline unsigned char encode_sample(IMA_ADPCM_STATE *s, short sample)
+{
+  int step=step_table[s->index];
+  int diff=sample-s->predictor;
+  unsigned char nibble=0;
+
+  if (diff < 0) {
+    nibble=8;
+    diff=-diff;
+  }
+  if (diff >= step) {
+    nibble|=4;
+    diff-=step;
+  }
+  step>>=1;
+  if (diff >= step) {
+    nibble|=2;
+    diff-=step;
+  }
+  step>>=1;
+  if (diff >= step)
+    nibble|=1;
+
+  decode_nibble(s,nibble);
+  return nibble;
+}
+
+int ima_adpcm_samples_per_block(int block_align, int num_channels)
+{
+  if (num_channels < 1 || block_align < 4*num_channels)
+    return 0;
+  if ((block_align-4*num_channels) % (4*num_channels))
+    return 0;
+  return (block_align-4*num_channels)*2/num_channels+1;
+}
+
+int ima_adpcm_decode_block(const unsigned char *block, int block_align,
+                           int num_channels, short *out)
+{
+  IMA_ADPCM_STATE state[2];
+  int samples=ima_adpcm_samples_per_block(block_align,num_channels);
+  int ch,i,j;
+
+  if (samples == 0 || num_channels > 2)
+    return 0;
+
+  for (ch=0;ch<num_channels;ch++) {
+    state[ch].predictor=(short)(block[0] | (block[1]<<8));
+    state[ch].index=block[2];
+    if (state[ch].index > 88)
+      return 0;
+    out[ch]=state[ch].predictor;
+    block+=4;
+  }
+
+// every channel contributes 4 bytes = 8 samples per group
+  for (i=1;i<samples;i+=8) {
+    for (ch=0;ch<num_channels;ch++) {
+      short *dst=out+i*num_channels+ch;
+      for (j=0;j<4;j++) {
+        unsigned char b=*block++;
+        dst[0]=decode_nibble(&state[ch],b & 0x0f);
+        dst[num_channels]=decode_nibble(&state[ch],b >> 4);
+        dst+=2*num_channels;
+      }
+    }
+  }
+  return samples;
+}
+
+void ima_adpcm_encode_block(const short *in, int num_channels, int block_align,
+                            IMA_ADPCM_STATE *state, unsigned char *block)
+{
+  int samples=ima_adpcm_samples_per_block(block_align,num_channels);
+  int ch,i,j;
+
+  for (ch=0;ch<num_channels;ch++) {
+    state[ch].predictor=in[ch];
+    block[0]=(unsigned char)(in[ch] & 0xff);
+    block[1]=(unsigned char)((in[ch] >> 8) & 0xff);
+    block[2]=state[ch].index;
+    block[3]=0;
+    block+=4;
+  }
+
+  for (i=1;i<samples;i+=8) {
+    for (ch=0;ch<num_channels;ch++) {
+      const short *src=in+i*num_channels+ch;
+      for (j=0;j<4;j++) {
+        unsigned char lo=encode_sample(&state[ch],src[0]);
+        unsigned char hi=encode_sample(&state[ch],src[num_channels]);
+        *block++=(unsigned char)(lo | (hi << 4));
+        src+=2*num_channels;
+      }
+    }
+  }
+}
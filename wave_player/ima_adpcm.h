@@ -0,0 +1,58 @@
+//-----------------------------------------------------------------------------
+// IMA-ADPCM (DVI ADPCM, wave format code 0x11) codec used by wave_player.
+//
+// This file has no mbed dependencies so that the offline encoder and the
+// host benchmarks in tools/ can share it with the player.
+//
+// explanation of the block layout.
+// http://wiki.multimedia.cx/index.php?title=Microsoft_IMA_ADPCM
+//-----------------------------------------------------------------------------
+#ifndef IMA_ADPCM_H
+#define IMA_ADPCM_H
+
+#define WAVE_FORMAT_PCM       0x0001
+#define WAVE_FORMAT_IMA_ADPCM 0x0011
+
+/** Per-channel decoder/encoder state. */
+typedef struct {
+  short predictor;       ///< last output sample
+  unsigned char index;   ///< index into the step size table (0..88)
+} IMA_ADPCM_STATE;
+
+/** Number of samples per channel held by a block of block_align bytes.
+ *
+ * Each channel has a 4 byte header holding the first sample, followed by
+ * 4 bits for every following sample.
+ *
+ * @param block_align size of one block in bytes
+ * @param num_channels number of interleaved channels
+ * @return samples per channel, 0 if block_align is not a valid block size
+ */
+int ima_adpcm_samples_per_block(int block_align, int num_channels);
+
+/** Decode one block.
+ *
+ * @param block pointer to block_align bytes of ADPCM data
+ * @param block_align size of the block in bytes
+ * @param num_channels number of interleaved channels
+ * @param out receives samples_per_block*num_channels interleaved samples
+ * @return number of samples per channel written to out, 0 on a bad block
+ */
+int ima_adpcm_decode_block(const unsigned char *block, int block_align,
+                           int num_channels, short *out);
+
+/** Encode one block.
+ *
+ * The channel states carry the predictor across blocks; they may be zeroed
+ * before the first block.
+ *
+ * @param in samples_per_block*num_channels interleaved 16 bit samples
+ * @param num_channels number of interleaved channels
+ * @param block_align size of the block to produce in bytes
+ * @param state array of num_channels encoder states
+ * @param block receives block_align bytes of ADPCM data
+ */
+void ima_adpcm_encode_block(const short *in, int num_channels, int block_align,
+                            IMA_ADPCM_STATE *state, unsigned char *block);
+
+#endif
@@ -0,0 +1,53 @@
+//-----------------------------------------------------------------------------
+// Linear interpolating sample rate converter used by wave_player to run the
+// DAC at a fixed output rate regardless of the wave file's sample rate.
+//
+// The position between the two most recent input samples is kept as a 16.16
+// fixed point phase.  After each resampler_push() call resampler_pop()
+// until it returns 0; every call that returns 1 produces one output sample.
+//
+// There is no anti-aliasing filter, so content above half the output rate
+// folds back when downsampling.  Game sound effects are encoded at 22 kHz or
+// less, so little is lost at the default 16 kHz output rate.
+//
+// No mbed dependencies; also built by the host tools.
+//-----------------------------------------------------------------------------
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#define RESAMPLER_ONE 0x10000
+
+typedef struct {
+  unsigned step;     // input samples per output sample, 16.16
+  unsigned phase;    // position after prev, 16.16
+  int prev;
+  int cur;
+} RESAMPLER;
+
+static inline void resampler_init(RESAMPLER *r, unsigned in_rate, unsigned out_rate, int idle)
+{
+  r->step=(unsigned)(((unsigned long long)in_rate << 16)/out_rate);
+  r->phase=0;
+  r->prev=idle;
+  r->cur=idle;
+}
+
+static inline void resampler_push(RESAMPLER *r, int sample)
+{
+  r->prev=r->cur;
+  r->cur=sample;
+}
+
+static inline int resampler_pop(RESAMPLER *r, int *out)
+{
+  if (r->phase >= RESAMPLER_ONE) {
+    r->phase-=RESAMPLER_ONE;
+    return 0;
+  }
+// 12 bit fraction keeps the product inside 32 bits for 16 bit samples
+  *out=r->prev+(((r->cur-r->prev)*(int)(r->phase >> 4)) >> 12);
+  r->phase+=r->step;
+  return 1;
+}
+
+#endif
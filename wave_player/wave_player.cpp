@@ -13,7 +13,9 @@
 
 #include <mbed.h>
 #include <stdio.h>
+#include <string.h>
 #include <wave_player.h>
+#include "ima_adpcm.h"
 
 
 //-----------------------------------------------------------------------------
@@ -23,6 +25,17 @@ wave_player::wave_player(AnalogOut *_dac)
   wave_DAC=_dac;
   wave_DAC->write_u16(32768);        //DAC is 0-3.3V, so idles at ~1.6V
   verbosity=0;
+  out_rate=WAVE_OUTPUT_RATE;
+#if WAVE_PLAYER_DMA
+  DMA_buf=0;
+#endif
+  streaming=0;
+  stream_buf=0;
+  stream_pcm=0;
+  memset(&stream_stats,0,sizeof(stream_stats));
+  isr_calls=0;
+  isr_us=0;
+  play_us=0;
 }
 
 //-----------------------------------------------------------------------------
@@ -38,33 +51,35 @@ void wave_player::set_verbosity(int v)
 }
 
 //-----------------------------------------------------------------------------
-// player function.  Takes a pointer to an opened wave file.  The file needs
-// to be stored in a filesystem with enough bandwidth to feed the wave data.
-// LocalFileSystem isn't, but the SDcard is, at least for 22kHz files.  The
-// SDcard filesystem can be hotrodded by increasing the SPI frequency it uses
-// internally.
+// the DAC is driven at a fixed rate and files are resampled to it.  Setting
+// the rate to 0 restores the old behaviour of ticking at the file's own rate.
 //-----------------------------------------------------------------------------
-void wave_player::play(FILE *wavefile)
+void wave_player::set_output_rate(unsigned hz)
 {
-        unsigned chunk_id,chunk_size,channel;
-        unsigned data,samp_int,i;
-        short unsigned dac_data;
-        long long slice_value;
-        char *slice_buf;
-        short *data_sptr;
-        unsigned char *data_bptr;
-        int *data_wptr;
-        FMT_STRUCT wav_format;
-        long slice,num_slices;
-  DAC_wptr=0;
-  DAC_rptr=0;
-  for (i=0;i<256;i+=2) {
-    DAC_fifo[i]=0;
-    DAC_fifo[i+1]=3000;
-  }
-  DAC_wptr=4;
-  DAC_on=0;
+  out_rate=hz;
+}
+
+//-----------------------------------------------------------------------------
+// DAC interrupt statistics gathered during the last play().  busy_us/play_us
+// is the share of the CPU taken by the sample ISR (not counting interrupt
+// entry and the Ticker's own bookkeeping).
+//-----------------------------------------------------------------------------
+void wave_player::get_isr_stats(unsigned *calls, unsigned *busy_us, unsigned *p_us)
+{
+  *calls=isr_calls;
+  *busy_us=isr_us;
+  *p_us=play_us;
+}
 
+//-----------------------------------------------------------------------------
+// read chunks up to the next data chunk, picking up the format and fact
+// chunks on the way.  Returns the size of the data chunk with the file
+// positioned at its first byte, or 0 at the end of the file.
+//-----------------------------------------------------------------------------
+unsigned wave_player::next_data_chunk(FILE *wavefile)
+{
+        unsigned chunk_id,chunk_size,data;
+        unsigned short adpcm_ext[2];
   fread(&chunk_id,4,1,wavefile);
   fread(&chunk_size,4,1,wavefile);
   while (!feof(wavefile)) {
@@ -91,121 +106,495 @@ void wave_player::play(FILE *wavefile)
           printf("  block align %d\n",wav_format.block_align);
           printf("  %d bits per sample\n",wav_format.sig_bps);
         }
-        if (chunk_size > sizeof(wav_format))
+// IMA-ADPCM extends the format chunk with cbSize and samples per block
+        if (wav_format.comp_code==WAVE_FORMAT_IMA_ADPCM && chunk_size >= sizeof(wav_format)+sizeof(adpcm_ext)) {
+          fread(adpcm_ext,sizeof(adpcm_ext),1,wavefile);
+          samples_per_block=adpcm_ext[1];
+          if (verbosity)
+            printf("  %d samples per block\n",samples_per_block);
+          if (chunk_size > sizeof(wav_format)+sizeof(adpcm_ext))
+            fseek(wavefile,chunk_size-sizeof(wav_format)-sizeof(adpcm_ext),SEEK_CUR);
+        }
+        else if (chunk_size > sizeof(wav_format))
           fseek(wavefile,chunk_size-sizeof(wav_format),SEEK_CUR);
         break;
+      case 0x74636166:
+// the fact chunk holds the true sample count, used to trim the last ADPCM block
+        fread(&fact_samples,4,1,wavefile);
+        if (verbosity)
+          printf("FACT chunk, %d samples\n",fact_samples);
+        if (chunk_size > 4)
+          fseek(wavefile,chunk_size-4,SEEK_CUR);
+        break;
       case 0x61746164:
-// allocate a buffer big enough to hold a slice
-        slice_buf=(char *)malloc(wav_format.block_align);
-        if (!slice_buf) {
-          printf("Unable to malloc slice buffer");
-          exit(1);
-        }
-        num_slices=chunk_size/wav_format.block_align;
-        samp_int=1000000/(wav_format.sample_rate);
-        if (verbosity) {
-          printf("DATA chunk\n");
-          printf("  chunk size %d (0x%x)\n",chunk_size,chunk_size);
-          printf("  %d slices\n",num_slices);
-          printf("  Ideal sample interval=%d\n",(unsigned)(1000000.0/wav_format.sample_rate));
-          printf("  programmed interrupt tick interval=%d\n",samp_int);
-        }
-
-// starting up ticker to write samples out -- no printfs until tick.detach is called
+        return chunk_size;
+      case 0x5453494c:
         if (verbosity)
-          tick.attach_us(this,&wave_player::dac_out, 500000); 
-        else
-          tick.attach_us(this,&wave_player::dac_out, samp_int); 
-        DAC_on=1; 
+          printf("INFO chunk, size %d\n",chunk_size);
+        fseek(wavefile,chunk_size,SEEK_CUR);
+        break;
+      default:
+        printf("unknown chunk type 0x%x, size %d\n",chunk_id,chunk_size);
+        data=fseek(wavefile,chunk_size,SEEK_CUR);
+        break;
+    }
+    fread(&chunk_id,4,1,wavefile);
+    fread(&chunk_size,4,1,wavefile);
+  }
+  return 0;
+}
 
-// start reading slices, which contain one sample each for however many channels
-// are in the wave file.  one channel=mono, two channels=stereo, etc.  Since
-// mbed only has a single AnalogOut, all of the channels present are averaged
-// to produce a single sample value.  This summing and averaging happens in
-// a variable of type signed long long, to make sure that the data doesn't
-// overflow regardless of sample size (8 bits, 16 bits, 32 bits).
+//-----------------------------------------------------------------------------
+// average the channels of one PCM slice and scale the result to an unsigned
+// 16 bit DAC value.
+//
+// The summing and averaging happens in a variable of type signed long long,
+// to make sure that the data doesn't overflow regardless of sample size (8
+// bits, 16 bits, 32 bits).
 //
 // note that from what I can find that 8 bit wave files use unsigned data,
 // while 16 and 32 bit wave files use signed data
-//
-        for (slice=0;slice<num_slices;slice+=1) {
-          fread(slice_buf,wav_format.block_align,1,wavefile);
-          if (feof(wavefile)) {
-            printf("Oops -- not enough slices in the wave file\n");
-            exit(1);
-          }
-          data_sptr=(short *)slice_buf;     // 16 bit samples
-          data_bptr=(unsigned char *)slice_buf;     // 8 bit samples
-          data_wptr=(int *)slice_buf;     // 32 bit samples
-          slice_value=0;
-          for (channel=0;channel<wav_format.num_channels;channel++) {
-            switch (wav_format.sig_bps) {
-              case 16:
-                if (verbosity)
-                  printf("16 bit channel %d data=%d ",channel,data_sptr[channel]);
-                slice_value+=data_sptr[channel];
+//-----------------------------------------------------------------------------
+unsigned short wave_player::pcm_to_dac(const char *slice)
+{
+        long long slice_value;
+        int channel;
+        const short *data_sptr=(const short *)slice;     // 16 bit samples
+        const unsigned char *data_bptr=(const unsigned char *)slice;     // 8 bit samples
+        const int *data_wptr=(const int *)slice;     // 32 bit samples
+  slice_value=0;
+  for (channel=0;channel<wav_format.num_channels;channel++) {
+    switch (wav_format.sig_bps) {
+      case 16:
+        if (verbosity)
+          printf("16 bit channel %d data=%d ",channel,data_sptr[channel]);
+        slice_value+=data_sptr[channel];
+        break;
+      case 32:
+        if (verbosity)
+          printf("32 bit channel %d data=%d ",channel,data_wptr[channel]);
+        slice_value+=data_wptr[channel];
+        break;
+      case 8:
+        if (verbosity)
+          printf("8 bit channel %d data=%d ",channel,(int)data_bptr[channel]);
+        slice_value+=data_bptr[channel];
+        break;
+    }
+  }
+  slice_value/=wav_format.num_channels;
+
+// slice_value is now averaged.  Next it needs to be scaled to an unsigned 16 bit value
+// with DC offset so it can be written to the DAC.
+  switch (wav_format.sig_bps) {
+    case 8:     slice_value<<=8;
                 break;
-              case 32:
-                if (verbosity)
-                  printf("32 bit channel %d data=%d ",channel,data_wptr[channel]);
-                slice_value+=data_wptr[channel];
+    case 16:    slice_value+=32768;
                 break;
-              case 8:
-                if (verbosity)
-                  printf("8 bit channel %d data=%d ",channel,(int)data_bptr[channel]);
-                slice_value+=data_bptr[channel];
+    case 32:    slice_value>>=16;
+                slice_value+=32768;
                 break;
-            }
-          }
+  }
+  return (unsigned short)slice_value;
+}
+
+//-----------------------------------------------------------------------------
+// player function.  Takes a pointer to an opened wave file.  The file needs
+// to be stored in a filesystem with enough bandwidth to feed the wave data.
+// LocalFileSystem isn't, but the SDcard is, at least for 22kHz files.  The
+// SDcard filesystem can be hotrodded by increasing the SPI frequency it uses
+// internally.  IMA-ADPCM files (compression code 0x11) need only a quarter of
+// the bandwidth of 16 bit PCM.
+//-----------------------------------------------------------------------------
+void wave_player::play(FILE *wavefile)
+{
+        unsigned chunk_size,samp_int;
+        int i,channel;
+        short unsigned dac_data;
+        long long slice_value;
+        char *slice_buf;
+        long slice,num_slices;
+        int block_samples;
+        long block;
+        short *pcm_buf;
+        unsigned dac_rate,play_start;
+  stop();
+  DAC_wptr=0;
+  DAC_rptr=0;
+  for (i=0;i<256;i+=2) {
+    DAC_fifo[i]=0;
+    DAC_fifo[i+1]=3000;
+  }
+  DAC_wptr=4;
+  DAC_on=0;
+  samples_per_block=0;
+  fact_samples=0;
+
+  while ((chunk_size=next_data_chunk(wavefile))) {
+// allocate a buffer big enough to hold a slice
+    slice_buf=(char *)malloc(wav_format.block_align);
+    if (!slice_buf) {
+      printf("Unable to malloc slice buffer");
+      exit(1);
+    }
+    num_slices=chunk_size/wav_format.block_align;     // blocks, for ADPCM
+    dac_rate=out_rate ? out_rate : wav_format.sample_rate;
+    samp_int=1000000/dac_rate;
+    resampler_init(&resampler,wav_format.sample_rate,dac_rate,32768);
+    if (verbosity) {
+      printf("DATA chunk\n");
+      printf("  chunk size %d (0x%x)\n",chunk_size,chunk_size);
+      printf("  %ld slices\n",num_slices);
+      printf("  Ideal sample interval=%d\n",(unsigned)(1000000.0/wav_format.sample_rate));
+      printf("  output rate %d, programmed interrupt tick interval=%d\n",dac_rate,samp_int);
+    }
+    isr_calls=0;
+    isr_us=0;
+    play_start=us_ticker_read();
+
+#if WAVE_PLAYER_DMA
+// the DMA starts by itself once two half buffers are full.  Verbose mode
+// keeps the slow Ticker so the ISR can print.
+    if (!verbosity) {
+      DMA_buf=dma.begin(dac_rate);
+      DMA_used=0;
+    }
+    else
+#endif
+    {
+// starting up ticker to write samples out -- no printfs until tick.detach is called
+      if (verbosity)
+        tick.attach_us(this,&wave_player::dac_out, 500000); 
+      else
+        tick.attach_us(this,&wave_player::dac_out, samp_int); 
+      DAC_on=1; 
+    }
+
+// IMA-ADPCM data is read a block at a time.  Each block of block_align bytes
+// decodes to samples_per_block slices, which are averaged across channels
+// just like the PCM slices below.
+    if (wav_format.comp_code==WAVE_FORMAT_IMA_ADPCM) {
+      samples_per_block=ima_adpcm_samples_per_block(wav_format.block_align,wav_format.num_channels);
+      pcm_buf=(short *)malloc(samples_per_block*wav_format.num_channels*sizeof(short));
+      if (!samples_per_block || wav_format.num_channels > 2 || !pcm_buf) {
+        printf("Unsupported ADPCM block size %d\n",wav_format.block_align);
+        exit(1);
+      }
+      slice=0;
+      for (block=0;block<num_slices;block+=1) {
+        fread(slice_buf,wav_format.block_align,1,wavefile);
+        if (feof(wavefile)) {
+          printf("Oops -- not enough blocks in the wave file\n");
+          exit(1);
+        }
+        block_samples=ima_adpcm_decode_block((unsigned char *)slice_buf,wav_format.block_align,
+                                             wav_format.num_channels,pcm_buf);
+// the last block is padded; the fact chunk says where the real samples end
+        if (fact_samples && slice+block_samples > (long)fact_samples)
+          block_samples=fact_samples-slice;
+        for (i=0;i<block_samples;i++) {
+          slice_value=0;
+          for (channel=0;channel<wav_format.num_channels;channel++)
+            slice_value+=pcm_buf[i*wav_format.num_channels+channel];
           slice_value/=wav_format.num_channels;
-          
-// slice_value is now averaged.  Next it needs to be scaled to an unsigned 16 bit value
-// with DC offset so it can be written to the DAC.
-          switch (wav_format.sig_bps) {
-            case 8:     slice_value<<=8;
-                        break;
-            case 16:    slice_value+=32768;
-                        break;
-            case 32:    slice_value>>=16;
-                        slice_value+=32768;
-                        break;
-          }
-          dac_data=(short unsigned)slice_value;
+          dac_data=(short unsigned)(slice_value+32768);
           if (verbosity)
-            printf("sample %d wptr %d slice_value %d dac_data %u\n",slice,DAC_wptr,(int)slice_value,dac_data);
-          DAC_fifo[DAC_wptr]=dac_data;
-          DAC_wptr=(DAC_wptr+1) & 0xff;
-          while (DAC_wptr==DAC_rptr) {
-          }
+            printf("sample %ld wptr %d slice_value %d dac_data %u\n",slice,DAC_wptr,(int)slice_value,dac_data);
+          output_sample(dac_data);
+          slice++;
         }
-        DAC_on=0;
-        tick.detach();
-        free(slice_buf);
-        break;
-      case 0x5453494c:
+      }
+      free(pcm_buf);
+    }
+    else {
+// start reading slices, which contain one sample each for however many channels
+// are in the wave file.  one channel=mono, two channels=stereo, etc.  Since
+// mbed only has a single AnalogOut, all of the channels present are averaged
+// to produce a single sample value.
+      for (slice=0;slice<num_slices;slice+=1) {
+        fread(slice_buf,wav_format.block_align,1,wavefile);
+        if (feof(wavefile)) {
+          printf("Oops -- not enough slices in the wave file\n");
+          exit(1);
+        }
+        dac_data=pcm_to_dac(slice_buf);
         if (verbosity)
-          printf("INFO chunk, size %d\n",chunk_size);
-        fseek(wavefile,chunk_size,SEEK_CUR);
-        break;
-      default:
-        printf("unknown chunk type 0x%x, size %d\n",chunk_id,chunk_size);
-        data=fseek(wavefile,chunk_size,SEEK_CUR);
+          printf("sample %ld wptr %d dac_data %u\n",slice,DAC_wptr,dac_data);
+        output_sample(dac_data);
+      }
+    }
+#if WAVE_PLAYER_DMA
+    if (DMA_buf) {
+      dma.finish(DMA_buf,DMA_used,32768);
+      DMA_buf=0;
+      wave_DAC->write_u16(32768);
+      isr_calls=dma.get_interrupts();
+      if (dma.get_underruns())
+        printf("wave_player: %d DMA underruns\n",dma.get_underruns());
+    }
+#endif
+    DAC_on=0;
+    tick.detach();
+    play_us=us_ticker_read()-play_start;
+    if (verbosity)
+      printf("  %d DAC interrupts, %d us of %d us in the ISR\n",isr_calls,isr_us,play_us);
+    free(slice_buf);
+  }
+}
+
+//-----------------------------------------------------------------------------
+// streaming.  start() parses the header and fills the prefetch ring, then
+// the DAC (DMA refill or Ticker) drains the ring while service() reads and
+// decodes a sector at a time from the main loop to keep it full.  The ring
+// absorbs FatFs cluster chain walks, SD busy time and slow main loop
+// iterations; get_stream_stats() shows how close it came to running dry.
+//-----------------------------------------------------------------------------
+#if defined(__ARMCC_VERSION)
+#define STREAM_RAM __attribute__((section("AHBSRAM1")))
+#else
+#define STREAM_RAM
+#endif
+
+static unsigned short stream_ring[WAVE_STREAM_RING] STREAM_RAM;
+
+int wave_player::start(FILE *wavefile, int loop)
+{
+        unsigned dac_rate,slices;
+  stop();
+  samples_per_block=0;
+  fact_samples=0;
+  stream_size=next_data_chunk(wavefile);
+  if (wav_format.num_channels < 1 || wav_format.block_align < 1 || stream_size < (unsigned)wav_format.block_align)
+    return 0;
+  if (wav_format.comp_code==WAVE_FORMAT_IMA_ADPCM) {
+    samples_per_block=ima_adpcm_samples_per_block(wav_format.block_align,wav_format.num_channels);
+    if (!samples_per_block || wav_format.num_channels > 2)
+      return 0;
+    stream_chunk=wav_format.block_align;
+    slices=samples_per_block;
+  }
+  else {
+// read whole sectors where the slices allow
+    stream_chunk=512-512 % wav_format.block_align;
+    if (stream_chunk==0)
+      stream_chunk=wav_format.block_align;
+    slices=stream_chunk/wav_format.block_align;
+  }
+  stream_buf=(char *)malloc(stream_chunk);
+  stream_pcm=samples_per_block ? (short *)malloc(samples_per_block*wav_format.num_channels*sizeof(short)) : 0;
+  if (!stream_buf || (samples_per_block && !stream_pcm)) {
+    free(stream_buf);
+    free(stream_pcm);
+    return 0;
+  }
+
+  dac_rate=out_rate ? out_rate : wav_format.sample_rate;
+  resampler_init(&resampler,wav_format.sample_rate,dac_rate,32768);
+// output samples one read can produce, plus the resampler's carry
+  stream_need=(unsigned)((unsigned long long)slices*dac_rate/wav_format.sample_rate)+2;
+  if (stream_need > WAVE_STREAM_RING) {
+    printf("wave_player: WAVE_STREAM_RING too small to stream\n");
+    free(stream_buf);
+    free(stream_pcm);
+    return 0;
+  }
+
+  stream_file=wavefile;
+  stream_loop=loop;
+  stream_data=ftell(wavefile);
+  stream_left=stream_size;
+  stream_slice=0;
+  stream_wr=0;
+  stream_rd=0;
+  stream_tail=0;
+  stream_hold=32768;
+  stream_dry=0;
+  stream_eof=0;
+  memset(&stream_stats,0,sizeof(stream_stats));
+  stream_stats.low_water=WAVE_STREAM_RING;
+  streaming=1;
+
+  service(WAVE_STREAM_RING);
+#if WAVE_PLAYER_DMA
+  dma.start(dac_rate,&wave_player::stream_refill,this);
+#else
+  tick.attach_us(this,&wave_player::dac_out,1000000/dac_rate);
+#endif
+  return 1;
+}
+
+int wave_player::service(int max_reads)
+{
+        unsigned n,got,slices,start_us,read_us;
+        int i,block_samples,channel;
+        long long slice_value;
+  if (!streaming)
+    return 0;
+  while (max_reads-- > 0 && !stream_eof && WAVE_STREAM_RING-(stream_wr-stream_rd) >= stream_need) {
+    if (stream_left < (unsigned)wav_format.block_align) {
+      if (!stream_loop) {
+        stream_eof=1;
         break;
+      }
+// the resampler carries on across the loop point, so there is no click
+      fseek(stream_file,stream_data,SEEK_SET);
+      stream_left=stream_size;
+      stream_slice=0;
     }
-    fread(&chunk_id,4,1,wavefile);
-    fread(&chunk_size,4,1,wavefile);
+    n=stream_chunk < stream_left ? stream_chunk : stream_left;
+    start_us=us_ticker_read();
+    got=fread(stream_buf,1,n,stream_file);
+    read_us=us_ticker_read()-start_us;
+    stream_stats.reads++;
+    if (read_us > stream_stats.max_read_us)
+      stream_stats.max_read_us=read_us;
+// a short read means the data chunk is truncated; treat it as the end
+    stream_left=got < n ? 0 : stream_left-n;
+    if (wav_format.comp_code==WAVE_FORMAT_IMA_ADPCM) {
+      if (got < stream_chunk)
+        continue;
+      block_samples=ima_adpcm_decode_block((unsigned char *)stream_buf,wav_format.block_align,
+                                           wav_format.num_channels,stream_pcm);
+      if (fact_samples && stream_slice+block_samples > fact_samples)
+        block_samples=fact_samples-stream_slice;
+      for (i=0;i<block_samples;i++) {
+        slice_value=0;
+        for (channel=0;channel<wav_format.num_channels;channel++)
+          slice_value+=stream_pcm[i*wav_format.num_channels+channel];
+        slice_value/=wav_format.num_channels;
+        output_sample((unsigned short)(slice_value+32768));
+      }
+      stream_slice+=block_samples;
+    }
+    else {
+      slices=got/wav_format.block_align;
+      for (i=0;i<(int)slices;i++)
+        output_sample(pcm_to_dac(stream_buf+i*wav_format.block_align));
+    }
+  }
+// give the DAC time to play out what it already holds before stopping
+  if (stream_eof && stream_wr==stream_rd && stream_tail >= 2*DAC_DMA_HALF) {
+    stop();
+    return 0;
   }
+  return 1;
+}
+
+void wave_player::stop(void)
+{
+  if (!streaming)
+    return;
+#if WAVE_PLAYER_DMA
+  dma.stop();
+#endif
+  tick.detach();
+  streaming=0;
+  wave_DAC->write_u16(32768);
+  free(stream_buf);
+  free(stream_pcm);
+  stream_buf=0;
+  stream_pcm=0;
 }
 
+void wave_player::get_stream_stats(WAVE_STREAM_STATS *stats)
+{
+  *stats=stream_stats;
+}
+
+//-----------------------------------------------------------------------------
+// take the next sample from the prefetch ring.  Called from the DAC refill
+// (DMA or Ticker interrupt).  When the ring is dry the last sample is held,
+// which is quieter than jumping to the idle level.
+//-----------------------------------------------------------------------------
+unsigned short wave_player::stream_next(void)
+{
+  if (stream_rd != stream_wr) {
+    stream_hold=stream_ring[stream_rd & (WAVE_STREAM_RING-1)];
+    stream_rd++;
+    stream_dry=0;
+  }
+  else if (stream_eof)
+    stream_tail++;
+  else {
+    if (!stream_dry)
+      stream_stats.underruns++;
+    stream_dry=1;
+    stream_stats.starved++;
+  }
+  return stream_hold;
+}
+
+void wave_player::stream_refill(void *context, uint32_t *half)
+{
+  wave_player *w=(wave_player *)context;
+  unsigned level=w->stream_wr-w->stream_rd;
+  int i;
+  if (level < w->stream_stats.low_water)
+    w->stream_stats.low_water=level;
+  for (i=0;i<DAC_DMA_HALF;i++)
+    half[i]=dac_dma::to_dacr(w->stream_next());
+}
+
+//-----------------------------------------------------------------------------
+// convert one sample at the file's rate into zero or more samples at the DAC
+// rate.  When the rates match the sample goes straight to the FIFO.
+//-----------------------------------------------------------------------------
+void wave_player::output_sample(unsigned short dac_data)
+{
+  int out;
+  if (resampler.step==RESAMPLER_ONE) {
+    fifo_put(dac_data);
+    return;
+  }
+  resampler_push(&resampler,dac_data);
+  while (resampler_pop(&resampler,&out))
+    fifo_put((unsigned short)out);
+}
+
+//-----------------------------------------------------------------------------
+// put one sample into the DAC FIFO (or the DMA half buffer), waiting for the
+// ISR or the DMA to make room
+//-----------------------------------------------------------------------------
+void wave_player::fifo_put(unsigned short dac_data)
+{
+  if (streaming) {
+// service() has checked there is room
+    stream_ring[stream_wr & (WAVE_STREAM_RING-1)]=dac_data;
+    stream_wr++;
+    return;
+  }
+#if WAVE_PLAYER_DMA
+  if (DMA_buf) {
+    DMA_buf[DMA_used++]=dac_dma::to_dacr(dac_data);
+    if (DMA_used==DAC_DMA_HALF) {
+      DMA_buf=dma.swap();
+      DMA_used=0;
+    }
+    return;
+  }
+#endif
+  DAC_fifo[DAC_wptr]=dac_data;
+  DAC_wptr=(DAC_wptr+1) & 0xff;
+  while (DAC_wptr==DAC_rptr) {
+  }
+}
 
 void wave_player::dac_out()
 {
-  if (DAC_on) {
+  unsigned start=us_ticker_read();
+  if (streaming) {
+    if (stream_wr-stream_rd < stream_stats.low_water)
+      stream_stats.low_water=stream_wr-stream_rd;
+    wave_DAC->write_u16(stream_next());
+  }
+  else if (DAC_on) {
 #ifdef VERBOSE
   printf("ISR rdptr %d got %u\n",DAC_rptr,DAC_fifo[DAC_rptr]);
 #endif
     wave_DAC->write_u16(DAC_fifo[DAC_rptr]);
     DAC_rptr=(DAC_rptr+1) & 0xff;
   }
+  isr_calls++;
+  isr_us+=us_ticker_read()-start;
 }
 
@@ -1,4 +1,21 @@
 #include <mbed.h>
+#include "resampler.h"
+#include "dac_dma.h"
+
+// default DAC output rate in Hz, see wave_player::set_output_rate
+#define WAVE_OUTPUT_RATE 16000
+
+// 1: feed the DAC from ping-pong DMA buffers (no per-sample interrupt)
+// 0: write every sample from a Ticker interrupt
+#ifndef WAVE_PLAYER_DMA
+#define WAVE_PLAYER_DMA 1
+#endif
+
+// samples decoded ahead of the DAC while streaming, a power of 2.  2048 is
+// 128ms at 16kHz, or about 11 sectors of 16 bit mono 22kHz data.
+#ifndef WAVE_STREAM_RING
+#define WAVE_STREAM_RING 2048
+#endif
 
 typedef struct uFMT_STRUCT {
   short comp_code;
@@ -9,8 +26,20 @@ typedef struct uFMT_STRUCT {
   short sig_bps;
 } FMT_STRUCT;
 
+/** Streaming statistics, see wave_player::get_stream_stats. */
+typedef struct {
+  unsigned underruns;    ///< times the prefetch ring ran dry
+  unsigned starved;      ///< samples the DAC repeated while it was dry
+  unsigned low_water;    ///< fewest samples left in the ring at a DAC refill
+  unsigned reads;        ///< file reads made by service()
+  unsigned max_read_us;  ///< slowest single read (cluster walks, SD busy)
+} WAVE_STREAM_STATS;
+
 
 /** wave file player class.
+ *
+ * Plays PCM (8, 16 or 32 bit) and IMA-ADPCM (compression code 0x11) wave
+ * files.  ADPCM files can be made with tools/wav2adpcm.
  *
  * Example:
  * @code
@@ -45,6 +74,37 @@ wave_player(AnalogOut *_dac);
  */
 void play(FILE *wavefile);
 
+/** Start streaming a wave file in the background, e.g. music during the
+ * game.  The call returns once the prefetch ring is full; after that the
+ * DAC runs from the ring and service() must be called regularly to keep it
+ * topped up.  The file must stay open until stop().  Calling play() stops
+ * the stream.
+ *
+ * @param wavefile A pointer to an opened wave file
+ * @param loop nonzero to restart at the beginning of the data at the end
+ * @return 0 if the file can't be streamed
+ */
+int start(FILE *wavefile, int loop);
+
+/** Read and decode file data until the prefetch ring is full.  Each read is
+ * a sector's worth of data (or one ADPCM block).
+ *
+ * @param max_reads upper bound on reads in this call, to bound its time
+ * @return 1 while streaming, 0 once a non-looping stream has played out
+ */
+int service(int max_reads);
+
+/** Stop streaming and idle the DAC. */
+void stop(void);
+
+/** Report prefetch statistics for the current or last stream.  If
+ * underruns grows, call service() more often, allow it more reads or
+ * increase WAVE_STREAM_RING; low_water shows how much margin is left.
+ *
+ * @param stats receives the counters
+ */
+void get_stream_stats(WAVE_STREAM_STATS *stats);
+
 /** Set the printf verbosity of the wave player.  A nonzero verbosity level
  * will put wave_player in a mode where the complete contents of the wave
  * file are echoed to the screen, including header values, and including
@@ -58,15 +118,73 @@ void play(FILE *wavefile);
  */
 void set_verbosity(int v);
 
+/** Set the rate at which samples are written to the DAC.  Files at other
+ * rates are linearly resampled while they are read, so the DAC interrupt
+ * rate no longer depends on the file.  A 44.1kHz file would otherwise
+ * interrupt the game loop every 22us.
+ *
+ * @param hz output rate in Hz (default WAVE_OUTPUT_RATE), or 0 to play
+ * every file at its own sample rate
+ */
+void set_output_rate(unsigned hz);
+
+/** Report DAC interrupt statistics for the last call to play().
+ *
+ * With WAVE_PLAYER_DMA there is one interrupt per DAC_DMA_HALF samples and
+ * busy_us is not measured.
+ *
+ * @param calls receives the number of DAC interrupts
+ * @param busy_us receives the time spent inside the interrupt handler
+ * @param p_us receives the length of the data chunk playback
+ */
+void get_isr_stats(unsigned *calls, unsigned *busy_us, unsigned *p_us);
+
 private:
+unsigned next_data_chunk(FILE *wavefile);
+unsigned short pcm_to_dac(const char *slice);
 void dac_out(void);
+void fifo_put(unsigned short dac_data);
+void output_sample(unsigned short dac_data);
+unsigned short stream_next(void);
+static void stream_refill(void *context, uint32_t *half);
 int verbosity;
+FMT_STRUCT wav_format;
+int samples_per_block;
+unsigned fact_samples;
+unsigned out_rate;
+RESAMPLER resampler;
+volatile unsigned isr_calls;
+volatile unsigned isr_us;
+unsigned play_us;
+#if WAVE_PLAYER_DMA
+dac_dma dma;
+uint32_t *DMA_buf;
+int DMA_used;
+#endif
 AnalogOut *wave_DAC;
 Ticker tick;
 unsigned short DAC_fifo[256];
 short DAC_wptr;
 volatile short DAC_rptr;
 short DAC_on;
+volatile int streaming;
+FILE *stream_file;
+int stream_loop;
+long stream_data;               // file offset of the data chunk
+unsigned stream_size;           // and its size
+unsigned stream_left;           // bytes of it not yet read
+unsigned stream_chunk;          // bytes per read
+unsigned stream_need;           // ring space one read may use
+unsigned stream_slice;
+char *stream_buf;
+short *stream_pcm;
+volatile unsigned stream_wr;
+volatile unsigned stream_rd;
+volatile unsigned stream_tail;  // idle samples output after the end
+unsigned short stream_hold;
+int stream_dry;
+int stream_eof;
+WAVE_STREAM_STATS stream_stats;
 };
 
 